@@ -7,15 +7,20 @@
 #include "AmpIORevision.h"
 #include "AmpIO.h"
 #include "EthUdpPort.h"
+#include "SimPort.h"
 
 #if Amp1394_HAS_RAW1394
   #include "FirewirePort.h"
 #endif
 
-#if Amp1394_HAS_PCAP
+#if Amp1394_HAS_ETH_RAW
   #include "EthRawPort.h"
 #endif
 
+#if Amp1394_HAS_XDP
+  #include "EthXdpPort.h"
+#endif
+
 #ifdef _MSC_VER
 #include <stdlib.h>
 inline uint16_t bswap_16(uint16_t data) { return _byteswap_ushort(data); }
@@ -159,7 +164,9 @@ uint32_t bswap32(uint32_t in);
 
 %include "Amp1394Types.h"
 %include "EncoderVelocity.h"
+%include "LatencyHistogram.h"
 %include "BoardIO.h"
+%include "FeedbackSnapshot.h"
 %include "FpgaIO.h"
 %include "AmpIO.h"
 
@@ -170,9 +177,13 @@ uint32_t bswap32(uint32_t in);
 %include "BasePort.h"
 %include "EthBasePort.h"
 %include "EthUdpPort.h"
+%include "SimPort.h"
 #if Amp1394_HAS_RAW1394
   %include "FirewirePort.h"
 #endif
-#if Amp1394_HAS_PCAP
+#if Amp1394_HAS_ETH_RAW
   %include "EthRawPort.h"
 #endif
+#if Amp1394_HAS_XDP
+  %include "EthXdpPort.h"
+#endif
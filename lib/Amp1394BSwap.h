@@ -32,4 +32,11 @@ inline uint32_t bswap_32(uint32_t data) { return _byteswap_ulong(data); }
 #include <byteswap.h>
 #endif
 
+// Byteswap a block of quadlets (dst and src can be the same). This uses SIMD instructions
+// when available (SSE2 or AVX2 on x86-64, selected at runtime, and NEON on ARM).
+void Amp1394_BSwapBlock(uint32_t *dst, const uint32_t *src, unsigned int numQuads);
+
+// Returns the name of the implementation used by Amp1394_BSwapBlock (e.g., "avx2")
+const char *Amp1394_GetBSwapBlockName(void);
+
 #endif
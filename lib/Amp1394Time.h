@@ -16,15 +16,28 @@ http://www.cisst.org/cisst/license.txt.
 // These are simple cross-platform implementations to get the current time (in seconds) and
 // to sleep for a specified number of seconds. They are based on the implementations from
 // osaGetTime and osaSleep in cisstOSAbstraction.
+//
+// The time is obtained from a monotonic clock (CLOCK_MONOTONIC_RAW on Linux, the performance
+// counter on Windows), so it is not affected by changes to the system (wall-clock) time, and
+// only differences between times are meaningful. If the library is built with Amp1394_USE_TSC
+// (x86-64 only), the CPU time-stamp counter is used instead, calibrated against the monotonic
+// clock when the library is loaded; this is only done if the processor has an invariant TSC.
 
 #ifndef __AMP1394TIME_H__
 #define __AMP1394TIME_H__
 
+#include "Amp1394Types.h"
+
 // Return the time in seconds
 double Amp1394_GetTime(void);
 
+// Return the time in nanoseconds (same clock as Amp1394_GetTime)
+int64_t Amp1394_GetTimeNs(void);
+
+// Return the name of the clock used by Amp1394_GetTime (e.g., "CLOCK_MONOTONIC_RAW" or "TSC")
+const char *Amp1394_GetClockName(void);
+
 // Sleep for the desired number of seconds
 void Amp1394_Sleep(double sec);
 
 #endif
-
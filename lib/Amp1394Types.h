@@ -26,6 +26,7 @@ typedef unsigned __int32 uint32_t;
 typedef unsigned __int64 uint64_t;
 typedef  __int16         int16_t;
 typedef __int32          int32_t;
+typedef __int64          int64_t;
 #else
 #include <stdint.h>
 #endif
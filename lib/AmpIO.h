@@ -159,6 +159,36 @@ public:
     /*! Returns midrange value of encoder position. */
     static int32_t GetEncoderMidRange(void);
 
+    //********************** Bulk feedback (all axes) *****************************
+
+    /*! Decodes the feedback of all axes of this board in one pass. Each array can be 0 if not
+        needed; positions (counts) and velocities (predicted, counts/sec) must have room for
+        NumEncoders values and currents and pots (raw ADC values) for NumMotors values.
+        Returns false (and does not modify the arrays) if the read data is not valid. */
+    bool GetAxisFeedback(int32_t *positions, double *velocities, uint32_t *currents, uint32_t *pots,
+                         double percent_threshold = 1.0) const;
+
+    /*! Returns the number of entries needed in each array for GetAxisFeedbackAll, which is the
+        sum of max(NumMotors, NumEncoders) over all AmpIO boards on the port. */
+    static unsigned int GetNumAxesAll(const BasePort *port);
+
+    /*! Decodes the feedback of all axes of all AmpIO boards on the port into contiguous arrays
+        (see GetAxisFeedback), in increasing order of board number. Each board uses
+        max(NumMotors, NumEncoders) consecutive entries of every array; entries that do not exist
+        on a board (e.g., encoders 7-9 on a dRA1), or that belong to a board without valid read
+        data, are set to 0. Returns the number of entries written, or 0 if maxAxes is too small. */
+    static unsigned int GetAxisFeedbackAll(const BasePort *port, int32_t *positions, double *velocities,
+                                           uint32_t *currents, uint32_t *pots, unsigned int maxAxes,
+                                           double percent_threshold = 1.0);
+
+    /*! Same as above, for the specified list of boards (in the specified order). This avoids the
+        dynamic_cast of each board on the port, so it is faster if the caller already has the list.
+        Null entries in the list are skipped. */
+    static unsigned int GetAxisFeedbackAll(const AmpIO * const *boards, unsigned int numBoards,
+                                           int32_t *positions, double *velocities,
+                                           uint32_t *currents, uint32_t *pots, unsigned int maxAxes,
+                                           double percent_threshold = 1.0);
+
     /*! Returns the encoder acceleration in counts per second**2, based on the scaled difference
         between the most recent full cycle and the previous full cycle. If the encoder counter overflowed
         (i.e., velocity was very slow or zero), the acceleration is set to 0. Since velocity is averaged
@@ -675,6 +705,25 @@ protected:
     // this buffer, while also byteswapping if needed.
     quadlet_t WriteBuffer[WriteBufSize_Max];
 
+    // Layout of the real-time read and write data, which depends on the hardware and firmware
+    // versions. It is computed by InitBoard (i.e., when the board is added to a port), so that
+    // the real-time methods (SetReadData, GetReadNumBytes, and the Get/Set methods that access
+    // ReadBuffer or WriteBuffer) do not need to obtain these versions from the port.
+    typedef void (AmpIO::*DecodeVelocityMethod)(void);
+    typedef void (AmpIO::*DecodeReadMethod)(const quadlet_t *buf);
+    typedef void (AmpIO::*EncodeWriteMethod)(quadlet_t *buf) const;
+    struct RealtimeLayout {
+        uint32_t fwVersion;            // Firmware version
+        uint32_t hwVersion;            // Hardware version (e.g., QLA1_String)
+        unsigned int readNumQuads;     // Size of real-time read data (quadlets)
+        unsigned int writeNumQuads;    // Size of real-time write data (quadlets)
+        double encClockPeriod;         // Clock period for encoder velocity measurement (seconds)
+        DecodeVelocityMethod decodeVelocity;   // Extracts velocity data for all encoders
+        DecodeReadMethod decodeRead;           // Byteswaps read data and extracts velocity data
+        EncodeWriteMethod encodeWrite;         // Copies (with byteswap) the complete write buffer
+    };
+    RealtimeLayout layout;
+
     // Encoder velocity data (per axis)
     EncoderVelocity encVelData[MAX_CHANNELS];
 
@@ -727,6 +776,27 @@ protected:
     /*! Extract the data used for velocity estimation */
     bool SetEncoderVelocityData(unsigned int index);
 
+    // Extract the data used for velocity estimation for all encoders, for the different
+    // firmware versions (see RealtimeLayout::decodeVelocity)
+    void DecodeVelocityOld(void);     // Firmware Rev 1-5
+    void DecodeVelocityRev6(void);    // Firmware Rev 6
+    void DecodeVelocityRev7(void);    // Firmware Rev 7+
+
+    // Decoding of the real-time read data (byteswap and velocity data), for any hardware and
+    // firmware version, using the offsets computed by InitBoard
+    void DecodeReadGeneric(const quadlet_t *buf);
+
+    // Decoding of the real-time read data for Firmware Rev 7+, with the number of motors and
+    // encoders known at compile time, so that the offsets are constants and the per-channel loops
+    // can be unrolled. InitBoard selects the instance for QLA1 (Rev 7 and 8), DQLA and dRA1.
+    template <unsigned int NUM_MOTORS, unsigned int NUM_ENCODERS, bool HAS_MOTOR_STATUS, bool IS_ESPM>
+    void DecodeReadFixed(const quadlet_t *buf);
+
+    // Copy (with byteswap) of the complete write buffer
+    void EncodeWriteGeneric(quadlet_t *buf) const;
+    template <unsigned int NUM_QUADS>
+    void EncodeWriteFixed(quadlet_t *buf) const;
+
     /*! \brief If user-supplied callback is not NULL, read data collection buffer and then call callback.
         \note Called by relevant Port class.
     */
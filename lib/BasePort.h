@@ -21,6 +21,9 @@ http://www.cisst.org/cisst/license.txt.
 #include <iostream>
 #include <vector>
 #include "BoardIO.h"
+#include "LatencyHistogram.h"
+#include "FeedbackSnapshot.h"
+#include "PortRequest.h"
 
 /*
  * BasePort
@@ -78,7 +81,7 @@ public:
 
     enum { MAX_NODES = 64 };     // maximum number of nodes (IEEE-1394 limit)
 
-    enum PortType { PORT_FIREWIRE, PORT_ETH_UDP, PORT_ETH_RAW, PORT_ZYNQ_EMIO };
+    enum PortType { PORT_FIREWIRE, PORT_ETH_UDP, PORT_ETH_RAW, PORT_ZYNQ_EMIO, PORT_SIM, PORT_ETH_XDP };
 
     // Protocol types:
     //   PROTOCOL_SEQ_RW      sequential (individual) read and write to each board
@@ -86,6 +89,13 @@ public:
     //   PROTOCOL_BC_QRW      broadcast query, read, and write to/from all boards
     enum ProtocolType { PROTOCOL_SEQ_RW, PROTOCOL_SEQ_R_BC_W, PROTOCOL_BC_QRW };
 
+    // Wait strategy for WaitBroadcastRead:
+    //   BC_WAIT_FIXED      sleep for a fixed, port-specific time (default)
+    //   BC_WAIT_ADAPTIVE   wait until the hub data is expected to be ready, using the hub fill time
+    //                      learned from the broadcast read timing (Firmware Rev 7+). Short waits are
+    //                      done by spinning on the clock, to avoid oversleeping.
+    enum BroadcastWaitType { BC_WAIT_FIXED, BC_WAIT_ADAPTIVE };
+
     // Information about broadcast read.
     // With Firmware V7+, each FPGA starts a timer when it receives the broadcast query command
     // sent by the host PC. The following times are relative to this timer.
@@ -110,6 +120,31 @@ public:
         void PrintTiming(std::ostream &outStr, bool newLine = true) const;
     };
 
+    // Latency statistics for the real-time read (ReadAllBoards, ReadAllBoardsBroadcast and the
+    // split-phase read) and write (WriteAllBoards, WriteAllBoardsBroadcast). Each is divided into:
+    //   LATENCY_SEND      sending the request(s): broadcast query, or batched sequential read
+    //                     requests; for write, sending the block or broadcast write
+    //   LATENCY_WAIT      from end of send to start of receive (e.g., WaitBroadcastRead, or the
+    //                     application's work between StartReadAllBoards and FinishReadAllBoards)
+    //   LATENCY_RECEIVE   receiving the data (for non-batched sequential reads, includes sending
+    //                     the requests); not used for write
+    //   LATENCY_PROCESS   processing the data (e.g., BoardIO::SetReadData), or for write, building
+    //                     the packet(s) and post-processing (including separate quadlet writes for
+    //                     firmware prior to Rev 7)
+    //   LATENCY_TOTAL     total time (from the start of the request to the end of processing)
+    enum LatencyPath { LATENCY_READ, LATENCY_WRITE, LATENCY_NUM_PATHS };
+    enum LatencyStage { LATENCY_SEND, LATENCY_WAIT, LATENCY_RECEIVE, LATENCY_PROCESS, LATENCY_TOTAL,
+                        LATENCY_NUM_STAGES };
+
+    struct LatencySnapshot {
+        LatencyHistogram hist[LATENCY_NUM_PATHS][LATENCY_NUM_STAGES];
+        double elapsedTime;           // Time (seconds) since statistics were last reset
+
+        LatencySnapshot() : elapsedTime(0.0) {}
+        ~LatencySnapshot() {}
+        void Print(std::ostream &outStr) const;
+    };
+
 protected:
     // Stream for debugging output (default is std::cerr)
     std::ostream &outStr;
@@ -147,6 +182,19 @@ protected:
     // Memory for generic use
     unsigned char *GenericBuffer;
 
+    // Memory for batched sequential reads and writes (see ReadBlockMultiple and WriteBlockMultiple).
+    // There is one slot per board, and each slot is large enough for a complete packet, including
+    // the port-specific prefix and postfix. Each slot starts on a cache line (SLOT_ALIGN), so that
+    // the response of each board is received directly into its own cache lines and then decoded
+    // from there by BoardIO::SetReadData.
+    enum { SLOT_ALIGN = 64 };
+    unsigned char *ReadBufferBoards;    // Aligned to SLOT_ALIGN
+    unsigned char *WriteBufferBoards;   // Aligned to SLOT_ALIGN
+    unsigned char *ReadBoardsMem;       // Allocated memory for ReadBufferBoards
+    unsigned char *WriteBoardsMem;      // Allocated memory for WriteBufferBoards
+    size_t ReadSlotSize;            // Size of each slot in ReadBufferBoards, in bytes (multiple of SLOT_ALIGN)
+    size_t WriteSlotSize;           // Size of each slot in WriteBufferBoards, in bytes (multiple of SLOT_ALIGN)
+
     // For debugging
     bool rtWrite;
     bool rtRead;
@@ -154,6 +202,87 @@ protected:
     // Information about broadcast read
     BroadcastReadInfo bcReadInfo;
 
+    // Layout of the hub data for broadcast read, which only depends on the boards in use and their
+    // firmware versions. It is updated by UpdateBroadcastReadPlan when the configuration changes
+    // (ScanNodes, SetProtocol, AddBoard, RemoveBoard), rather than on every broadcast read.
+    struct BroadcastReadPlan {
+        unsigned int hubReadSize;     // Number of quadlets to read from the hub
+        unsigned int timingOffset;    // Offset of the timing quadlet (Rev 7+)
+        unsigned int offset[BoardIO::MAX_BOARDS];     // Offset of each board's block (quadlets)
+        unsigned int blockSize[BoardIO::MAX_BOARDS];  // Expected size of each board's block (quadlets)
+        bool sizeOK;                  // false if hubReadSize exceeds GetMaxReadDataSize
+
+        BroadcastReadPlan() : hubReadSize(0), timingOffset(0), sizeOK(false)
+        { for (unsigned int i = 0; i < BoardIO::MAX_BOARDS; i++) { offset[i] = 0; blockSize[i] = 0; } }
+        ~BroadcastReadPlan() {}
+    };
+    BroadcastReadPlan bcReadPlan;
+
+    // State of split-phase read (see StartReadAllBoards and FinishReadAllBoards)
+    struct PendingReadInfo {
+        bool active;              // true if read was started, but not yet finished
+        bool broadcast;           // true for broadcast read, false for sequential read
+        bool requestsSent;        // true if StartReadBlockMultiple sent the (sequential) read requests
+        unsigned int num;         // number of entries in following arrays (sequential read)
+        unsigned char boardList[BoardIO::MAX_BOARDS];
+        quadlet_t *rdata[BoardIO::MAX_BOARDS];
+        unsigned int nbytes[BoardIO::MAX_BOARDS];
+        bool ok[BoardIO::MAX_BOARDS];
+
+        PendingReadInfo() : active(false), broadcast(false), requestsSent(false), num(0) {}
+        ~PendingReadInfo() {}
+    };
+    PendingReadInfo pendingRead;
+
+    // Adaptive broadcast wait (see BroadcastWaitType)
+    BroadcastWaitType bcWaitMode;
+    double bcWaitTime;              // Learned wait time (seconds); 0 if not yet initialized
+    double bcWaitUsed;              // Wait time used for the last broadcast read (seconds)
+    double bcRequestTime;           // When the last broadcast read request was sent (Amp1394_GetTime)
+
+    // Latency statistics (see LatencyStage), only accessed by the thread doing the real-time I/O
+    LatencyHistogram latencyHist[LATENCY_NUM_PATHS][LATENCY_NUM_STAGES];
+    bool latencyEnabled;
+    volatile int latencyResetRequested;   // Set (atomically) by ResetLatencyStats, handled by RecordLatency
+    int64_t latencyResetTime;       // When the statistics were last reset (Amp1394_GetTimeNs)
+
+    // Copy of the latency statistics published by RecordLatency for other threads (see
+    // GetLatencySnapshot), using a double-buffered seqlock (as FeedbackBuffer)
+    struct LatencyPublished {
+        LatencyHistogram hist[LATENCY_NUM_PATHS][LATENCY_NUM_STAGES];
+        int64_t resetTime;
+    };
+    LatencyPublished latencyPub[2];
+    volatile uint32_t latencyPubSeq[2];   // Per-buffer sequence (odd while being written)
+    volatile uint32_t latencyPubLatest;   // Index of the most recently published buffer
+    int64_t latReadStart;           // When the current read was started (ns)
+    int64_t latReadSent;            // When the read request(s) of the current read were sent (ns)
+
+    // Returns the current time (Amp1394_GetTimeNs) if latency statistics are enabled, 0 otherwise
+    int64_t GetLatencyTime(void) const;
+
+    // Record the duration (ns) of each stage of a read or write; a negative duration indicates
+    // that the stage was not performed.
+    void RecordLatency(LatencyPath path, int64_t send, int64_t wait, int64_t receive,
+                       int64_t process, int64_t total);
+
+    // Feedback data published after each real-time read (see GetFeedbackSnapshot)
+    FeedbackBuffer feedbackBuffer;
+    bool feedbackEnabled;
+    FeedbackSnapshot *feedbackSnap;  // Snapshot being written (0 if not publishing)
+    double cycleTimestamp;           // Timestamp for published feedback (0 to use current time)
+
+    // Register accesses requested by other threads (see QueueRequest)
+    PortRequestQueue requestQueue;
+    unsigned int requestsPerCycle;   // Number of requests processed by each real-time write
+
+    // Publish the feedback data: BeginPublishFeedback (before processing the read data),
+    // PublishBoardFeedback (for each board read successfully), EndPublishFeedback (at end).
+    // These do nothing if publishing is not enabled.
+    void BeginPublishFeedback(void);
+    void PublishBoardFeedback(unsigned int boardNum, const quadlet_t *data);
+    void EndPublishFeedback(void);
+
     // Firmware versions
     unsigned long FirmwareVersion[BoardIO::MAX_BOARDS];
 
@@ -196,12 +325,61 @@ protected:
     void SetReadBufferBroadcast(void);
     void SetWriteBufferBroadcast(void);
 
+    // Following method initializes (or enlarges) the per-board slots used for batched
+    // sequential reads and writes. Called by AddBoard.
+    void SetBoardBuffers(void);
+
+    // Return pointer to the data section of the read (write) slot for the specified board
+    quadlet_t *GetReadSlotData(unsigned int boardNum) const
+    { return reinterpret_cast<quadlet_t *>(ReadBufferBoards + boardNum*ReadSlotSize + GetReadQuadAlign()
+                                           + GetPrefixOffset(RD_FW_BDATA)); }
+    quadlet_t *GetWriteSlotData(unsigned int boardNum) const
+    { return reinterpret_cast<quadlet_t *>(WriteBufferBoards + boardNum*WriteSlotSize + GetWriteQuadAlign()
+                                           + GetPrefixOffset(WR_FW_BDATA)); }
+
+    // Return pointer to the start of the packet in the read slot whose data section is rdata
+    // (see GetReadSlotData), or 0 if rdata is not in a read slot or nbytes does not fit in the slot.
+    // Used by ReadBlockNode to receive directly into the slot.
+    unsigned char *GetReadSlotPacket(const quadlet_t *rdata, unsigned int nbytes) const;
+
     // Return expected size for broadcast read, in bytes
     unsigned int GetBroadcastReadSize(void) const;
 
+    // Compute bcReadPlan from the current configuration
+    void UpdateBroadcastReadPlan(void);
+
     // Convenience function
     void SetReadInvalid(void);
 
+    // Wait for broadcast read data when bcWaitMode is BC_WAIT_ADAPTIVE; fixedWait is the port's
+    // fixed wait time (seconds), which is used until the hub fill time has been learned.
+    // Returns false (without waiting) if bcWaitMode is BC_WAIT_FIXED.
+    bool WaitBroadcastReadAdaptive(double fixedWait);
+
+    // Fixed (port-specific) time to wait for broadcast read data, in seconds
+    virtual double GetBroadcastReadWait(void) const { return 0.0; }
+
+    // First and second halves of ReadAllBoards (sequential protocols) and ReadAllBoardsBroadcast.
+    // The Start methods send the read request(s) and the Finish methods receive and process the data.
+    bool StartReadSequential(void);
+    bool FinishReadSequential(void);
+    bool StartReadBroadcast(void);
+    bool FinishReadBroadcast(void);
+
+    // Increment bcReadInfo.readSequence (16 bits, 0 is skipped)
+    void NextBroadcastReadSequence(void);
+
+    // Body of WriteAllBoardsBroadcast. If sendReadRequest is true, the broadcast read request is sent
+    // together with the broadcast write (see WriteBroadcastOutputAndReadRequest) and the read is left
+    // pending, as with StartReadBroadcast; this is used by WriteReadAllBoards.
+    bool WriteBroadcastCycle(bool sendReadRequest);
+
+    // Update the learned wait time from bcReadInfo; called by ReadAllBoardsBroadcast.
+    // seqError indicates whether any board returned stale data (wrong sequence number), in which
+    // case the wait is increased. dataOK indicates whether all boards were read successfully; the
+    // wait is not changed for other failures (e.g., board mismatch or size error).
+    void UpdateBroadcastWait(bool seqError, bool dataOK);
+
     // Initialize nodes on the bus; called by ScanNodes
     // \return Maximum number of nodes on bus (0 if error)
     virtual nodeid_t InitNodes(void) = 0;
@@ -226,6 +404,30 @@ protected:
     virtual bool ReadBlockNode(nodeid_t node, nodeaddr_t addr, quadlet_t *rdata,
                                unsigned int nbytes, unsigned char flags = 0) = 0;
 
+    // Read a block (from address 0) of each of the specified boards; called by ReadAllBoards
+    // for the sequential protocols. For each i < num, nbytes[i] are read from boardList[i] into
+    // rdata[i] and ok[i] indicates success. The default implementation calls ReadBlock for
+    // each board; derived classes can override it to send all requests before collecting the
+    // responses. Derived classes may assume that rdata[i] was obtained from GetReadSlotData.
+    virtual void ReadBlockMultiple(const unsigned char *boardList, quadlet_t * const *rdata,
+                                   const unsigned int *nbytes, bool *ok, unsigned int num);
+
+    // Split-phase version of ReadBlockMultiple, used by StartReadAllBoards and FinishReadAllBoards.
+    // StartReadBlockMultiple sends the read requests and returns true if the responses should be
+    // collected by FinishReadBlockMultiple (ok[i] may be set immediately for boards that cannot be
+    // batched). The default implementation returns false, in which case ReadBlockMultiple is called
+    // by FinishReadAllBoards.
+    virtual bool StartReadBlockMultiple(const unsigned char *, quadlet_t * const *,
+                                        const unsigned int *, bool *, unsigned int)
+    { return false; }
+    virtual void FinishReadBlockMultiple(bool *, unsigned int) {}
+
+    // Write a block (to address 0) of each of the specified boards; called by WriteAllBoards
+    // for the sequential protocol. Same conventions as ReadBlockMultiple, except that wdata[i]
+    // is obtained from GetWriteSlotData.
+    virtual void WriteBlockMultiple(const unsigned char *boardList, quadlet_t * const *wdata,
+                                    const unsigned int *nbytes, bool *ok, unsigned int num);
+
     // Method called by ReadAllBoards/ReadAllBoardsBroadcast if no data read
     virtual void OnNoneRead(void) {}
 
@@ -373,6 +575,66 @@ public:
     BroadcastReadInfo GetBroadcastReadInfo(void) const
     { return bcReadInfo; }
 
+    // Get/Set the wait strategy used by WaitBroadcastRead
+    BroadcastWaitType GetBroadcastWaitMode(void) const { return bcWaitMode; }
+    void SetBroadcastWaitMode(BroadcastWaitType mode);
+
+    // Returns the wait time (in seconds) used for the last broadcast read (BC_WAIT_ADAPTIVE only)
+    double GetBroadcastWaitTime(void) const { return bcWaitUsed; }
+
+    // Enable/disable collection of latency statistics (enabled by default)
+    bool GetLatencyStatsEnabled(void) const { return latencyEnabled; }
+    void SetLatencyStatsEnabled(bool enable) { latencyEnabled = enable; }
+
+    // Get a copy of the latency statistics, as published after the last read or write. This can be
+    // called from another thread (e.g., a supervisor) while the real-time loop is running. If reset
+    // is true, the statistics are reset (see ResetLatencyStats).
+    void GetLatencySnapshot(LatencySnapshot &snap, bool reset = false);
+
+    // Reset the latency statistics. The reset is performed by the thread doing the real-time I/O,
+    // at the next read or write, so it is safe to call from another thread.
+    void ResetLatencyStats(void);
+
+    // Enable/disable publishing of the feedback data (disabled by default). When enabled, the port
+    // publishes a copy of the real-time read data of all boards at the end of each ReadAllBoards,
+    // ReadAllBoardsBroadcast or FinishReadAllBoards.
+    bool GetFeedbackSnapshotEnabled(void) const { return feedbackEnabled; }
+    void SetFeedbackSnapshotEnabled(bool enable) { feedbackEnabled = enable; }
+
+    // Get a copy of the most recently published feedback data (see SetFeedbackSnapshotEnabled).
+    // This can be called from any thread (e.g., GUI, logger or safety monitor) while the real-time
+    // loop is running; the copy is consistent (all boards from the same read) and the real-time
+    // thread is never blocked. Use BoardIO::SetFromSnapshot to decode the data of a board.
+    // Returns false if no data was published yet.
+    bool GetFeedbackSnapshot(FeedbackSnapshot &snap) const
+    { return feedbackBuffer.Read(snap); }
+
+    // Set the timestamp of the feedback published by the next read (e.g., so that several ports
+    // read in the same cycle have the same timestamp, see PortGroup). If 0 (default), the current
+    // time (Amp1394_GetTime) is used.
+    void SetCycleTimestamp(double timestamp) { cycleTimestamp = timestamp; }
+    double GetCycleTimestamp(void) const { return cycleTimestamp; }
+
+    // Queue a register access (see PortRequest) from any thread, to be performed by the thread that
+    // does the real-time I/O. The requests are processed in order, up to GetRequestsPerCycle per cycle,
+    // at the start of WriteAllBoards (i.e., between the real-time read and write) or at the end of
+    // WriteReadAllBoards. If the real-time loop is not running, call ProcessRequests instead.
+    // Returns false if the request is already queued.
+    bool QueueRequest(PortRequest *req) { return requestQueue.Push(req); }
+
+    // Process up to maxNum queued requests (0 for all); must be called by the thread that does the
+    // real-time I/O. Returns the number of requests processed (not including cancelled requests).
+    unsigned int ProcessRequests(unsigned int maxNum = 0);
+
+    // Maximum number of requests processed in each cycle (default 1); 0 to only process requests
+    // when ProcessRequests is called.
+    unsigned int GetRequestsPerCycle(void) const { return requestsPerCycle; }
+    void SetRequestsPerCycle(unsigned int num) { requestsPerCycle = num; }
+
+    // Return string version of LatencyPath and LatencyStage
+    static std::string LatencyPathString(LatencyPath path);
+    static std::string LatencyStageString(LatencyStage stage);
+
     // Return string version of PortType
     static std::string PortTypeString(PortType portType);
 
@@ -383,6 +645,9 @@ public:
     // fw:N             for FireWire, where N is the port number
     // eth:N            for raw Ethernet (PCAP), where N is the port number
     // udp:xx.xx.xx.xx  for UDP, where xx.xx.xx.xx is the (optional) server IP address
+    // sim:N            for in-process emulated boards (SimPort), where N is the number of boards
+    // xdp:ifname[:Q]   for raw Ethernet via AF_XDP (EthXdpPort), where ifname (e.g., eth0) is returned in IPaddr
+    //                  and the receive queue Q (default 0) is returned in portNum
     static bool ParseOptions(const char *arg, PortType &portType, int &portNum, std::string &IPaddr,
                              std::ostream &ostr = std::cerr);
 
@@ -453,12 +718,32 @@ public:
     // Read all boards broadcasting
     virtual bool ReadAllBoardsBroadcast(void);
 
+    // Split-phase version of ReadAllBoards (for all protocols). StartReadAllBoards sends the read
+    // request(s) and returns without waiting for the response(s), so that the application can do
+    // other work (e.g., computation or WriteAllBoards) during the bus round-trip. FinishReadAllBoards
+    // waits for and processes the data, as in ReadAllBoards. The timeout (in seconds) applies to
+    // receiving the responses; if negative, the port's default timeout is used. Only WriteAllBoards
+    // (and WriteAllBoardsBroadcast) should be called between StartReadAllBoards and FinishReadAllBoards.
+    virtual bool StartReadAllBoards(void);
+    virtual bool FinishReadAllBoards(double timeoutSec = -1.0);
+
+    // Returns true if StartReadAllBoards was called, but not FinishReadAllBoards
+    bool IsReadPending(void) const { return pendingRead.active; }
+
     // Write to all boards
     virtual bool WriteAllBoards(void);
 
     // Write to all boards using broadcasting
     virtual bool WriteAllBoardsBroadcast(void);
 
+    // Write and then read all boards. With PROTOCOL_BC_QRW (and Firmware Rev 7+), the broadcast write
+    // and the broadcast read request are sent together (see WriteBroadcastOutputAndReadRequest), then
+    // the hub data is read as in ReadAllBoardsBroadcast, which saves one send per cycle. Note that the
+    // outputs are written before the feedback is read, so the control loop is: WriteReadAllBoards,
+    // compute outputs for the next cycle. For other protocols, calls WriteAllBoards and ReadAllBoards.
+    // Returns false if the write or the read failed.
+    virtual bool WriteReadAllBoards(void);
+
     // Read a quadlet from the specified board
     virtual bool ReadQuadlet(unsigned char boardId, nodeaddr_t addr, quadlet_t &data);
 
@@ -488,6 +773,14 @@ public:
     */
     virtual bool WriteBroadcastReadRequest(unsigned int seq) = 0;
 
+    /*!
+     \brief Write the broadcast packet (as in WriteBroadcastOutput), immediately followed by the
+            broadcast read request (as in WriteBroadcastReadRequest)
+     \returns number of packets sent (2 if both were sent, 1 if only the broadcast packet was sent)
+     The default implementation calls WriteBroadcastOutput and WriteBroadcastReadRequest.
+    */
+    virtual unsigned int WriteBroadcastOutputAndReadRequest(quadlet_t *buffer, unsigned int size, unsigned int seq);
+
     /*!
      \brief Wait for broadcast read data to be available
     */
@@ -33,6 +33,7 @@ class FirewirePort;
 class EthBasePort;
 class EthRawPort;
 class EthUdpPort;
+struct FeedbackSnapshot;
 
 class BoardIO
 {
@@ -50,6 +51,11 @@ protected:
     unsigned int numReadErrors;
     unsigned int numWriteErrors;
 
+    // Hardware and firmware versions from the last snapshot (see SetFromSnapshot); used
+    // instead of the port values when the board is not added to a port
+    uint32_t snapHwVersion;
+    uint32_t snapFwVersion;
+
     friend class BasePort;
     friend class FirewirePort;
     friend class EthBasePort;
@@ -108,7 +114,7 @@ public:
     };
 
     BoardIO(unsigned char board_id) : BoardId(board_id), port(0), readValid(false), writeValid(false),
-                                      numReadErrors(0), numWriteErrors(0) {}
+                                      numReadErrors(0), numWriteErrors(0), snapHwVersion(0), snapFwVersion(0) {}
     virtual ~BoardIO() {}
 
     inline unsigned char GetBoardId() const { return BoardId; }
@@ -143,6 +149,17 @@ public:
     // Returns FPGA clock period in seconds
     virtual double GetFPGAClockPeriod(void) const = 0;
 
+    /*! \brief Load the real-time read data from a feedback snapshot (see BasePort::GetFeedbackSnapshot)
+        This is intended for a board object that is not added to a port (e.g., one owned by a GUI
+        or logging thread), so that the Get methods (e.g., AmpIO::GetEncoderPosition) can be used
+        without accessing the board object of the real-time thread. The board is re-initialized
+        if the hardware or firmware version in the snapshot changed. Quantities that are
+        accumulated over reads (e.g., FPGA elapsed time) only account for the snapshots loaded.
+        \param snap feedback snapshot
+        \returns true if the snapshot contains valid data for this board
+    */
+    bool SetFromSnapshot(const FeedbackSnapshot &snap);
+
     // ********************** READ Methods ***********************************
     // The ReadXXX methods below read data directly from the boards via the
     // bus using quadlet reads.
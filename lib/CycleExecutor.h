@@ -0,0 +1,145 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __CYCLE_EXECUTOR_H__
+#define __CYCLE_EXECUTOR_H__
+
+#include <iostream>
+#include "Amp1394Types.h"
+#include "LatencyHistogram.h"
+
+class BasePort;
+
+// Periodic execution of a control loop: read (default BasePort::ReadAllBoards), compute (user
+// callback) and write (default BasePort::WriteAllBoards). The start of each cycle is scheduled
+// at an absolute time (start + n*period), using clock_nanosleep with TIMER_ABSTIME on Linux, so
+// that the timing errors do not accumulate, as they would with a relative sleep at the end of
+// each cycle. If a cycle takes longer than the period (overrun), the missed cycles are skipped
+// so that the following cycles remain aligned with the original schedule.
+//
+// Run executes the loop in the calling thread, which can optionally be given SCHED_FIFO
+// priority and CPU affinity (Linux only). On Linux, Run also sets the timer slack of the calling
+// thread to 1 ns (PR_SET_TIMERSLACK). For rates of several kHz, it is also recommended to call
+// mlockall to avoid page faults.
+//
+// Example:
+//     bool Compute(BasePort &port, void *data) { ... return true; }
+//     CycleExecutor exec(port, 0.0005);   // 2 kHz
+//     exec.SetComputeCallback(Compute, &myData);
+//     exec.SetRealtimePriority(80);
+//     exec.Run();                         // until Stop is called or a callback returns false
+
+class CycleExecutor {
+public:
+    // Callback for the read, compute or write step; returns false to stop the loop
+    typedef bool (*CycleCallback)(BasePort &port, void *userData);
+
+    // Statistics (all times in nanoseconds):
+    //   wakeup     time between the scheduled start of the cycle and the actual start (wakeup latency)
+    //   execution  time to execute read, compute and write
+    //   slack      time between the end of the cycle and the scheduled start of the next cycle
+    //              (not recorded for overruns)
+    struct CycleStats {
+        unsigned long numCycles;         // Number of cycles executed
+        unsigned long numOverruns;       // Number of cycles that did not finish within the period
+        unsigned long numSkipped;        // Number of cycles skipped due to overruns
+        unsigned long numLateWakeups;    // Number of cycles started later than the late threshold
+        unsigned long numReadErrors;     // Number of cycles where read (or read callback) failed
+        unsigned long numWriteErrors;    // Number of cycles where write (or write callback) failed
+        LatencyHistogram wakeup;
+        LatencyHistogram execution;
+        LatencyHistogram slack;
+
+        CycleStats() { Reset(); }
+        ~CycleStats() {}
+        void Reset(void);
+        void Print(std::ostream &outStr) const;
+    };
+
+protected:
+    BasePort &port;
+    std::ostream &outStr;
+    int64_t periodNs;
+    int64_t lateThresholdNs;
+    int rtPriority;                      // SCHED_FIFO priority (0 to not change)
+    int cpuNum;                          // CPU affinity (-1 to not change)
+    CycleCallback readCallback;
+    CycleCallback computeCallback;
+    CycleCallback writeCallback;
+    void *readData;
+    void *computeData;
+    void *writeData;
+    volatile bool stopRequested;
+    bool isRunning;
+    CycleStats stats;
+
+    // Apply the real-time priority and CPU affinity to the calling thread
+    bool SetThreadParameters(void);
+
+public:
+    CycleExecutor(BasePort &port, double periodSec, std::ostream &debugStream = std::cerr);
+    ~CycleExecutor() {}
+
+    // Period, in seconds
+    double GetPeriod(void) const { return periodNs*1.0e-9; }
+    void SetPeriod(double periodSec);
+
+    // A cycle that starts later than the threshold (seconds) is counted as a late wakeup
+    // (default is 10% of the period when the period is set)
+    double GetLateThreshold(void) const { return lateThresholdNs*1.0e-9; }
+    void SetLateThreshold(double sec) { lateThresholdNs = static_cast<int64_t>(sec*1.0e9); }
+
+    // Callbacks. The read and write callbacks replace the default calls to ReadAllBoards and
+    // WriteAllBoards (e.g., to use StartReadAllBoards and FinishReadAllBoards); set to 0 to
+    // restore the default. The compute callback is optional.
+    void SetReadCallback(CycleCallback cb, void *userData = 0)
+    { readCallback = cb; readData = userData; }
+    void SetComputeCallback(CycleCallback cb, void *userData = 0)
+    { computeCallback = cb; computeData = userData; }
+    void SetWriteCallback(CycleCallback cb, void *userData = 0)
+    { writeCallback = cb; writeData = userData; }
+
+    // Real-time scheduling of the thread that calls Run (Linux only). A priority of 0 (default)
+    // does not change the scheduling policy; a cpu of -1 (default) does not change the affinity.
+    // Setting SCHED_FIFO generally requires root privileges or CAP_SYS_NICE.
+    void SetRealtimePriority(int priority) { rtPriority = priority; }
+    void SetCpuAffinity(int cpu) { cpuNum = cpu; }
+
+    // Apply the real-time priority and CPU affinity (as above) and reduce the timer slack of the
+    // calling thread (Linux only). Also used by PortGroup for its worker threads.
+    static bool SetCurrentThreadParameters(int priority, int cpu, std::ostream &outStr);
+
+    /*! \brief Run the loop in the calling thread
+        \param numCycles number of cycles to run (0 to run until Stop is called or a callback
+                         returns false)
+        \returns false if the thread parameters could not be set, if the loop was already running,
+                 or if the loop was stopped because a callback returned false
+    */
+    bool Run(unsigned long numCycles = 0);
+
+    // Stop the loop (can be called from a callback or from another thread)
+    void Stop(void) { stopRequested = true; }
+
+    bool IsRunning(void) const { return isRunning; }
+
+    // Get a copy of the statistics. This can be called from another thread while the loop is
+    // running, but the copy is not synchronized with the loop (values may differ by one cycle).
+    void GetStats(CycleStats &cycleStats) const { cycleStats = stats; }
+
+    // Reset the statistics (should be called when the loop is not running)
+    void ResetStats(void) { stats.Reset(); }
+};
+
+#endif // __CYCLE_EXECUTOR_H__
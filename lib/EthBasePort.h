@@ -21,6 +21,7 @@ http://www.cisst.org/cisst/license.txt.
 
 #include <iostream>
 #include "BasePort.h"
+#include "EthTimestamp.h"
 
 // Some useful constants related to the FireWire protocol
 const unsigned int FW_QREAD_SIZE      = 16;        // Number of bytes in Firewire quadlet read request packet
@@ -68,6 +69,32 @@ public:
 
     typedef bool (*EthCallbackType)(EthBasePort &port, unsigned char boardId, std::ostream &debugStream);
 
+    // Receive strategy:
+    //   RECV_WAIT        block (e.g., select) until a packet is available or the receive timeout expires
+    //   RECV_BUSY_POLL   spin on a non-blocking receive until a packet is available or the receive
+    //                    timeout expires (lower wakeup latency, but uses 100% of a CPU core)
+    enum ReceiveModeType { RECV_WAIT, RECV_BUSY_POLL };
+
+    // Breakdown of the time for a read transaction, using packet timestamps (see SetTimestamping),
+    // in seconds:
+    //   hostSend      from the call to send the request until it was sent (transmit timestamp)
+    //   hostReceive   from the arrival of the response (receive timestamp) until it was returned
+    //   wire          time between the transmit and receive timestamps, minus fpga
+    //   fpga          time for the FPGA to receive the request and send the response (GetFpgaTotalTime)
+    // If hardware is true, the wire time was computed using the hardware (NIC) timestamps; otherwise,
+    // it also includes the time spent in the driver and network interface.
+    struct TransactionTiming {
+        bool valid;
+        bool hardware;
+        double hostSend;
+        double hostReceive;
+        double wire;
+        double fpga;
+        TransactionTiming() : valid(false), hardware(false), hostSend(0.0), hostReceive(0.0),
+                              wire(0.0), fpga(0.0) {}
+        ~TransactionTiming() {}
+    };
+
 protected:
 
     uint8_t fw_tl;          // FireWire transaction label (6 bits)
@@ -75,6 +102,15 @@ protected:
     EthCallbackType eth_read_callback;
     double ReceiveTimeout;      // Ethernet receive timeout (seconds)
 
+    ReceiveModeType ReceiveMode;   // Receive strategy (default is RECV_WAIT)
+    unsigned int BusyPollUsec;     // Value for SO_BUSY_POLL socket option (0 if not used)
+    unsigned long RecvSpinCount;   // Number of receive attempts (spins) for last received packet(s)
+    unsigned long RecvSpinMax;     // Maximum value of RecvSpinCount (since last reset)
+
+    // Update RecvSpinCount and RecvSpinMax
+    void UpdateSpinCount(unsigned long numSpins)
+    { RecvSpinCount = numSpins; if (numSpins > RecvSpinMax) RecvSpinMax = numSpins; }
+
     enum FPGA_FLAGS {
         FwBusReset = 0x01,          // Firewire bus reset is active
         FwPacketDropped = 0x02,     // Firewire packet dropped
@@ -84,9 +120,46 @@ protected:
 
     FPGA_Status FpgaStatus;     // FPGA status from extra data returned
 
+    // Read requests sent by StartReadBlockMultiple, for which responses have not yet been received
+    struct PendingBlockRead {
+        unsigned int num;                               // number of requests sent
+        unsigned char *packet[BoardIO::MAX_BOARDS];     // where to receive response packet
+        size_t size[BoardIO::MAX_BOARDS];               // expected size of response packet
+        size_t capacity[BoardIO::MAX_BOARDS];           // size of buffer at packet (>= size)
+        unsigned int nbytes[BoardIO::MAX_BOARDS];       // number of data bytes
+        unsigned int index[BoardIO::MAX_BOARDS];        // index into boardList
+        unsigned char boardId[BoardIO::MAX_BOARDS];
+        nodeid_t node[BoardIO::MAX_BOARDS];
+        unsigned int tl[BoardIO::MAX_BOARDS];           // transaction label
+        PendingBlockRead() : num(0) {}
+        ~PendingBlockRead() {}
+    };
+    PendingBlockRead blockReadPending;
+
+    // Table of outstanding read requests, indexed by transaction label. Used to match each
+    // response to its request, so that several requests can be in flight at once.
+    struct InFlightRequest {
+        bool active;              // true if waiting for response
+        unsigned int request;     // index into blockReadPending
+        InFlightRequest() : active(false), request(0) {}
+    };
+    InFlightRequest inFlight[FW_TL_MASK+1];
+
     double FPGA_RecvTime;       // Time for FPGA to receive Ethernet packet (seconds)
     double FPGA_TotalTime;      // Total time for FPGA to receive packet and respond (seconds)
 
+    bool Timestamping;              // true if packet timestamps enabled (see SetTimestamping)
+    bool TimestampingHardware;      // true if hardware timestamps enabled
+    TransactionTiming LastTiming;   // timing of last timed transaction
+    bool LastTimingPending;         // true if waiting for FPGA time (from extra data) to complete LastTiming
+    double LastTimingRoundTrip;     // time between transmit and receive timestamps
+
+    // Set LastTiming for a read transaction, where sendTime is when the request was passed to the
+    // kernel and recvTime is when the response was returned by the kernel (both from EthTimestampNow).
+    // The wire and FPGA times are filled in by ProcessExtraData.
+    void SetTransactionTiming(double sendTime, const EthTimestamp &txStamp,
+                              const EthTimestamp &rxStamp, double recvTime);
+
     //! Read quadlet from node (internal method called by ReadQuadlet)
     bool ReadQuadletNode(nodeid_t node, nodeaddr_t addr, quadlet_t &data, unsigned char flags = 0);
 
@@ -109,12 +182,42 @@ protected:
     // Flush all packets in receive buffer
     virtual int PacketFlushAll(void) = 0;
 
+    // Send a request packet and receive the response packet. Returns the number of bytes received
+    // (same as PacketReceive), or -1 if the request could not be sent. The default implementation
+    // calls PacketSend and PacketReceive.
+    virtual int PacketSendReceive(unsigned char *sendPacket, size_t sendBytes, bool useEthernetBroadcast,
+                                  unsigned char *recvPacket, size_t recvBytes);
+
+    // Send multiple packets; returns number of packets sent.
+    // The default implementation calls PacketSend for each packet.
+    virtual unsigned int PacketSendBatch(unsigned char * const *packets, const size_t *nbytes,
+                                         unsigned int num, bool useEthernetBroadcast);
+
+    // Receive up to num packets, where nbytes[i] is the expected size of packets[i]. The number of
+    // bytes received for each packet is returned in nRecv; the return value is the number of
+    // packets received. The default implementation calls PacketReceive for each packet.
+    virtual unsigned int PacketReceiveBatch(unsigned char * const *packets, const size_t *nbytes,
+                                            int *nRecv, unsigned int num);
+
+    // Read/write blocks from/to multiple boards, sending all requests before collecting
+    // the responses (see BasePort)
+    void ReadBlockMultiple(const unsigned char *boardList, quadlet_t * const *rdata,
+                           const unsigned int *nbytes, bool *ok, unsigned int num);
+    bool StartReadBlockMultiple(const unsigned char *boardList, quadlet_t * const *rdata,
+                                const unsigned int *nbytes, bool *ok, unsigned int num);
+    void FinishReadBlockMultiple(bool *ok, unsigned int num);
+    void WriteBlockMultiple(const unsigned char *boardList, quadlet_t * const *wdata,
+                            const unsigned int *nbytes, bool *ok, unsigned int num);
+
     // Method called by ReadAllBoards/ReadAllBoardsBroadcast if no data read
     void OnNoneRead(void);
 
     // Method called by WriteAllBoards/WriteAllBoardsBroadcast if no data written
     void OnNoneWritten(void);
 
+    // Fixed time to wait for broadcast read data, in seconds
+    double GetBroadcastReadWait(void) const;
+
     // Method called when Firewire bus reset has caused the Firewire generation number on the FPGA
     // to be different than the one on the PC.
     virtual void OnFwBusReset(unsigned int FwBusGeneration_FPGA);
@@ -141,6 +244,46 @@ public:
 
     void SetReceiveTimeout(double timeSec) { ReceiveTimeout = timeSec; }
 
+    /*!
+     \brief Set the receive strategy
+     \param mode: RECV_WAIT (default) or RECV_BUSY_POLL
+     \param busyPollUsec: if non-zero (and mode is RECV_BUSY_POLL), also sets the SO_BUSY_POLL and
+            SO_PREFER_BUSY_POLL socket options (Linux only); this value is passed to SO_BUSY_POLL
+     \return true if the receive mode is supported by this port
+    */
+    virtual bool SetReceiveMode(ReceiveModeType mode, unsigned int busyPollUsec = 0);
+
+    ReceiveModeType GetReceiveMode(void) const { return ReceiveMode; }
+
+    // Return number of receive attempts (spins) for the last received packet(s). This is
+    // 1 in RECV_WAIT mode and can be used to tune the busy-poll settings in RECV_BUSY_POLL mode.
+    unsigned long GetReceiveSpinCount(void) const { return RecvSpinCount; }
+
+    // Return the maximum number of receive attempts since the last call to ResetReceiveSpinMax
+    unsigned long GetReceiveSpinMax(void) const { return RecvSpinMax; }
+    void ResetReceiveSpinMax(void) { RecvSpinMax = 0; }
+
+    /*!
+     \brief Enable or disable packet timestamps (Linux SO_TIMESTAMPING), used to measure the time
+            spent in the host network stack, on the wire and on the FPGA for each read transaction
+            (see GetTransactionTiming). Only applies to reads that wait for the response (i.e., not
+            to ReadBlockMultiple); the io_uring and batched receive paths are not used while enabled.
+     \param enable: true to enable timestamps
+     \param hardware: true to also use hardware (NIC) timestamps, if supported
+     \return true if successful; the default implementation returns false (not supported)
+    */
+    virtual bool SetTimestamping(bool enable, bool hardware = true);
+
+    bool GetTimestamping(void) const { return Timestamping; }
+
+    // Returns true if hardware timestamps are used
+    bool GetTimestampingHardware(void) const { return TimestampingHardware; }
+
+    // Return the timing of the last read transaction (if timestamping enabled).
+    // Returns false if not available (e.g., timestamps missing).
+    bool GetTransactionTiming(TransactionTiming &timing) const
+    { timing = LastTiming; return LastTiming.valid; }
+
     // Return FPGA status related to Ethernet interface
     void GetFpgaStatus(FPGA_Status &status) const { status = FpgaStatus; }
 
@@ -173,11 +316,20 @@ public:
     */
     bool WriteBroadcastReadRequest(unsigned int seq);
 
+    /*!
+     \brief Write the broadcast packet and the broadcast read request with a single PacketSendBatch
+            (i.e., one sendmmsg call for EthUdpPort)
+    */
+    unsigned int WriteBroadcastOutputAndReadRequest(quadlet_t *buffer, unsigned int size, unsigned int seq);
+
     /*!
      \brief Wait for broadcast read data to be available
     */
     void WaitBroadcastRead(void);
 
+    // Uses timeoutSec (if not negative) as the receive timeout
+    bool FinishReadAllBoards(double timeoutSec = -1.0);
+
     /*!
      \brief Add delay (if needed) for PROM I/O operations
      The delay is non-zero for Ethernet.
@@ -19,11 +19,13 @@ http://www.cisst.org/cisst/license.txt.
 #ifndef __EthRawPort_H__
 #define __EthRawPort_H__
 
+#include <Amp1394/AmpIORevision.h>
 #include "EthBasePort.h"
 
-// Forward declaration
+// Forward declarations
 struct pcap;
 typedef struct pcap pcap_t;
+struct PacketRing;
 
 const unsigned int ETH_FRAME_HEADER_SIZE = 14;    // dest addr (6), src addr (6), length (2)
 const unsigned int ETH_FRAME_LENGTH_OFFSET = 12;  // offset to length
@@ -31,11 +33,16 @@ const unsigned int ETH_FRAME_LENGTH_OFFSET = 12;  // offset to length
 //const unsigned int ETH_RAW_FRAME_MAX_SIZE = 1500; // maximum raw Ethernet frame size
 const unsigned int ETH_RAW_FRAME_MAX_SIZE = 1024;   // Temporary firmware limit
 
+// Raw Ethernet port. The packets are sent and received using pcap or, on Linux (if Amp1394_HAS_PACKET_MMAP
+// is set), using an AF_PACKET socket with a memory-mapped receive ring (see PacketRing in EthRawPort.cpp).
+// In the latter case, a BPF filter in the kernel only accepts packets from the FPGA boards to this PC.
+
 class EthRawPort : public EthBasePort
 {
 protected:
 
     pcap_t *handle;
+    PacketRing *ringPtr;
     uint8_t frame_hdr[ETH_FRAME_HEADER_SIZE];
 
     bool headercheck(const unsigned char *header, bool toPC) const;
@@ -47,6 +54,13 @@ protected:
     // Check Ethernet header
     bool CheckEthernetHeader(const unsigned char *packet, bool useEthernetBroadcast);
 
+    // Set the Ethernet header template (frame_hdr) for the specified local MAC address
+    void SetFrameHeader(const uint8_t *localMac);
+
+    // Returns the number of bytes in the received Ethernet frame, based on the length field
+    // (caplen is the number of bytes captured)
+    static unsigned int GetFrameLength(const unsigned char *packet, unsigned int caplen);
+
     //! Initialize EthRaw port
     bool Init(void);
 
@@ -66,11 +80,25 @@ protected:
     // Flush all packets in receive buffer
     int PacketFlushAll(void);
 
+    // Send request and receive response (also gets the packet timestamps, if enabled)
+    int PacketSendReceive(unsigned char *sendPacket, size_t sendBytes, bool useEthernetBroadcast,
+                          unsigned char *recvPacket, size_t recvBytes);
+
+    // Constructor for derived classes that use a different method to send and receive the
+    // Ethernet frames; does not call Init.
+    EthRawPort(int portNum, std::ostream &debugStream, EthCallbackType cb, bool);
+
 public:
     EthRawPort(int portNum, std::ostream &debugStream = std::cerr, EthCallbackType cb = 0);
 
     ~EthRawPort();
 
+    // RECV_BUSY_POLL is only supported with the AF_PACKET ring (busyPollUsec is not used)
+    bool SetReceiveMode(ReceiveModeType mode, unsigned int busyPollUsec = 0);
+
+    // Only supported with the AF_PACKET ring (software timestamps only)
+    bool SetTimestamping(bool enable, bool hardware = true);
+
     //****************** BasePort virtual methods ***********************
 
     PortType GetPortType(void) const { return PORT_ETH_RAW; }
@@ -0,0 +1,67 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __ETH_TIMESTAMP_H__
+#define __ETH_TIMESTAMP_H__
+
+#include <iostream>
+#include <string>
+
+// Packet timestamps provided by the kernel (software) or the network interface (hardware), using the
+// Linux SO_TIMESTAMPING socket option. Software timestamps use CLOCK_REALTIME, so they can be compared
+// with EthTimestampNow; hardware timestamps use the clock of the network interface, so they can only
+// be compared with each other.
+
+struct EthTimestamp {
+    double sw;      // Software timestamp, in seconds (0 if not available)
+    double hw;      // Hardware timestamp, in seconds (0 if not available)
+
+    EthTimestamp() : sw(0.0), hw(0.0) {}
+    ~EthTimestamp() {}
+    void Clear(void) { sw = 0.0; hw = 0.0; }
+};
+
+#ifdef __linux__
+
+struct msghdr;
+
+// Size of the control buffer needed by EthTimestampRequestTx and EthTimestampParse
+const unsigned int ETH_TIMESTAMP_CONTROL_SIZE = 256;
+
+// Current time (CLOCK_REALTIME), in seconds
+double EthTimestampNow(void);
+
+// Enable (or disable) receive timestamps and reporting of transmit timestamps on the socket. If hardware
+// is true, also enables hardware timestamping on the network interface ifName (requires CAP_NET_ADMIN);
+// if this fails, hwEnabled is false and only software timestamps are used. Note that the hardware
+// timestamping setting of the interface is not restored when timestamping is disabled.
+bool EthTimestampEnable(int fd, bool enable, const std::string &ifName, bool hardware, bool &hwEnabled,
+                        std::ostream &outStr);
+
+// Add a control message to msg (using controlBuf, which must be ETH_TIMESTAMP_CONTROL_SIZE bytes) to
+// request a transmit timestamp for this packet only (Linux 4.13+). The timestamp is later obtained
+// from the error queue of the socket by EthTimestampReadTx.
+void EthTimestampRequestTx(struct msghdr *msg, char *controlBuf, bool hardware);
+
+// Get timestamp from the control messages of a received packet. Returns false if none found.
+bool EthTimestampParse(struct msghdr *msg, EthTimestamp &ts);
+
+// Read all transmit timestamps from the error queue (non-blocking), updating ts with the values found.
+// Returns the number of timestamps read.
+int EthTimestampReadTx(int fd, EthTimestamp &ts);
+
+#endif // __linux__
+
+#endif // __ETH_TIMESTAMP_H__
@@ -47,15 +47,28 @@ protected:
     // \return Maximum number of nodes on bus (0 if error)
     nodeid_t InitNodes(void);
 
-    // Send packet via UDP
+    // Send packet via UDP (sendto; io_uring is only used by PacketSendReceive)
     bool PacketSend(unsigned char *packet, size_t nbytes, bool useEthernetBroadcast);
 
-    // Receive packet via UDP
+    // Receive packet via UDP (recv; io_uring is only used by PacketSendReceive)
     int PacketReceive(unsigned char *packet, size_t nbytes);
 
     // Flush all packets in receive buffer
     int PacketFlushAll(void);
 
+    // Send request and receive response via UDP (with a single io_uring_enter call,
+    // if Amp1394_HAS_IO_URING is set)
+    int PacketSendReceive(unsigned char *sendPacket, size_t sendBytes, bool useEthernetBroadcast,
+                          unsigned char *recvPacket, size_t recvBytes);
+
+    // Send multiple packets via UDP (sendmmsg on Linux)
+    unsigned int PacketSendBatch(unsigned char * const *packets, const size_t *nbytes,
+                                 unsigned int num, bool useEthernetBroadcast);
+
+    // Receive multiple packets via UDP (recvmmsg on Linux)
+    unsigned int PacketReceiveBatch(unsigned char * const *packets, const size_t *nbytes,
+                                    int *nRecv, unsigned int num);
+
 public:
 
     EthUdpPort(int portNum, const std::string &serverIP = ETH_UDP_DEFAULT_IP,
@@ -69,6 +82,15 @@ public:
 
     bool IsOK(void);
 
+    //****************** EthBasePort virtual methods ***********************
+
+    // Supports RECV_WAIT (select) and RECV_BUSY_POLL (non-blocking recv)
+    bool SetReceiveMode(ReceiveModeType mode, unsigned int busyPollUsec = 0);
+
+    // Supported on Linux; hardware timestamps require CAP_NET_ADMIN and must be enabled after
+    // the first packet is received (i.e., after the port is initialized)
+    bool SetTimestamping(bool enable, bool hardware = true);
+
     unsigned int GetPrefixOffset(MsgType msg) const;
     unsigned int GetWritePostfixSize(void) const  { return FW_CRC_SIZE; }
     unsigned int GetReadPostfixSize(void) const   { return (FW_CRC_SIZE+FW_EXTRA_SIZE); }
@@ -0,0 +1,83 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __EthXdpPort_H__
+#define __EthXdpPort_H__
+
+#include <string>
+#include "EthRawPort.h"
+
+// Forward declaration
+struct XdpSocket;
+
+// Raw Ethernet port using an AF_XDP socket (Linux only), which bypasses the kernel network stack.
+// The Ethernet frames are the same as for EthRawPort; they are copied to/from a memory area (UMEM)
+// that is shared with the kernel, and passed via the fill, completion, receive and transmit rings.
+// If the network driver supports it, the NIC accesses the UMEM directly (zero-copy mode);
+// otherwise, the kernel copies the frames (copy mode).
+//
+// An XDP program is attached to the interface (for as long as the port is open) to redirect the frames
+// sent by the FPGA boards (source address FA:61:0E:13:94:xx) on the specified receive queue to the socket.
+// All other frames are passed to the kernel network stack. The NIC must therefore be configured so that
+// the FPGA frames arrive on that queue (e.g., a single queue, or using ethtool flow steering).
+// Requires root privileges (or CAP_NET_RAW, CAP_BPF and CAP_NET_ADMIN) and Linux 5.9 or later.
+
+class EthXdpPort : public EthRawPort
+{
+protected:
+
+    std::string IfName;
+    XdpSocket *xskPtr;
+
+    //! Initialize AF_XDP port
+    bool Init(void);
+
+    //! Cleanup AF_XDP port
+    void Cleanup(void);
+
+    // Send packet via AF_XDP socket
+    bool PacketSend(unsigned char *packet, size_t nbytes, bool useEthernetBroadcast);
+
+    // Send multiple packets, with a single kernel call
+    unsigned int PacketSendBatch(unsigned char * const *packets, const size_t *nbytes,
+                                 unsigned int num, bool useEthernetBroadcast);
+
+    // Receive packet via AF_XDP socket
+    int PacketReceive(unsigned char *packet, size_t nbytes);
+
+    // Flush all packets in receive ring
+    int PacketFlushAll(void);
+
+public:
+    // ifName is the network interface (e.g., eth0) and queueId is the receive/transmit queue
+    EthXdpPort(const std::string &ifName, unsigned int queueId = 0, std::ostream &debugStream = std::cerr,
+               EthCallbackType cb = 0);
+
+    ~EthXdpPort();
+
+    // RECV_BUSY_POLL spins on the receive ring (busyPollUsec is not used)
+    bool SetReceiveMode(ReceiveModeType mode, unsigned int busyPollUsec = 0);
+
+    // Returns true if the NIC accesses the frame buffers directly (zero-copy mode)
+    bool IsZeroCopy(void) const;
+
+    //****************** BasePort virtual methods ***********************
+
+    PortType GetPortType(void) const { return PORT_ETH_XDP; }
+
+    bool IsOK(void);
+};
+
+#endif  // __EthXdpPort_H__
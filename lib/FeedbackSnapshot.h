@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __FEEDBACK_SNAPSHOT_H__
+#define __FEEDBACK_SNAPSHOT_H__
+
+#include "Amp1394Types.h"
+#include "BoardIO.h"
+
+// Copy of the real-time feedback (read) data of all boards on a port, as published by the
+// port after each ReadAllBoards (see BasePort::GetFeedbackSnapshot). The data is kept as
+// received (bus byte order), so that it can be loaded into a board object that is not used
+// by the real-time thread (see BoardIO::SetFromSnapshot) and decoded with the usual Get methods.
+
+struct FeedbackSnapshot {
+    enum { MAX_QUADS = 64 };          // Maximum number of quadlets per board
+
+    struct BoardData {
+        bool valid;                   // true if board is in use and data was read successfully
+        uint32_t hwVersion;           // Hardware version (e.g., QLA1_String)
+        uint32_t fwVersion;           // Firmware version
+        unsigned int numQuads;        // Number of quadlets in data
+        quadlet_t data[MAX_QUADS];    // Real-time read data (bus byte order)
+
+        BoardData() : valid(false), hwVersion(0), fwVersion(0), numQuads(0) {}
+        ~BoardData() {}
+    };
+
+    uint32_t sequence;                // Incremented on each publish (0 if nothing published)
+    double timestamp;                 // When the data was published (Amp1394_GetTime)
+    BoardData board[BoardIO::MAX_BOARDS];
+
+    FeedbackSnapshot() : sequence(0), timestamp(0.0) {}
+    ~FeedbackSnapshot() {}
+};
+
+// Double-buffered seqlock for publishing a FeedbackSnapshot from the real-time thread (single
+// writer) to any number of reader threads. The writer alternates between two buffers, so it
+// never waits for the readers. A reader copies the most recently published buffer and checks
+// the sequence counter of that buffer to detect whether the writer started overwriting it during
+// the copy, in which case the copy is repeated. This can only happen if the copy takes longer
+// than one publish period, so in practice the reader does not need to retry.
+
+class FeedbackBuffer {
+protected:
+    FeedbackSnapshot buffer[2];
+    volatile uint32_t seq[2];         // Per-buffer sequence (odd while being written)
+    volatile uint32_t latest;         // Index of the most recently published buffer
+    uint32_t numPublished;
+    unsigned int writeIndex;
+
+    // Prevent copies
+    FeedbackBuffer(const FeedbackBuffer &);
+    FeedbackBuffer& operator=(const FeedbackBuffer &);
+
+public:
+    FeedbackBuffer();
+    ~FeedbackBuffer() {}
+
+    // Writer: BeginWrite returns the buffer to fill in (all boards initially marked invalid)
+    // and EndWrite publishes it. Must be called by a single thread.
+    FeedbackSnapshot &BeginWrite(double timestamp);
+    void EndWrite(void);
+
+    // Reader: copies the most recently published snapshot. Returns false if nothing was
+    // published yet. Can be called from any thread.
+    bool Read(FeedbackSnapshot &snap) const;
+};
+
+#endif // __FEEDBACK_SNAPSHOT_H__
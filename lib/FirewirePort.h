@@ -64,6 +64,9 @@ protected:
     // Method called by WriteAllBoards/WriteAllBoardsBroadcast if no data written
     void OnNoneWritten(void);
 
+    // Fixed time to wait for broadcast read data, in seconds
+    double GetBroadcastReadWait(void) const;
+
     // Poll for IEEE 1394 events, such as bus reset.
     void PollEvents(void);
 
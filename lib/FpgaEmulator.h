@@ -0,0 +1,162 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __FPGAEMULATOR_H__
+#define __FPGAEMULATOR_H__
+
+#include <iostream>
+#include <string>
+#include <map>
+#include "BoardIO.h"
+
+// Software model of a FireWire bus of FPGA boards (FPGA1394 with QLA, DQLA or dRAC), used to test
+// and benchmark the library without hardware. It implements:
+//
+//   - the registers read by the Port classes when scanning the bus (see BoardIO::Registers)
+//   - the real-time block read (feedback) and block write (DAC/control) at address 0, with
+//     the layout that corresponds to the firmware version (Rev 6, 7 or 8) and hardware type
+//   - the broadcast write (node 63, address 0) and the broadcast read protocol: query by
+//     quadlet write to 0x1800, followed by block read of the hub data at 0x1000
+//   - the Ethernet/FireWire bridge protocol (control word, FireWire packet, extra data), so
+//     that it can be served over UDP (see tests/fpgaemu.cpp)
+//
+// Node numbers are assigned in the order that the boards are added; the first board is the hub
+// (i.e., the board that would be connected to the PC via Ethernet). The feedback is synthetic:
+// when the amplifier is enabled, each encoder moves at a rate proportional to the commanded current.
+
+class FpgaEmulator
+{
+public:
+    enum { MAX_BOARDS = BoardIO::MAX_BOARDS, MAX_CHANNELS = 16, MAX_QUADS = 64 };
+
+    FpgaEmulator(std::ostream &debugStream = std::cerr);
+    ~FpgaEmulator();
+
+    /*! \brief Add a board to the emulated bus
+        \param boardId board number (rotary switch), 0-15
+        \param hwVersion hardware version (QLA1_String, DQLA_String or dRA1_String)
+        \param fwVersion firmware version (6, 7 or 8; Rev 8 required for DQLA and dRA1)
+        \returns true if successful
+    */
+    bool AddBoard(unsigned char boardId, unsigned long hwVersion, unsigned long fwVersion);
+
+    void RemoveAllBoards(void);
+
+    unsigned int GetNumBoards(void) const { return NumBoards; }
+
+    // Returns board id of hub board (first board added), or MAX_BOARDS if none
+    unsigned char GetHubBoard(void) const;
+
+    // Simulated time for each board to provide its data to the hub during a broadcast read
+    // (seconds), which is reported in the hub data. If enforce is true, data requested from the
+    // hub before it is available will contain the previous sequence number, as would happen if
+    // the PC does not wait long enough. This is not enabled by default because the emulator may
+    // be scheduled late (i.e., after both the query and the hub read have been received).
+    void SetBoardUpdateTime(double sec, bool enforce = false)
+    { BoardUpdateTime = sec; EnforceUpdateTime = enforce; }
+    double GetBoardUpdateTime(void) const { return BoardUpdateTime; }
+
+    unsigned int GetBusGeneration(void) const { return BusGeneration; }
+
+    // Simulate a FireWire bus reset (increments the bus generation)
+    void BusReset(void);
+
+    // Returns hardware version (e.g., QLA1_String) given a string such as "QLA1", or 0 if invalid
+    static unsigned long ParseHardwareVersion(const std::string &str);
+
+    // FireWire transactions. Quadlet data is in host byte order; block data is in bus (big-endian)
+    // byte order, consistent with BasePort::ReadBlock and BasePort::WriteBlock. All methods return
+    // false if there is no board at the specified node.
+    bool ReadQuadlet(nodeid_t node, nodeaddr_t addr, quadlet_t &data);
+    bool WriteQuadlet(nodeid_t node, nodeaddr_t addr, quadlet_t data);
+    bool ReadBlock(nodeid_t node, nodeaddr_t addr, quadlet_t *rdata, unsigned int nbytes);
+    bool WriteBlock(nodeid_t node, nodeaddr_t addr, const quadlet_t *wdata, unsigned int nbytes);
+
+    /*! \brief Process a packet received by the Ethernet/FireWire bridge
+        \param request request from PC (control word followed by FireWire packet)
+        \param reqLen number of bytes in request
+        \param response buffer for response (FireWire packet followed by extra data)
+        \param maxLen size of response buffer
+        \returns number of bytes in response (0 if no response)
+    */
+    size_t ProcessPacket(const unsigned char *request, size_t reqLen,
+                         unsigned char *response, size_t maxLen);
+
+    // Number of packets processed and number of packets rejected (malformed or unsupported)
+    unsigned long GetNumPackets(void) const { return NumPackets; }
+    unsigned long GetNumPacketErrors(void) const { return NumPacketErrors; }
+
+protected:
+
+    struct EmulatedBoard {
+        unsigned char boardId;
+        unsigned long hwVersion;
+        unsigned long fwVersion;
+        unsigned int numMotors;
+        unsigned int numEncoders;
+        quadlet_t status;                   // status/control register (see BoardIO::BOARD_STATUS)
+        quadlet_t ipAddr;
+        quadlet_t ethStatus;
+        quadlet_t dac[MAX_CHANNELS];        // commanded motor current (DAC units)
+        bool ampEnable[MAX_CHANNELS];
+        double encPos[MAX_CHANNELS];        // encoder position (counts)
+        double encVel[MAX_CHANNELS];        // encoder velocity (counts/second)
+        double lastSampleTime;              // time of last feedback sample (for timestamp)
+        double lastReadTime;                // time of last block read (timestamp is cleared by block read)
+        // Broadcast read data
+        quadlet_t hubData[MAX_QUADS];       // data available in hub memory (bus byte order)
+        unsigned int hubQuads;
+        quadlet_t hubPending[MAX_QUADS];    // data being transferred to hub (bus byte order)
+        double hubReadyTime;                // time when hubPending is copied to hubData
+        bool hubPendingValid;
+        std::map<nodeaddr_t, quadlet_t> regs;   // other registers (read/write)
+    };
+
+    std::ostream &outStr;
+    EmulatedBoard *Boards[MAX_BOARDS];      // indexed by node number
+    unsigned int NumBoards;
+    unsigned int BusGeneration;
+    double BoardUpdateTime;
+    bool EnforceUpdateTime;
+    double QueryTime;                       // time of last broadcast query
+    unsigned long NumPackets;
+    unsigned long NumPacketErrors;
+
+    EmulatedBoard *GetBoardByNode(nodeid_t node) const;
+    EmulatedBoard *GetBoardById(unsigned char boardId) const;
+    EmulatedBoard *GetHub(void) const { return (NumBoards > 0) ? Boards[0] : 0; }
+
+    // Number of quadlets in real-time block read and block write
+    static unsigned int GetReadNumQuads(const EmulatedBoard &board);
+    static unsigned int GetWriteNumQuads(const EmulatedBoard &board);
+
+    // Update motion (encoders) and fill in real-time feedback (bus byte order)
+    void SampleFeedback(EmulatedBoard &board, quadlet_t *data, double now, bool clearTimestamp);
+
+    // Process real-time block write for one board (data in bus byte order); returns number of
+    // quadlets consumed (0 if error)
+    unsigned int WriteRealtime(EmulatedBoard &board, const quadlet_t *data, unsigned int numQuads);
+
+    void WriteStatus(EmulatedBoard &board, quadlet_t data);
+    void WriteBroadcast(const quadlet_t *data, unsigned int numQuads);
+    void BroadcastQuery(quadlet_t data);
+    unsigned int ReadHub(quadlet_t *data, unsigned int maxQuads);
+
+    size_t MakeResponse(unsigned char *response, size_t maxLen, nodeid_t srcNode, unsigned int tl,
+                        unsigned int tcode, const quadlet_t *data, unsigned int nbytes) const;
+    size_t MakeExtraData(unsigned char *extra, size_t reqLen) const;
+};
+
+#endif // __FPGAEMULATOR_H__
@@ -0,0 +1,112 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __LATENCY_HISTOGRAM_H__
+#define __LATENCY_HISTOGRAM_H__
+
+#include <iostream>
+#include "Amp1394Types.h"
+
+// Histogram of latencies (in nanoseconds) with logarithmic buckets, similar to HdrHistogram:
+// each power of 2 is divided into SUB_BUCKETS linear buckets, so the relative error of any
+// recorded value is less than 1/SUB_BUCKETS (6.25%). Values below 2*SUB_BUCKETS ns are exact
+// and values above 2^(MAX_MSB+1) ns (about 18 minutes) are recorded in the last bucket.
+// Recording a value is a few integer operations and there is no memory allocation, so it
+// can be used in the real-time loop.
+
+class LatencyHistogram {
+public:
+    enum { SUB_BUCKET_BITS = 4,
+           SUB_BUCKETS = (1 << SUB_BUCKET_BITS),
+           MAX_MSB = 39,
+           NUM_BUCKETS = (MAX_MSB-SUB_BUCKET_BITS+2)*SUB_BUCKETS };
+
+protected:
+    uint32_t counts[NUM_BUCKETS];
+    uint64_t totalCount;
+    uint64_t sum;             // sum of all values (ns), for mean
+    uint64_t minValue;
+    uint64_t maxValue;
+
+public:
+    LatencyHistogram() { Reset(); }
+    ~LatencyHistogram() {}
+
+    void Reset(void);
+
+    // Record a value, in nanoseconds
+    void Record(uint64_t ns)
+    {
+        counts[GetBucketIndex(ns)]++;
+        totalCount++;
+        sum += ns;
+        if (ns < minValue) minValue = ns;
+        if (ns > maxValue) maxValue = ns;
+    }
+
+    // Record a time, in seconds (negative values are recorded as 0)
+    void RecordTime(double sec)
+    { Record((sec > 0.0) ? static_cast<uint64_t>(sec*1.0e9+0.5) : 0); }
+
+    // Add the counts from another histogram
+    void Add(const LatencyHistogram &other);
+
+    // Same result as assignment, but only copies the buckets between the minimum and maximum
+    // values of either histogram (the other buckets are zero), which is usually a small fraction
+    void CopyFrom(const LatencyHistogram &other);
+
+    uint64_t GetCount(void) const { return totalCount; }
+
+    // Minimum, maximum and mean of recorded values, in nanoseconds (0 if no values)
+    uint64_t GetMin(void) const { return (totalCount > 0) ? minValue : 0; }
+    uint64_t GetMax(void) const { return maxValue; }
+    double GetMean(void) const
+    { return (totalCount > 0) ? static_cast<double>(sum)/totalCount : 0.0; }
+
+    // Returns the value (ns) at the specified percentile (0-100), i.e., the highest value
+    // in the bucket that contains the percentile (limited to the maximum recorded value).
+    uint64_t GetPercentile(double pct) const;
+
+    // Bucket access (e.g., for exporting the complete histogram)
+    static unsigned int GetBucketIndex(uint64_t ns);
+    static uint64_t GetBucketLowerBound(unsigned int index);
+    static uint64_t GetBucketUpperBound(unsigned int index);
+    uint32_t GetBucketCount(unsigned int index) const
+    { return (index < NUM_BUCKETS) ? counts[index] : 0; }
+
+    // Print count, min, mean, p50, p99, p99.9 and max (in microseconds) on one line
+    void PrintSummary(std::ostream &outStr) const;
+};
+
+inline unsigned int LatencyHistogram::GetBucketIndex(uint64_t ns)
+{
+    if (ns < 2*SUB_BUCKETS)
+        return static_cast<unsigned int>(ns);
+    // Find most significant bit
+#ifdef __GNUC__
+    unsigned int msb = 63-__builtin_clzll(ns);
+#else
+    unsigned int msb = 0;
+    uint64_t tmp = ns;
+    while (tmp >>= 1)
+        msb++;
+#endif
+    if (msb > MAX_MSB)
+        return NUM_BUCKETS-1;
+    unsigned int shift = msb-SUB_BUCKET_BITS;
+    return shift*SUB_BUCKETS + static_cast<unsigned int>(ns >> shift);
+}
+
+#endif // __LATENCY_HISTOGRAM_H__
@@ -0,0 +1,126 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __PORT_GROUP_H__
+#define __PORT_GROUP_H__
+
+#include <iostream>
+#include "Amp1394Types.h"
+
+class BasePort;
+struct PortGroupInternals;
+
+// Group of ports (e.g., one EthUdpPort per network interface, or one port per robot arm) that are
+// read and written in parallel, so that the cycle time does not increase with the number of ports.
+// After Start, each port is serviced by its own worker thread (Linux only), which can be pinned to
+// a CPU and given SCHED_FIFO priority. ReadAllBoards, WriteAllBoards and WriteReadAllBoards release
+// all workers at once and return when all of them have finished (barrier). If the worker threads
+// are not running (Start not called, or not Linux), the ports are serviced sequentially by the
+// calling thread.
+//
+// All ports of the group use the same timestamp for each cycle, which is used for the published
+// feedback of each port (see BasePort::SetCycleTimestamp) and returned by GetTiming.
+//
+// A port must not be used by other threads while it is in a group (as for any port). The group
+// can be used with CycleExecutor by setting its read and write callbacks, for example:
+//     bool GroupRead(BasePort &, void *data) { static_cast<PortGroup *>(data)->ReadAllBoards(); return true; }
+
+class PortGroup {
+public:
+    enum { MAX_PORTS = 8 };
+
+    // Timing of the last operation, in seconds. The start time of each port is relative to the
+    // start of the operation (when the workers were released).
+    struct PortTiming {
+        bool ok;                // true if the operation succeeded on this port
+        double start;           // start time (relative)
+        double duration;        // time for the operation on this port
+        PortTiming() : ok(false), start(0.0), duration(0.0) {}
+        ~PortTiming() {}
+    };
+    struct GroupTiming {
+        double timestamp;       // start of the operation (Amp1394_GetTime), same for all ports
+        double total;           // time until all ports finished
+        unsigned int numPorts;
+        PortTiming port[MAX_PORTS];
+        GroupTiming() : timestamp(0.0), total(0.0), numPorts(0) {}
+        ~GroupTiming() {}
+    };
+
+protected:
+    std::ostream &outStr;
+    BasePort *ports[MAX_PORTS];
+    int cpuNum[MAX_PORTS];          // CPU affinity of each worker (-1 to not change)
+    unsigned int numPorts;
+    int rtPriority;                 // SCHED_FIFO priority of the workers (0 to not change)
+    bool spinWait;                  // true if workers (and caller) spin rather than block
+    GroupTiming timing;
+    PortGroupInternals *internals;  // Worker threads (0 if not running)
+
+    enum Operation { OP_READ, OP_WRITE, OP_WRITE_READ, OP_EXIT };
+
+    // Perform the operation on the specified port (called by the worker thread)
+    void DoOperation(unsigned int index, int op, double startTime);
+
+    // Perform the operation on all ports (in parallel, if the workers are running)
+    bool RunOperation(int op);
+
+    // Worker thread (argument is WorkerInfo, see PortGroup.cpp)
+    static void *WorkerThread(void *arg);
+
+    // Prevent copies
+    PortGroup(const PortGroup &);
+    PortGroup& operator=(const PortGroup &);
+
+public:
+    PortGroup(std::ostream &debugStream = std::cerr);
+    ~PortGroup();   // calls Stop
+
+    // Add a port to the group (not while running); cpu is the CPU affinity of its worker thread
+    // (-1 to not change). Returns false if the group is full or running.
+    bool AddPort(BasePort *port, int cpu = -1);
+
+    unsigned int GetNumPorts(void) const { return numPorts; }
+    BasePort *GetPort(unsigned int index) const { return (index < numPorts) ? ports[index] : 0; }
+
+    // SCHED_FIFO priority of the worker threads (0, the default, to not change); set before Start
+    void SetRealtimePriority(int priority) { rtPriority = priority; }
+
+    // If true, the worker threads spin while waiting for the next operation and the calling thread
+    // spins while waiting for the workers, which avoids the wakeup latency of a blocking wait but
+    // uses 100% of a CPU core per thread. Set before Start (default is false).
+    void SetSpinWait(bool spin) { spinWait = spin; }
+
+    // Start the worker threads (Linux only). Returns false if the threads could not be created
+    // or their priority/affinity could not be set (in which case none are running).
+    bool Start(void);
+
+    // Stop the worker threads
+    void Stop(void);
+
+    bool IsRunning(void) const { return (internals != 0); }
+
+    // Call ReadAllBoards, WriteAllBoards or WriteReadAllBoards on all ports.
+    // Returns true if successful on all ports.
+    bool ReadAllBoards(void);
+    bool WriteAllBoards(void);
+    bool WriteReadAllBoards(void);
+
+    // Get the timing of the last operation
+    void GetTiming(GroupTiming &groupTiming) const { groupTiming = timing; }
+    double GetTimestamp(void) const { return timing.timestamp; }
+};
+
+#endif // __PORT_GROUP_H__
@@ -0,0 +1,120 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __PORT_REQUEST_H__
+#define __PORT_REQUEST_H__
+
+#include "BoardIO.h"
+
+// Register access (quadlet or block read/write) requested by a non real-time thread (e.g., to read
+// the Ethernet status or the motor configuration), which is performed by the thread that does the
+// real-time I/O on the port (see BasePort::QueueRequest). This avoids using the port from two
+// threads at once, which is not supported.
+//
+// The request is owned by the caller and must remain valid until it is done (IsDone returns true),
+// even if Cancel was called. The result is obtained by polling the status (e.g., using Wait), so
+// that the real-time thread never blocks on the requesting thread.
+//
+// Example:
+//     PortRequest req;
+//     req.SetReadQuadlet(boardId, 0);       // status register
+//     port->QueueRequest(&req);
+//     if (req.Wait(0.1))
+//         status = req.GetQuadlet();
+//     else {
+//         req.Cancel();
+//         req.Wait();                       // request must remain valid until done
+//     }
+
+class PortRequest {
+public:
+    enum RequestType { READ_QUADLET, WRITE_QUADLET, READ_BLOCK, WRITE_BLOCK };
+    enum RequestStatus { REQ_IDLE, REQ_QUEUED, REQ_DONE, REQ_FAILED, REQ_CANCELLED };
+
+protected:
+    friend class PortRequestQueue;
+    friend class BasePort;
+
+    RequestType type;
+    unsigned char boardId;
+    nodeaddr_t addr;
+    quadlet_t data;             // Data for WRITE_QUADLET, or result of READ_QUADLET
+    quadlet_t *buffer;          // Data for READ_BLOCK or WRITE_BLOCK (owned by caller)
+    unsigned int nbytes;
+    volatile int status;        // RequestStatus
+    volatile int cancel;        // Non-zero if cancel requested
+    PortRequest *next;          // Link for PortRequestQueue
+
+    // Set the status (with release semantics, so that the result is visible to the requester)
+    void SetStatus(RequestStatus newStatus);
+
+    // Returns true if Cancel was called
+    bool IsCancelRequested(void) const;
+
+    // Prevent copies
+    PortRequest(const PortRequest &);
+    PortRequest& operator=(const PortRequest &);
+
+public:
+    PortRequest();
+    ~PortRequest() {}
+
+    // Set up the request (only when not queued)
+    void SetReadQuadlet(unsigned char board, nodeaddr_t address);
+    void SetWriteQuadlet(unsigned char board, nodeaddr_t address, quadlet_t wdata);
+    void SetReadBlock(unsigned char board, nodeaddr_t address, quadlet_t *rdata, unsigned int numBytes);
+    void SetWriteBlock(unsigned char board, nodeaddr_t address, quadlet_t *wdata, unsigned int numBytes);
+
+    RequestType GetType(void) const { return type; }
+    RequestStatus GetStatus(void) const;
+
+    // Returns true if the request is not queued (i.e., done, failed or cancelled)
+    bool IsDone(void) const { return (GetStatus() != REQ_QUEUED); }
+
+    // Wait until the request is done, checking the status every pollSec seconds. If timeoutSec is
+    // negative, waits forever. Returns true if the request completed successfully (REQ_DONE).
+    bool Wait(double timeoutSec = -1.0, double pollSec = 0.0001) const;
+
+    // Result of READ_QUADLET
+    quadlet_t GetQuadlet(void) const { return data; }
+
+    // Request cancellation; a request that was not yet started is discarded (REQ_CANCELLED)
+    void Cancel(void);
+};
+
+// Queue of requests, where any thread can add requests (Push) and a single thread (the one doing the
+// real-time I/O) removes them (Pop). Push is lock-free (compare-and-swap on a linked list).
+
+class PortRequestQueue {
+protected:
+    PortRequest * volatile head;     // Requests pushed by other threads (most recent first)
+    PortRequest *pendingHead;        // Requests taken from head, oldest first (only used by Pop)
+
+    // Prevent copies
+    PortRequestQueue(const PortRequestQueue &);
+    PortRequestQueue& operator=(const PortRequestQueue &);
+
+public:
+    PortRequestQueue() : head(0), pendingHead(0) {}
+    ~PortRequestQueue() {}
+
+    // Add request to queue (any thread). Returns false if the request is already queued.
+    bool Push(PortRequest *req);
+
+    // Remove the oldest request (single consumer thread). Returns 0 if the queue is empty.
+    PortRequest *Pop(void);
+};
+
+#endif // __PORT_REQUEST_H__
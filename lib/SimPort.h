@@ -0,0 +1,132 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#ifndef __SimPort_H__
+#define __SimPort_H__
+
+#include <ostream>
+#include "BoardIO.h"
+#include "BasePort.h"
+
+class FpgaEmulator;
+
+// Maximum data size for SimPort reads and writes, in bytes. Unlike Firewire (MAX_POSSIBLE_DATA_SIZE),
+// there is no packet size limit, so this is large enough for the hub (broadcast) read of 16 boards
+// with the largest read size (64 quadlets per board, plus 1 quadlet).
+const unsigned int SIM_MAX_DATA_SIZE = (BoardIO::MAX_BOARDS*64+1)*sizeof(quadlet_t);
+
+// In-process port that communicates with emulated boards (FpgaEmulator) rather than with
+// hardware, so there is no socket or system call in any transaction. This allows the CPU cost
+// of the library (e.g., ReadAllBoardsBroadcast, AmpIO::SetReadData, EncoderVelocity) to be
+// measured without network noise. Boards are numbered 0 to numBoards-1.
+
+class SimPort : public BasePort {
+protected:
+
+    FpgaEmulator *emulator;
+    unsigned int NumSimBoards;
+    unsigned long SimFirmwareVersion;
+    unsigned long SimHardwareVersion;
+
+    // Check whether the emulated bus generation has changed (i.e., bus reset)
+    void CheckEmulatorGeneration(void);
+
+    //! Read quadlet from node (internal method called by ReadQuadlet).
+    //  Parameter "flags" is not used for SimPort
+    bool ReadQuadletNode(nodeid_t node, nodeaddr_t addr, quadlet_t &data, unsigned char flags = 0);
+
+    //! Write quadlet to node (internal method called by WriteQuadlet)
+    //  Parameter "flags" is not used for SimPort
+    bool WriteQuadletNode(nodeid_t node, nodeaddr_t addr, quadlet_t data, unsigned char flags = 0);
+
+    // Initialize port (create emulated boards)
+    bool Init(void);
+
+    // Cleanup port
+    void Cleanup(void);
+
+    // Initialize nodes on the bus; called by ScanNodes
+    // \return Maximum number of nodes on bus (0 if error)
+    nodeid_t InitNodes(void);
+
+    // Write the broadcast packet containing the DAC values and power control
+    bool WriteBroadcastOutput(quadlet_t *buffer, unsigned int size);
+
+    // Write a block to the specified node. Internal method called by WriteBlock and
+    // WriteAllBoardsBroadcast.
+    // Parameter "flags" is not used for SimPort.
+    bool WriteBlockNode(nodeid_t node, nodeaddr_t addr, quadlet_t *wdata,
+                        unsigned int nbytes, unsigned char flags = 0);
+
+    // Read a block from the specified node. Internal method called by ReadBlock.
+    // Parameter "flags" is not used for SimPort.
+    bool ReadBlockNode(nodeid_t node, nodeaddr_t addr, quadlet_t *rdata,
+                       unsigned int nbytes, unsigned char flags = 0);
+
+public:
+    // Initialize port with the specified number of emulated boards, firmware version (6-8),
+    // and hardware version (QLA1_String, DQLA_String or dRA1_String)
+    SimPort(int numBoards = 4, std::ostream &debugStream = std::cerr,
+            unsigned long fwVersion = 8, unsigned long hwVersion = QLA1_String);
+    ~SimPort();
+
+    // Access to the emulated boards (e.g., to simulate a bus reset)
+    FpgaEmulator *GetEmulator(void) const { return emulator; }
+
+    //****************** BasePort pure virtual methods ***********************
+
+    PortType GetPortType(void) const { return PORT_SIM; }
+
+    int NumberOfUsers(void) { return 1; }
+
+    bool IsOK(void) { return (emulator != 0); }
+
+    unsigned int GetBusGeneration(void) const;
+
+    void UpdateBusGeneration(unsigned int gen);
+
+    unsigned int GetPrefixOffset(MsgType) const   { return 0; }
+    unsigned int GetWritePostfixSize(void) const  { return 0; }
+    unsigned int GetReadPrefixSize(void) const    { return 0; }
+    unsigned int GetReadPostfixSize(void) const   { return 0; }
+
+    unsigned int GetWriteQuadAlign(void) const    { return 0; }
+    unsigned int GetReadQuadAlign(void) const     { return 0; }
+
+    // Get the maximum number of data bytes that can be read
+    // (via ReadBlock) or written (via WriteBlock).
+    unsigned int GetMaxReadDataSize(void) const  { return SIM_MAX_DATA_SIZE; }
+    unsigned int GetMaxWriteDataSize(void) const { return SIM_MAX_DATA_SIZE; }
+
+    /*!
+     \brief Write the broadcast read request
+    */
+    bool WriteBroadcastReadRequest(unsigned int seq);
+
+    /*!
+     \brief Wait for broadcast read data to be available
+     No wait is needed because the emulated hub data is updated immediately.
+    */
+    void WaitBroadcastRead(void) {}
+
+    /*!
+     \brief Add delay (if needed) for PROM I/O operations
+     The delay is 0 for SimPort.
+    */
+    void PromDelay(void) const {}
+
+};
+
+#endif // __SimPort_H__
@@ -0,0 +1,127 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include "Amp1394BSwap.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BSWAP_HAS_SSE2 1
+#include <emmintrin.h>
+// With GCC/Clang, the AVX2 version is compiled with the target attribute and selected at runtime,
+// so that the library does not need to be compiled with -mavx2
+#if defined(__GNUC__)
+#define BSWAP_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BSWAP_HAS_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef void (*BSwapBlockFunc)(uint32_t *dst, const uint32_t *src, unsigned int numQuads);
+
+static void BSwapBlockScalar(uint32_t *dst, const uint32_t *src, unsigned int numQuads)
+{
+    for (unsigned int i = 0; i < numQuads; i++)
+        dst[i] = bswap_32(src[i]);
+}
+
+#ifdef BSWAP_HAS_SSE2
+static void BSwapBlockSSE2(uint32_t *dst, const uint32_t *src, unsigned int numQuads)
+{
+    // SSE2 does not have a byte shuffle, so swap the bytes in each 16-bit word and
+    // then swap the 16-bit words in each quadlet
+    unsigned int i;
+    for (i = 0; i+4 <= numQuads; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src+i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst+i), v);
+    }
+    BSwapBlockScalar(dst+i, src+i, numQuads-i);
+}
+#endif
+
+#ifdef BSWAP_HAS_AVX2
+__attribute__((target("avx2")))
+static void BSwapBlockAVX2(uint32_t *dst, const uint32_t *src, unsigned int numQuads)
+{
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    unsigned int i;
+    for (i = 0; i+8 <= numQuads; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src+i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst+i), _mm256_shuffle_epi8(v, mask));
+    }
+    BSwapBlockSSE2(dst+i, src+i, numQuads-i);
+}
+#endif
+
+#ifdef BSWAP_HAS_NEON
+static void BSwapBlockNEON(uint32_t *dst, const uint32_t *src, unsigned int numQuads)
+{
+    unsigned int i;
+    for (i = 0; i+4 <= numQuads; i += 4) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(src+i));
+        vst1q_u8(reinterpret_cast<uint8_t *>(dst+i), vrev32q_u8(v));
+    }
+    BSwapBlockScalar(dst+i, src+i, numQuads-i);
+}
+#endif
+
+static void BSwapBlockSelect(uint32_t *dst, const uint32_t *src, unsigned int numQuads);
+
+// Initially points to BSwapBlockSelect, which selects the implementation on the first call
+// (this avoids depending on the order of static initialization)
+static BSwapBlockFunc bswapBlockFunc = BSwapBlockSelect;
+static const char *bswapBlockName = "none";
+
+static void BSwapBlockSelect(uint32_t *dst, const uint32_t *src, unsigned int numQuads)
+{
+    BSwapBlockFunc func = BSwapBlockScalar;
+    bswapBlockName = "scalar";
+#if defined(BSWAP_HAS_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        func = BSwapBlockAVX2;
+        bswapBlockName = "avx2";
+    }
+    else {
+        func = BSwapBlockSSE2;
+        bswapBlockName = "sse2";
+    }
+#elif defined(BSWAP_HAS_SSE2)
+    func = BSwapBlockSSE2;
+    bswapBlockName = "sse2";
+#elif defined(BSWAP_HAS_NEON)
+    func = BSwapBlockNEON;
+    bswapBlockName = "neon";
+#endif
+    // Selection is idempotent, so it does not matter if several threads do it concurrently
+    bswapBlockFunc = func;
+    func(dst, src, numQuads);
+}
+
+void Amp1394_BSwapBlock(uint32_t *dst, const uint32_t *src, unsigned int numQuads)
+{
+    bswapBlockFunc(dst, src, numQuads);
+}
+
+const char *Amp1394_GetBSwapBlockName(void)
+{
+    if (bswapBlockFunc == BSwapBlockSelect)
+        BSwapBlockSelect(0, 0, 0);
+    return bswapBlockName;
+}
@@ -13,6 +13,7 @@ http://www.cisst.org/cisst/license.txt.
 --- end cisst license ---
 */
 
+#include <Amp1394/AmpIORevision.h>
 #include "Amp1394Time.h"
 
 #include <time.h>
@@ -24,29 +25,131 @@ http://www.cisst.org/cisst/license.txt.
 #include <unistd.h>
 #endif
 
-// See osaGetTime.cpp (cisstOSAbstraction) if support for other platforms needed.
+#if Amp1394_USE_TSC && defined(__x86_64__) && defined(__GNUC__)
+#define AMP1394_TSC_AVAILABLE 1
+#include <cpuid.h>
+#include <x86intrin.h>
+#else
+#define AMP1394_TSC_AVAILABLE 0
+#endif
 
-double Amp1394_GetTime(void)
+#ifndef _MSC_VER
+#ifdef CLOCK_MONOTONIC_RAW
+// Not affected by NTP frequency adjustments
+#define AMP1394_CLOCK_ID    CLOCK_MONOTONIC_RAW
+#define AMP1394_CLOCK_NAME  "CLOCK_MONOTONIC_RAW"
+#else
+#define AMP1394_CLOCK_ID    CLOCK_MONOTONIC
+#define AMP1394_CLOCK_NAME  "CLOCK_MONOTONIC"
+#endif
+#endif
+
+// Returns the time (in nanoseconds) from the monotonic clock provided by the OS
+static int64_t GetClockNs(void)
 {
 #ifdef _MSC_VER
     LARGE_INTEGER liTimerFrequency, liTimeNow;
-    double timerFrequency, time;
     // According to MSDN, these functions are guaranteed to work
     // on Windows XP or later.
     if ((QueryPerformanceCounter(&liTimeNow) == 0) ||
         (QueryPerformanceFrequency(&liTimerFrequency) == 0)) {
-	 // No performance counter available
-	 return 0.0;
+        // No performance counter available
+        return 0;
     }
-    timerFrequency = (double)liTimerFrequency.QuadPart;
     // Also, the frequency is guaranteed to be non-zero on Windows XP or later.
-    if (timerFrequency == 0.0) return 0.0;
-    time = (double)liTimeNow.QuadPart/timerFrequency;
-    return time;
+    if (liTimerFrequency.QuadPart == 0) return 0;
+    // Split into seconds and remainder to avoid overflow
+    int64_t sec = liTimeNow.QuadPart/liTimerFrequency.QuadPart;
+    int64_t rem = liTimeNow.QuadPart%liTimerFrequency.QuadPart;
+    return sec*1000000000LL + (rem*1000000000LL)/liTimerFrequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(AMP1394_CLOCK_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec)*1000000000LL + ts.tv_nsec;
+#endif
+}
+
+#if AMP1394_TSC_AVAILABLE
+
+// Conversion from TSC to nanoseconds, calibrated against the monotonic clock (see TscCalibration).
+// The TSC is only used if it is invariant (i.e., runs at a constant rate in all power states).
+struct TscInfo {
+    bool valid;
+    uint64_t tscBase;
+    int64_t nsBase;
+    uint64_t mult;     // nanoseconds per tick, as 32.32 fixed-point
+};
+
+static TscInfo tscInfo = { false, 0, 0, 0 };
+
+// Reads the TSC and the monotonic clock, at approximately the same time
+static void TscSample(uint64_t &tsc, int64_t &ns)
+{
+    // Use the sample with the shortest time between TSC reads, to minimize the effect of interrupts
+    uint64_t bestDelta = ~static_cast<uint64_t>(0);
+    for (int i = 0; i < 5; i++) {
+        uint64_t t1 = __rdtsc();
+        int64_t clk = GetClockNs();
+        uint64_t t2 = __rdtsc();
+        if (t2-t1 < bestDelta) {
+            bestDelta = t2-t1;
+            tsc = t1 + (t2-t1)/2;
+            ns = clk;
+        }
+    }
+}
+
+// Calibrate the TSC when the library is loaded (takes about 20 msec)
+static struct TscCalibration {
+    TscCalibration()
+    {
+        unsigned int eax, ebx, ecx, edx;
+        // Invariant TSC is indicated by CPUID.80000007H:EDX[8]
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8)))
+            return;
+        uint64_t tsc0, tsc1;
+        int64_t ns0, ns1;
+        TscSample(tsc0, ns0);
+        struct timespec ts = { 0, 20000000L };
+        nanosleep(&ts, NULL);
+        TscSample(tsc1, ns1);
+        if ((tsc1 <= tsc0) || (ns1 <= ns0))
+            return;
+        tscInfo.mult = (static_cast<unsigned __int128>(ns1-ns0) << 32)/(tsc1-tsc0);
+        tscInfo.tscBase = tsc1;
+        tscInfo.nsBase = ns1;
+        tscInfo.valid = true;
+    }
+} tscCalibration;
+
+#endif
+
+int64_t Amp1394_GetTimeNs(void)
+{
+#if AMP1394_TSC_AVAILABLE
+    if (tscInfo.valid) {
+        uint64_t delta = __rdtsc() - tscInfo.tscBase;
+        return tscInfo.nsBase + static_cast<int64_t>((static_cast<unsigned __int128>(delta)*tscInfo.mult) >> 32);
+    }
+#endif
+    return GetClockNs();
+}
+
+double Amp1394_GetTime(void)
+{
+    return Amp1394_GetTimeNs()*1.0e-9;
+}
+
+const char *Amp1394_GetClockName(void)
+{
+#if AMP1394_TSC_AVAILABLE
+    if (tscInfo.valid)
+        return "TSC";
+#endif
+#ifdef _MSC_VER
+    return "QueryPerformanceCounter";
 #else
-    struct timeval currentTime;
-    gettimeofday(&currentTime, NULL);
-    return ((double) currentTime.tv_sec) + ((double)currentTime.tv_usec) * 1e-6;
+    return AMP1394_CLOCK_NAME;
 #endif
 }
 
@@ -116,29 +116,12 @@ AmpIO::~AmpIO()
 
 unsigned int AmpIO::GetReadNumBytes() const
 {
-    uint32_t fver = GetFirmwareVersion();
-    unsigned int numQuads;
-    if (fver < 7) {
-        numQuads = 4 + 4*NumEncoders;
-    } else if (fver == 7) {
-        numQuads = 4 + 6*NumEncoders;
-    }
-    else {
-        numQuads = 4 + 2*NumMotors + 5*NumEncoders;
-    }
-    return numQuads * sizeof(quadlet_t);
+    return layout.readNumQuads * sizeof(quadlet_t);
 }
 
 void AmpIO::SetReadData(const quadlet_t *buf)
 {
-    unsigned int numQuads = GetReadNumBytes() / sizeof(quadlet_t);
-    unsigned int i;
-    for (i = 0; i < numQuads; i++) {
-        ReadBuffer[i] = bswap_32(buf[i]);
-    }
-    for (i = 0; i < NumEncoders; i++) {
-        SetEncoderVelocityData(i);
-    }
+    (this->*layout.decodeRead)(buf);
     // Add 1 to timestamp because block read clears counter, rather than incrementing
     firmwareTime += (GetTimestamp()+1)*GetFPGAClockPeriod();
 }
@@ -149,17 +132,21 @@ void AmpIO::InitBoard(void)
     // and GetFirmwareVersion return the correct values.
     // If the port is not yet valid, these methods will both return 0, so board will be
     // initialized as a 4-axis QLA and assume firmware version < 8.
-    if (GetHardwareVersion() == dRA1_String) {
+    // The versions are saved in the layout, so that the real-time methods do not need to
+    // obtain them from the port.
+    layout.fwVersion = GetFirmwareVersion();
+    layout.hwVersion = GetHardwareVersion();
+    if (layout.hwVersion == dRA1_String) {
         NumMotors = 10;
         NumEncoders = 7;
         NumDouts = 0;
     }
-    else if (GetHardwareVersion() == DQLA_String) {
+    else if (layout.hwVersion == DQLA_String) {
         NumMotors = 8;
         NumEncoders = 8;
         NumDouts = 8;
     }
-    else if (GetHardwareVersion() == BCFG_String) {
+    else if (layout.hwVersion == BCFG_String) {
         NumMotors = 0;
         NumEncoders = 0;
         NumDouts = 0;
@@ -170,6 +157,55 @@ void AmpIO::InitBoard(void)
         NumDouts = 4;
     }
 
+    // Real-time read and write sizes, in quadlets
+    if (layout.fwVersion < 7)
+        layout.readNumQuads = 4 + 4*NumEncoders;
+    else if (layout.fwVersion == 7)
+        layout.readNumQuads = 4 + 6*NumEncoders;
+    else
+        layout.readNumQuads = 4 + 2*NumMotors + 5*NumEncoders;
+    layout.writeNumQuads = (layout.fwVersion < 8) ? (NumMotors + 1) : (NumMotors + 2);
+
+    // Encoder velocity clock period and decoding
+    if (layout.fwVersion < 6) {
+        layout.encClockPeriod = VEL_PERD_OLD;
+        layout.decodeVelocity = &AmpIO::DecodeVelocityOld;
+    }
+    else if (layout.fwVersion == 6) {
+        layout.encClockPeriod = VEL_PERD_REV6;
+        layout.decodeVelocity = &AmpIO::DecodeVelocityRev6;
+    }
+    else {
+        layout.encClockPeriod = (layout.hwVersion == dRA1_String) ? VEL_PERD_ESPM : VEL_PERD;
+        layout.decodeVelocity = &AmpIO::DecodeVelocityRev7;
+    }
+
+    // Use the specialized decoders for the common configurations
+    layout.decodeRead = &AmpIO::DecodeReadGeneric;
+    layout.encodeWrite = &AmpIO::EncodeWriteGeneric;
+    if (layout.fwVersion == 7) {
+        if ((NumMotors == 4) && (NumEncoders == 4))
+            layout.decodeRead = &AmpIO::DecodeReadFixed<4, 4, false, false>;
+    }
+    else if (layout.fwVersion >= 8) {
+        if (layout.hwVersion == dRA1_String) {
+            if ((NumMotors == 10) && (NumEncoders == 7))
+                layout.decodeRead = &AmpIO::DecodeReadFixed<10, 7, true, true>;
+        }
+        else if ((NumMotors == 4) && (NumEncoders == 4))
+            layout.decodeRead = &AmpIO::DecodeReadFixed<4, 4, true, false>;
+        else if ((NumMotors == 8) && (NumEncoders == 8))
+            layout.decodeRead = &AmpIO::DecodeReadFixed<8, 8, true, false>;
+    }
+    if (layout.writeNumQuads == 5)
+        layout.encodeWrite = &AmpIO::EncodeWriteFixed<5>;     // QLA1, Rev 1-7
+    else if (layout.writeNumQuads == 6)
+        layout.encodeWrite = &AmpIO::EncodeWriteFixed<6>;     // QLA1, Rev 8
+    else if (layout.writeNumQuads == 10)
+        layout.encodeWrite = &AmpIO::EncodeWriteFixed<10>;    // DQLA, Rev 8
+    else if (layout.writeNumQuads == 12)
+        layout.encodeWrite = &AmpIO::EncodeWriteFixed<12>;    // dRA1, Rev 8
+
     // Check whether buffers are too small (should never happen, but if it does, would
     // be better to exit rather than just print a message). The alternative is to use
     // dynamic memory allocation.
@@ -191,7 +227,7 @@ void AmpIO::InitBoard(void)
     MOTOR_STATUS_OFFSET = ENC_RUN_OFFSET    + NumEncoders;
 
     WB_HEADER_OFFSET = 0;   // only used for Firmware Rev 8+
-    WB_CURR_OFFSET = (GetFirmwareVersion() < 8) ? 0 : 1;
+    WB_CURR_OFFSET = (layout.fwVersion < 8) ? 0 : 1;
     WB_CTRL_OFFSET = WB_CURR_OFFSET + NumMotors;
 
     for (size_t i = 0; i < NumEncoders; i++) {
@@ -203,7 +239,7 @@ void AmpIO::InitBoard(void)
 
 void AmpIO::InitWriteBuffer(void)
 {
-    if (GetFirmwareVersion() < 8) {
+    if (layout.fwVersion < 8) {
         WB_CURR_OFFSET = 0;
         WB_CTRL_OFFSET = WB_CURR_OFFSET + NumMotors;
         quadlet_t data = (BoardId & 0x0F) << 24;
@@ -223,17 +259,17 @@ void AmpIO::InitWriteBuffer(void)
 
 unsigned int AmpIO::GetWriteNumBytes(void) const
 {
-    unsigned int numQuads;
-    if (GetFirmwareVersion() < 8) {
-        numQuads = NumMotors + 1;
-    } else {
-        numQuads = NumMotors + 2;
-    }
-    return numQuads * sizeof(quadlet_t);
+    return layout.writeNumQuads * sizeof(quadlet_t);
 }
 
 bool AmpIO::GetWriteData(quadlet_t *buf, unsigned int offset, unsigned int numQuads, bool doSwap) const
 {
+    // Most common case: complete write buffer, with byteswap
+    if ((offset == 0) && (numQuads == layout.writeNumQuads) && doSwap) {
+        (this->*layout.encodeWrite)(buf);
+        return true;
+    }
+
     unsigned int WriteBufSize = GetWriteNumBytes() / sizeof(quadlet_t);
     if ((offset+numQuads) > WriteBufSize) {
         std::cerr << "AmpIO:GetWriteData: invalid args: " << offset << ", " << numQuads << std::endl;
@@ -245,10 +281,23 @@ bool AmpIO::GetWriteData(quadlet_t *buf, unsigned int offset, unsigned int numQu
     return true;
 }
 
+void AmpIO::EncodeWriteGeneric(quadlet_t *buf) const
+{
+    for (unsigned int i = 0; i < layout.writeNumQuads; i++)
+        buf[i] = bswap_32(WriteBuffer[i]);
+}
+
+template <unsigned int NUM_QUADS>
+void AmpIO::EncodeWriteFixed(quadlet_t *buf) const
+{
+    for (unsigned int i = 0; i < NUM_QUADS; i++)
+        buf[i] = bswap_32(WriteBuffer[i]);
+}
+
 bool AmpIO::WriteBufferResetsWatchdog(void) const
 {
     bool ret = true;
-    if (GetFirmwareVersion() < 8) {
+    if (layout.fwVersion < 8) {
         // For Firmware versions prior to Rev 7, we must check whether any DAC valid bit
         // is set. For now, we also perform this check for Firmware Rev 7, but it could
         // be removed. Starting with Firmware Rev 7, the power control quadlet is always
@@ -332,8 +381,8 @@ void AmpIO::DisplayReadBuffer(std::ostream &out) const
 
 bool AmpIO::HasQLA() const
 {
-    return (GetHardwareVersion() == QLA1_String) ||
-           (GetHardwareVersion() == DQLA_String);
+    return (layout.hwVersion == QLA1_String) ||
+           (layout.hwVersion == DQLA_String);
 }
 
 uint32_t AmpIO::GetStatus(void) const
@@ -365,10 +414,10 @@ uint8_t AmpIO::GetDigitalOutput(void) const
     uint8_t dout = static_cast<uint8_t>((~(ReadBuffer[DIGIO_OFFSET]>>12))&0x0000000f);
 
     // Firmware versions < 5 have bits in reverse order with respect to schematic
-    if (GetFirmwareVersion() < 5)
+    if (layout.fwVersion < 5)
         dout = BitReverse4[dout];
 
-    if (GetHardwareVersion() == DQLA_String) {
+    if (layout.hwVersion == DQLA_String) {
         dout |= static_cast<uint8_t>((~(ReadBuffer[DIGIO_OFFSET]>>24))&0x000000f0);
     }
     return dout;
@@ -377,7 +426,7 @@ uint8_t AmpIO::GetDigitalOutput(void) const
 uint8_t AmpIO::GetNegativeLimitSwitches(void) const
 {
     uint8_t neglim = static_cast<uint8_t>((this->GetDigitalInput()&0x00000f00)>>8);
-    if (GetHardwareVersion() == DQLA_String) {
+    if (layout.hwVersion == DQLA_String) {
         neglim |= static_cast<uint8_t>((this->GetDigitalInput()&0x0f000000)>>20);
     }
     return neglim;
@@ -386,7 +435,7 @@ uint8_t AmpIO::GetNegativeLimitSwitches(void) const
 uint8_t AmpIO::GetPositiveLimitSwitches(void) const
 {
     uint8_t poslim = static_cast<uint8_t>((this->GetDigitalInput()&0x000000f0)>>4);
-    if (GetHardwareVersion() == DQLA_String) {
+    if (layout.hwVersion == DQLA_String) {
         poslim |= static_cast<uint8_t>((this->GetDigitalInput()&0x00f000f0)>>16);
     }
     return poslim;
@@ -395,7 +444,7 @@ uint8_t AmpIO::GetPositiveLimitSwitches(void) const
 uint8_t AmpIO::GetHomeSwitches(void) const
 {
     uint8_t home = static_cast<uint8_t>(this->GetDigitalInput()&0x0000000f);
-    if (GetHardwareVersion() == DQLA_String) {
+    if (layout.hwVersion == DQLA_String) {
         home |= static_cast<uint8_t>((this->GetDigitalInput()&0x000f0000)>>12);
     }
     return home;
@@ -404,7 +453,7 @@ uint8_t AmpIO::GetHomeSwitches(void) const
 uint8_t AmpIO::GetEncoderChannelA(void) const
 {
     uint8_t encA;
-    if (GetHardwareVersion() == DQLA_String) {
+    if (layout.hwVersion == DQLA_String) {
         // This also works for QLA with Rev 8+
         encA = 0;
         for (unsigned int i = 0; i < NumEncoders; i++) {
@@ -427,7 +476,7 @@ bool AmpIO::GetEncoderChannelA(unsigned int index) const
 uint8_t AmpIO::GetEncoderChannelB(void) const
 {
     uint8_t encB;
-    if (GetHardwareVersion() == DQLA_String) {
+    if (layout.hwVersion == DQLA_String) {
         // This also works for QLA with Rev 8+
         encB = 0;
         for (unsigned int i = 0; i < NumEncoders; i++) {
@@ -450,7 +499,7 @@ bool AmpIO::GetEncoderChannelB(unsigned int index) const
 uint8_t AmpIO::GetEncoderIndex(void) const
 {
     uint8_t encI;
-    if (GetHardwareVersion() == DQLA_String) {
+    if (layout.hwVersion == DQLA_String) {
         // This also works for QLA with Rev 8+
         encI = 0;
         for (unsigned int i = 0; i < NumEncoders; i++) {
@@ -471,7 +520,7 @@ uint8_t AmpIO::GetAmpTemperature(unsigned int index) const
         temp = (ReadBuffer[TEMP_OFFSET]>>8) & 0x000000ff;
     else if (index == 1)
         temp = ReadBuffer[TEMP_OFFSET] & 0x000000ff;
-    else if (GetHardwareVersion() == DQLA_String) {
+    else if (layout.hwVersion == DQLA_String) {
         if (index == 2)
             temp = (ReadBuffer[TEMP_OFFSET]>>24) & 0x000000ff;
         else if (index == 3)
@@ -507,7 +556,7 @@ uint32_t AmpIO::GetMotorStatus(unsigned int index) const
     if (index >= NumMotors)
         return 0L;
 
-    if (GetFirmwareVersion() < 8)
+    if (layout.fwVersion < 8)
         return 0L;
 
     return static_cast<uint32_t>(ReadBuffer[index+MOTOR_STATUS_OFFSET]);
@@ -516,7 +565,7 @@ uint32_t AmpIO::GetMotorStatus(unsigned int index) const
 // For dRA1 only
 double AmpIO::GetMotorVoltageRatio(unsigned int index) const
 {
-    if (GetHardwareVersion() != dRA1_String)
+    if (layout.hwVersion != dRA1_String)
         return 0.0;
 
     if (index >= NumMotors) {
@@ -554,7 +603,7 @@ int32_t AmpIO::GetEncoderPosition(unsigned int index) const
 
 bool AmpIO::GetEncoderOverflow(unsigned int index) const
 {
-    if (GetHardwareVersion() == dRA1_String)
+    if (layout.hwVersion == dRA1_String)
         return false;
 
     if (index < NumEncoders) {
@@ -568,13 +617,7 @@ bool AmpIO::GetEncoderOverflow(unsigned int index) const
 
 double AmpIO::GetEncoderClockPeriod(void) const
 {
-    // Could instead return encVelData[0].clkPeriod
-    uint32_t fver = GetFirmwareVersion();
-    if (fver < 6)
-        return VEL_PERD_OLD;
-    else if (fver == 6)
-        return VEL_PERD_REV6;
-    return (GetHardwareVersion() == dRA1_String) ? VEL_PERD_ESPM : VEL_PERD;
+    return layout.encClockPeriod;
 }
 
 // Returns encoder velocity in counts/sec -> 4/period
@@ -655,12 +698,109 @@ int32_t AmpIO::GetEncoderMidRange(void)
     return ENC_MIDRANGE;
 }
 
+bool AmpIO::GetAxisFeedback(int32_t *positions, double *velocities, uint32_t *currents, uint32_t *pots,
+                            double percent_threshold) const
+{
+    if (!ValidRead())
+        return false;
+    // Local copies, since the compiler cannot assume that the output arrays do not alias the
+    // member data
+    const unsigned int numEnc = NumEncoders;
+    const unsigned int numMot = NumMotors;
+    unsigned int i;
+    if (positions) {
+        const quadlet_t *buf = ReadBuffer + ENC_POS_OFFSET;
+        for (i = 0; i < numEnc; i++)
+            positions[i] = static_cast<int32_t>(buf[i] & ENC_POS_MASK) - ENC_MIDRANGE;
+    }
+    if (velocities) {
+        for (i = 0; i < numEnc; i++)
+            velocities[i] = encVelData[i].GetEncoderVelocityPredicted(percent_threshold);
+    }
+    // Motor current and analog input (pot) are in the same quadlet
+    if (currents) {
+        const quadlet_t *buf = ReadBuffer + MOTOR_CURR_OFFSET;
+        for (i = 0; i < numMot; i++)
+            currents[i] = (buf[i] & MOTOR_CURR_MASK) & ADC_MASK;
+    }
+    if (pots) {
+        const quadlet_t *buf = ReadBuffer + ANALOG_POS_OFFSET;
+        for (i = 0; i < numMot; i++)
+            pots[i] = ((buf[i] & ANALOG_POS_MASK) >> 16) & ADC_MASK;
+    }
+    return true;
+}
+
+unsigned int AmpIO::GetNumAxesAll(const BasePort *port)
+{
+    unsigned int numAxes = 0;
+    if (!port)
+        return 0;
+    for (unsigned int bnum = 0; bnum < BoardIO::MAX_BOARDS; bnum++) {
+        const AmpIO *board = dynamic_cast<const AmpIO *>(port->GetBoard(bnum));
+        if (board)
+            numAxes += std::max(board->NumMotors, board->NumEncoders);
+    }
+    return numAxes;
+}
+
+unsigned int AmpIO::GetAxisFeedbackAll(const BasePort *port, int32_t *positions, double *velocities,
+                                       uint32_t *currents, uint32_t *pots, unsigned int maxAxes,
+                                       double percent_threshold)
+{
+    if (!port)
+        return 0;
+    const AmpIO *boards[BoardIO::MAX_BOARDS];
+    unsigned int numBoards = 0;
+    for (unsigned int bnum = 0; bnum < BoardIO::MAX_BOARDS; bnum++) {
+        const AmpIO *board = dynamic_cast<const AmpIO *>(port->GetBoard(bnum));
+        if (board)
+            boards[numBoards++] = board;
+    }
+    return GetAxisFeedbackAll(boards, numBoards, positions, velocities, currents, pots, maxAxes,
+                              percent_threshold);
+}
+
+unsigned int AmpIO::GetAxisFeedbackAll(const AmpIO * const *boards, unsigned int numBoards,
+                                       int32_t *positions, double *velocities,
+                                       uint32_t *currents, uint32_t *pots, unsigned int maxAxes,
+                                       double percent_threshold)
+{
+    unsigned int offset = 0;
+    for (unsigned int bnum = 0; bnum < numBoards; bnum++) {
+        const AmpIO *board = boards[bnum];
+        if (!board)
+            continue;
+        unsigned int numAxes = std::max(board->NumMotors, board->NumEncoders);
+        if (offset+numAxes > maxAxes)
+            return 0;
+        unsigned int numEnc = board->NumEncoders;
+        unsigned int numMot = board->NumMotors;
+        if (!board->GetAxisFeedback(positions ? positions+offset : 0, velocities ? velocities+offset : 0,
+                                    currents ? currents+offset : 0, pots ? pots+offset : 0,
+                                    percent_threshold))
+            numEnc = numMot = 0;
+        // Set the entries that do not exist (or are not valid) to 0
+        unsigned int i;
+        for (i = numEnc; i < numAxes; i++) {
+            if (positions) positions[offset+i] = 0;
+            if (velocities) velocities[offset+i] = 0.0;
+        }
+        for (i = numMot; i < numAxes; i++) {
+            if (currents) currents[offset+i] = 0;
+            if (pots) pots[offset+i] = 0;
+        }
+        offset += numAxes;
+    }
+    return offset;
+}
+
 bool AmpIO::SetEncoderVelocityData(unsigned int index)
 {
     if (index >= NumEncoders)
         return false;
 
-    uint32_t fver = GetFirmwareVersion();
+    uint32_t fver = layout.fwVersion;
     if (fver < 6) {
         encVelData[index].SetDataOld(ReadBuffer[ENC_VEL_OFFSET+index], (fver >= 4));
     }
@@ -668,7 +808,7 @@ bool AmpIO::SetEncoderVelocityData(unsigned int index)
         encVelData[index].SetDataRev6(ReadBuffer[ENC_VEL_OFFSET+index], ReadBuffer[ENC_QTR1_OFFSET+index]);
     }
     else {  // V7+
-        bool isESPM = (GetHardwareVersion() == dRA1_String);
+        bool isESPM = (layout.hwVersion == dRA1_String);
         encVelData[index].SetData(ReadBuffer[ENC_VEL_OFFSET+index], ReadBuffer[ENC_QTR1_OFFSET+index],
                                   ReadBuffer[ENC_QTR5_OFFSET+index], ReadBuffer[ENC_RUN_OFFSET+index], isESPM);
     }
@@ -679,6 +819,59 @@ bool AmpIO::SetEncoderVelocityData(unsigned int index)
     return true;
 }
 
+void AmpIO::DecodeReadGeneric(const quadlet_t *buf)
+{
+    Amp1394_BSwapBlock(ReadBuffer, buf, layout.readNumQuads);
+    (this->*layout.decodeVelocity)();
+}
+
+template <unsigned int NUM_MOTORS, unsigned int NUM_ENCODERS, bool HAS_MOTOR_STATUS, bool IS_ESPM>
+void AmpIO::DecodeReadFixed(const quadlet_t *buf)
+{
+    // Same offsets as computed by InitBoard
+    enum { POS = MOTOR_CURR_OFFSET + NUM_MOTORS,
+           VEL = POS  + NUM_ENCODERS,
+           QTR1 = VEL + NUM_ENCODERS,
+           QTR5 = QTR1 + NUM_ENCODERS,
+           RUN = QTR5 + NUM_ENCODERS,
+           NUM_QUADS = RUN + NUM_ENCODERS + (HAS_MOTOR_STATUS ? NUM_MOTORS : 0) };
+    Amp1394_BSwapBlock(ReadBuffer, buf, NUM_QUADS);
+    for (unsigned int i = 0; i < NUM_ENCODERS; i++) {
+        encVelData[i].SetData(ReadBuffer[VEL+i], ReadBuffer[QTR1+i], ReadBuffer[QTR5+i],
+                              ReadBuffer[RUN+i], IS_ESPM);
+        if (encVelData[i].IsEncoderError())
+            encErrorCount[i]++;
+    }
+}
+
+void AmpIO::DecodeVelocityOld(void)
+{
+    bool useRunCounter = (layout.fwVersion >= 4);
+    for (unsigned int i = 0; i < NumEncoders; i++)
+        encVelData[i].SetDataOld(ReadBuffer[ENC_VEL_OFFSET+i], useRunCounter);
+}
+
+void AmpIO::DecodeVelocityRev6(void)
+{
+    for (unsigned int i = 0; i < NumEncoders; i++)
+        encVelData[i].SetDataRev6(ReadBuffer[ENC_VEL_OFFSET+i], ReadBuffer[ENC_QTR1_OFFSET+i]);
+}
+
+void AmpIO::DecodeVelocityRev7(void)
+{
+    bool isESPM = (layout.hwVersion == dRA1_String);
+    const quadlet_t *velBuf = ReadBuffer + ENC_VEL_OFFSET;
+    const quadlet_t *qtr1Buf = ReadBuffer + ENC_QTR1_OFFSET;
+    const quadlet_t *qtr5Buf = ReadBuffer + ENC_QTR5_OFFSET;
+    const quadlet_t *runBuf = ReadBuffer + ENC_RUN_OFFSET;
+    for (unsigned int i = 0; i < NumEncoders; i++) {
+        encVelData[i].SetData(velBuf[i], qtr1Buf[i], qtr5Buf[i], runBuf[i], isESPM);
+        // Increment error counter if necessary
+        if (encVelData[i].IsEncoderError())
+            encErrorCount[i]++;
+    }
+}
+
 bool AmpIO::GetEncoderVelocityData(unsigned int index, EncoderVelocity &data) const
 {
     if (index >= NumEncoders)
@@ -722,7 +915,7 @@ bool AmpIO::GetPowerStatus(unsigned int index) const
     // Bit 19: MV_GOOD
     uint32_t status = GetStatus();
     bool ret = status & MV_GOOD_BIT;
-    if (GetHardwareVersion() == DQLA_String) {
+    if (layout.hwVersion == DQLA_String) {
         uint32_t mask = 0;
         if (index&1) mask |= DQLA_MV_GOOD_1;
         if (index&2) mask |= DQLA_MV_GOOD_2;
@@ -735,7 +928,7 @@ bool AmpIO::GetPowerStatus(unsigned int index) const
 bool AmpIO::GetPowerFault(void) const
 {
     bool ret = false;
-    if (GetHardwareVersion() == QLA1_String) {
+    if (layout.hwVersion == QLA1_String) {
         // Bit 15: motor power fault
         ret = GetStatus() & QLA_MV_FAULT_BIT;
     }
@@ -752,7 +945,7 @@ bool AmpIO::GetSafetyRelayStatus(void) const
 {
     // DQLA does not have this feedback (uses LEDs instead),
     // so we just return true if the relay should be on.
-    if (GetHardwareVersion() == DQLA_String)
+    if (layout.hwVersion == DQLA_String)
         return GetSafetyRelay();
 
     // Bit 17
@@ -771,7 +964,7 @@ bool AmpIO::GetAmpEnable(unsigned int index) const
         return false;
 
     bool ret;
-    if (GetFirmwareVersion() < 8) {
+    if (layout.fwVersion < 8) {
         uint32_t mask = (0x00000001 << index);
         ret = GetStatus()&mask;
     }
@@ -784,7 +977,7 @@ bool AmpIO::GetAmpEnable(unsigned int index) const
 uint8_t AmpIO::GetAmpEnableMask(void) const
 {
     uint8_t ampEnable = 0;
-    if (GetHardwareVersion() == QLA1_String) {
+    if (layout.hwVersion == QLA1_String) {
         // For the QLA, the following is more efficient than the general case
         ampEnable = GetStatus()&0x0000000f;
     }
@@ -803,7 +996,7 @@ bool AmpIO::GetAmpStatus(unsigned int index) const
         return false;
 
     bool ret = false;
-    if (GetFirmwareVersion() < 8) {
+    if (layout.fwVersion < 8) {
         uint32_t mask = (0x00000100 << index);
         ret = GetStatus()&mask;
     }
@@ -819,10 +1012,10 @@ bool AmpIO::GetSafetyAmpDisable(unsigned int index) const
         return false;
 
     bool ret = false;
-    if (GetHardwareVersion() == QLA1_String) {
+    if (layout.hwVersion == QLA1_String) {
         ret = GetStatus() & (1 << index);
     }
-    else if (GetHardwareVersion() == DQLA_String) {
+    else if (layout.hwVersion == DQLA_String) {
         ret = ReadBuffer[MOTOR_STATUS_OFFSET + index] & MSTAT_SAFETY_DIS;
     }
     return ret;
@@ -831,10 +1024,10 @@ bool AmpIO::GetSafetyAmpDisable(unsigned int index) const
 uint32_t AmpIO::GetSafetyAmpDisable(void) const
 {
     uint32_t ampStatus = 0;
-    if (GetHardwareVersion() == QLA1_String) {
+    if (layout.hwVersion == QLA1_String) {
         ampStatus = (GetStatus() & 0x000000F0) >> 4;
     }
-    else if (GetHardwareVersion() == DQLA_String) {
+    else if (layout.hwVersion == DQLA_String) {
         for (unsigned int i = 0; i < NumMotors; i++) {
             if (GetSafetyAmpDisable(i))
                 ampStatus |= (1 << i);
@@ -845,7 +1038,7 @@ uint32_t AmpIO::GetSafetyAmpDisable(void) const
 
 uint32_t AmpIO::GetAmpFaultCode(unsigned int index) const
 {
-    if (GetFirmwareVersion() < 8) {
+    if (layout.fwVersion < 8) {
         // Could pick fault bits from other registers
         return 0;
     }
@@ -855,9 +1048,9 @@ uint32_t AmpIO::GetAmpFaultCode(unsigned int index) const
 bool AmpIO::IsQLAExpanded(unsigned int index) const
 {
     bool ret = false;
-    if (GetHardwareVersion() == QLA1_String)
+    if (layout.hwVersion == QLA1_String)
         ret = GetStatus() & 0x00001000;
-    else if (GetHardwareVersion() == DQLA_String)
+    else if (layout.hwVersion == DQLA_String)
         ret = GetStatus() & (index&0x0003);
     return ret;
 }
@@ -880,7 +1073,7 @@ bool AmpIO::SetAmpEnable(unsigned int index, bool state)
     if (index >= NumMotors)
         return false;
 
-    if (GetFirmwareVersion() < 8) {
+    if (layout.fwVersion < 8) {
         uint32_t enable_mask = 0x00000100 << index;
         uint32_t state_mask  = 0x00000001 << index;
         WriteBuffer[WB_CTRL_OFFSET] |=  enable_mask;
@@ -901,7 +1094,7 @@ bool AmpIO::SetAmpEnable(unsigned int index, bool state)
 
 bool AmpIO::SetAmpEnableMask(uint32_t mask, uint32_t state)
 {
-    if (GetFirmwareVersion() < 8) {
+    if (layout.fwVersion < 8) {
         uint32_t enable_mask = static_cast<uint32_t>(mask) << 8;
         uint32_t state_clr_mask = static_cast<uint32_t>(mask);
         uint32_t state_set_mask = static_cast<uint32_t>(state);
@@ -935,7 +1128,7 @@ bool AmpIO::SetMotorCurrent(unsigned int index, uint32_t sdata)
     quadlet_t data = VALID_BIT | (sdata & DAC_MASK);
     if (collect_state && (collect_chan == (index+1)))
         data |= COLLECT_BIT;
-    if (GetFirmwareVersion() < 8) {
+    if (layout.fwVersion < 8) {
         data |= ((BoardId & 0x0F) << 24);
     }
     else {
@@ -950,7 +1143,7 @@ bool AmpIO::SetMotorVoltage(unsigned int index, uint32_t volts)
 {
     if (index >= NumMotors)
         return false;
-    if (GetFirmwareVersion() < 8)
+    if (layout.fwVersion < 8)
         return false;
     // Could check MotorConfig to verify that voltage control is available
     // (MCFG_VOLTAGE_CONTROL); firmware will ignore voltage command if voltage
@@ -967,7 +1160,7 @@ bool AmpIO::SetMotorVoltage(unsigned int index, uint32_t volts)
 
 bool AmpIO::SetMotorVoltage(unsigned int index, double volts)
 {
-    if (GetHardwareVersion() == dRA1_String)
+    if (layout.hwVersion == dRA1_String)
         return false;
 
     const double Volts2BitsQLA = 65535/91.0;   // 91.0 = 36.4*2.5
@@ -979,7 +1172,7 @@ bool AmpIO::SetMotorVoltage(unsigned int index, double volts)
 
 bool AmpIO::SetMotorVoltageRatio(unsigned int index, double ratio)
 {
-    if (GetHardwareVersion() != dRA1_String)
+    if (layout.hwVersion != dRA1_String)
         return false;
 
     if (index < NumMotors) {
@@ -27,10 +27,48 @@ http://www.cisst.org/cisst/license.txt.
 #include "Amp1394Time.h"
 #include "Amp1394BSwap.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 // Starting with C++11, can initialize using an initializer list.
 // Currently, the supported hardware (e.g., QLA1) is added in the BasePort constructor.
 std::vector<unsigned long> BasePort::SupportedHardware;
 
+// Atomic operations for the latency statistics, which are published by the real-time thread
+// (see RecordLatency) and read by any thread (see GetLatencySnapshot and FeedbackSnapshot.cpp).
+// With MSVC (x86/x64 only), volatile accesses have acquire/release semantics and the hardware
+// does not reorder loads with loads or stores with stores, so a compiler barrier is sufficient.
+#if defined(__GNUC__)
+static inline uint32_t LoadAcquire(const volatile uint32_t *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline uint32_t LoadRelaxed(const volatile uint32_t *p) { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+static inline void StoreRelease(volatile uint32_t *p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline void StoreRelaxed(volatile uint32_t *p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_RELAXED); }
+static inline void FenceAcquire(void) { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+static inline void FenceRelease(void) { __atomic_thread_fence(__ATOMIC_RELEASE); }
+static inline int LoadAcquireInt(const volatile int *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void StoreReleaseInt(volatile int *p, int v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline int ExchangeInt(volatile int *p, int v) { return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL); }
+#else
+static inline uint32_t LoadAcquire(const volatile uint32_t *p) { return *p; }
+static inline uint32_t LoadRelaxed(const volatile uint32_t *p) { return *p; }
+static inline void StoreRelease(volatile uint32_t *p, uint32_t v) { *p = v; }
+static inline void StoreRelaxed(volatile uint32_t *p, uint32_t v) { *p = v; }
+static inline void FenceAcquire(void) { _ReadWriteBarrier(); }
+static inline void FenceRelease(void) { _ReadWriteBarrier(); }
+static inline int LoadAcquireInt(const volatile int *p) { return *p; }
+static inline void StoreReleaseInt(volatile int *p, int v) { *p = v; }
+static inline int ExchangeInt(volatile int *p, int v)
+{ return _InterlockedExchange(reinterpret_cast<volatile long *>(p), v); }
+#endif
+
+// Round pointer up to a multiple of align (power of 2)
+static unsigned char *AlignPointer(unsigned char *ptr, size_t align)
+{
+    uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    return ptr + ((align - (addr&(align-1)))&(align-1));
+}
+
 void BasePort::BroadcastReadInfo::PrintTiming(std::ostream &outStr, bool newLine) const
 {
     outStr << "Updates (usec): ";
@@ -64,7 +102,20 @@ BasePort::BasePort(int portNum, std::ostream &ostr):
         NumOfBoards_(0),
         BoardInUseMask_(0),
         max_board(0),
-        HubBoard(BoardIO::MAX_BOARDS)
+        HubBoard(BoardIO::MAX_BOARDS),
+        bcWaitMode(BC_WAIT_FIXED),
+        bcWaitTime(0.0),
+        bcWaitUsed(0.0),
+        bcRequestTime(0.0),
+        latencyEnabled(true),
+        latencyResetRequested(0),
+        latencyPubLatest(1),
+        latReadStart(0),
+        latReadSent(0),
+        feedbackEnabled(false),
+        feedbackSnap(0),
+        cycleTimestamp(0.0),
+        requestsPerCycle(1)
 {
     size_t i;
     for (i = 0; i < BoardIO::MAX_BOARDS; i++) {
@@ -74,9 +125,20 @@ BasePort::BasePort(int portNum, std::ostream &ostr):
         HardwareVersion[i] = 0;
         Board2Node[i] = MAX_NODES;
     }
+    latencyResetTime = Amp1394_GetTimeNs();
+    for (i = 0; i < 2; i++) {
+        latencyPub[i].resetTime = latencyResetTime;
+        latencyPubSeq[i] = 0;
+    }
     ReadBufferBroadcast = 0;
     WriteBufferBroadcast = 0;
     GenericBuffer = 0;
+    ReadBufferBoards = 0;
+    WriteBufferBoards = 0;
+    ReadBoardsMem = 0;
+    WriteBoardsMem = 0;
+    ReadSlotSize = 0;
+    WriteSlotSize = 0;
     for (i = 0; i < MAX_NODES; i++)
         Node2Board[i] = BoardIO::MAX_BOARDS;
     // Note that AddHardwareVersion will not add duplicates
@@ -89,9 +151,15 @@ BasePort::BasePort(int portNum, std::ostream &ostr):
 
 BasePort::~BasePort()
 {
+    // Requests can no longer be processed
+    PortRequest *req;
+    while ((req = requestQueue.Pop()) != 0)
+        req->SetStatus(PortRequest::REQ_CANCELLED);
     delete [] ReadBufferBroadcast;
     delete [] WriteBufferBroadcast;
     delete [] GenericBuffer;
+    delete [] ReadBoardsMem;
+    delete [] WriteBoardsMem;
 }
 
 std::string BasePort::ProtocolString(ProtocolType protocol)
@@ -170,6 +238,7 @@ bool BasePort::SetProtocol(ProtocolType prot) {
             outStr << "BasePort::SetProtocol: warning: unknown protocol (ignored): " << prot << std::endl;
             break;
     }
+    UpdateBroadcastReadPlan();
     return (Protocol_ == prot);
 }
 
@@ -186,7 +255,7 @@ void BasePort::SetReadBufferBroadcast(void)
 {
     if (!ReadBufferBroadcast) {
         size_t numReadBytes = GetReadQuadAlign()+GetPrefixOffset(RD_FW_BDATA)+GetMaxReadDataSize()+GetReadPostfixSize();
-        quadlet_t *buf = new quadlet_t[numReadBytes/sizeof(quadlet_t)];
+        quadlet_t *buf = new quadlet_t[(numReadBytes+sizeof(quadlet_t)-1)/sizeof(quadlet_t)];
         ReadBufferBroadcast = reinterpret_cast<unsigned char *>(buf);
     }
 }
@@ -200,6 +269,56 @@ void BasePort::SetWriteBufferBroadcast(void)
     }
 }
 
+void BasePort::SetBoardBuffers(void)
+{
+    // Find the largest read and write sizes of the boards in use
+    size_t maxReadBytes = 0;
+    size_t maxWriteBytes = 0;
+    for (unsigned int boardNum = 0; boardNum < BoardIO::MAX_BOARDS; boardNum++) {
+        BoardIO *board = BoardList[boardNum];
+        if (board) {
+            maxReadBytes = std::max(maxReadBytes, static_cast<size_t>(board->GetReadNumBytes()));
+            maxWriteBytes = std::max(maxWriteBytes, static_cast<size_t>(board->GetWriteNumBytes()));
+        }
+    }
+    // Round slot sizes up to a multiple of the cache line size, so that each slot starts on a
+    // cache line (no two boards share a cache line)
+    size_t readSlot = GetReadQuadAlign()+GetPrefixOffset(RD_FW_BDATA)+maxReadBytes+GetReadPostfixSize();
+    readSlot = (readSlot+SLOT_ALIGN-1)/SLOT_ALIGN*SLOT_ALIGN;
+    if (readSlot > ReadSlotSize) {
+        delete [] ReadBoardsMem;
+        ReadBoardsMem = new unsigned char[BoardIO::MAX_BOARDS*readSlot+SLOT_ALIGN-1];
+        ReadBufferBoards = AlignPointer(ReadBoardsMem, SLOT_ALIGN);
+        ReadSlotSize = readSlot;
+    }
+    size_t writeSlot = GetWriteQuadAlign()+GetPrefixOffset(WR_FW_BDATA)+maxWriteBytes+GetWritePostfixSize();
+    writeSlot = (writeSlot+SLOT_ALIGN-1)/SLOT_ALIGN*SLOT_ALIGN;
+    if (writeSlot > WriteSlotSize) {
+        delete [] WriteBoardsMem;
+        WriteBoardsMem = new unsigned char[BoardIO::MAX_BOARDS*writeSlot+SLOT_ALIGN-1];
+        WriteBufferBoards = AlignPointer(WriteBoardsMem, SLOT_ALIGN);
+        WriteSlotSize = writeSlot;
+    }
+}
+
+unsigned char *BasePort::GetReadSlotPacket(const quadlet_t *rdata, unsigned int nbytes) const
+{
+    if (!ReadBufferBoards)
+        return 0;
+    size_t dataOffset = GetReadQuadAlign()+GetPrefixOffset(RD_FW_BDATA);
+    if (dataOffset+nbytes+GetReadPostfixSize() > ReadSlotSize)
+        return 0;
+    // Pointers are compared as integers, since rdata need not point into ReadBufferBoards
+    uintptr_t rdataAddr = reinterpret_cast<uintptr_t>(rdata);
+    uintptr_t slotsAddr = reinterpret_cast<uintptr_t>(ReadBufferBoards) + dataOffset;
+    if ((rdataAddr < slotsAddr) || (rdataAddr >= slotsAddr + BoardIO::MAX_BOARDS*ReadSlotSize))
+        return 0;
+    size_t offset = rdataAddr - slotsAddr;
+    if ((offset%ReadSlotSize) != 0)
+        return 0;
+    return ReadBufferBoards + offset + GetReadQuadAlign();
+}
+
 // Return expected size for broadcast read, in bytes
 unsigned int BasePort::GetBroadcastReadSize(void) const
 {
@@ -212,6 +331,47 @@ unsigned int BasePort::GetBroadcastReadSize(void) const
     return nBytes;
 }
 
+void BasePort::UpdateBroadcastReadPlan(void)
+{
+    unsigned int readSize;        // Block size per board (depends on firmware version)
+    if (IsAllBoardsRev4_6_)
+        readSize = 17;   // Rev 1-6: 1 seq + 16 data, unit quadlet (should actually be 1 seq + 20 data)
+    else if (IsAllBoardsRev7_)
+        readSize = 29;   // Rev 7: 1 seq + 28 data, unit quadlet (Rev 7)
+    else
+        readSize = 33;   // Rev 8: 1 seq + 32 data, unit quadlet (Rev 8, QLA)
+
+    // Note that Rev 8 also supports dRAC, so the block size is obtained from each board.
+    // Prior to Firmware Rev 7, the hub always contains data for all 16 boards.
+    unsigned int offset = 0;
+    for (unsigned int boardNum = 0; boardNum < BoardIO::MAX_BOARDS; boardNum++) {
+        BoardIO *board = BoardList[boardNum];
+        bcReadPlan.offset[boardNum] = offset;
+        bcReadPlan.blockSize[boardNum] = 0;
+        if (bcReadInfo.boardInfo[boardNum].inUse && board) {
+            if (IsAllBoardsRev8_)
+                bcReadPlan.blockSize[boardNum] = board->GetReadNumBytes()/sizeof(quadlet_t) + 1;
+            else
+                bcReadPlan.blockSize[boardNum] = readSize;
+            offset += bcReadPlan.blockSize[boardNum];
+        }
+        else if (IsAllBoardsRev4_6_) {
+            offset += readSize;
+        }
+    }
+    bcReadPlan.timingOffset = offset;
+
+    if (IsAllBoardsRev4_6_)
+        bcReadPlan.hubReadSize = BoardIO::MAX_BOARDS*readSize;  // Rev 1-6: 16 * 17 = 272 max (though really should have been 16*21)
+    else if (IsAllBoardsRev7_)
+        bcReadPlan.hubReadSize = readSize*NumOfBoards_+1;       // Rev 7: NumOfBoards * readSize + 1
+    else
+        bcReadPlan.hubReadSize = (GetBroadcastReadSize()/sizeof(quadlet_t))+1; // Rev 8
+
+    // Check size, since ReadBufferBroadcast is allocated based on GetMaxReadDataSize
+    bcReadPlan.sizeOK = (bcReadPlan.hubReadSize*sizeof(quadlet_t) <= GetMaxReadDataSize());
+}
+
 void BasePort::SetReadInvalid(void)
 {
     for (unsigned int boardNum = 0; boardNum < max_board; boardNum++) {
@@ -221,6 +381,237 @@ void BasePort::SetReadInvalid(void)
     }
 }
 
+void BasePort::SetBroadcastWaitMode(BroadcastWaitType mode)
+{
+    bcWaitMode = mode;
+    bcWaitTime = 0.0;    // re-learn the wait time
+}
+
+bool BasePort::WaitBroadcastReadAdaptive(double fixedWait)
+{
+    if (bcWaitMode != BC_WAIT_ADAPTIVE)
+        return false;
+
+    // Use the fixed wait until the hub fill time has been learned
+    if (bcWaitTime <= 0.0)
+        bcWaitTime = fixedWait;
+    bcWaitUsed = bcWaitTime;
+
+    // Sleep for most of the remaining time (since nanosleep may oversleep), then spin
+    const double SPIN_TIME = 100.0e-6;
+    double deadline = bcRequestTime + bcWaitTime;
+    double timeLeft = deadline - Amp1394_GetTime();
+    if (timeLeft > SPIN_TIME)
+        Amp1394_Sleep(timeLeft - SPIN_TIME);
+    while (Amp1394_GetTime() < deadline);
+    return true;
+}
+
+void BasePort::UpdateBroadcastWait(bool seqError, bool dataOK)
+{
+    // Timing information is only available with Firmware Rev 7+
+    if ((bcWaitMode != BC_WAIT_ADAPTIVE) || !(IsAllBoardsRev7_ || IsAllBoardsRev8_))
+        return;
+
+    const double MARGIN = 2.0e-6;     // Margin between hub update and start of hub read
+    const double MAX_WAIT = 1.0e-3;   // Upper limit on wait time
+
+    if (seqError) {
+        // Probably started the hub read too early, so back off quickly
+        bcWaitTime = std::min(2.0*bcWaitUsed + MARGIN, MAX_WAIT);
+        return;
+    }
+    // Other failures (e.g., missing board) do not indicate the timing of the hub data
+    if (!dataOK)
+        return;
+    // Time when the hub data was complete (relative to receipt of broadcast query)
+    double hubReady = 0.0;
+    for (unsigned int boardNum = 0; boardNum < max_board; boardNum++) {
+        if (bcReadInfo.boardInfo[boardNum].inUse && (bcReadInfo.boardInfo[boardNum].updateTime > hubReady))
+            hubReady = bcReadInfo.boardInfo[boardNum].updateTime;
+    }
+    // Slack is the time that the hub data was ready before we started reading it.
+    // The ideal wait would have made the slack equal to MARGIN.
+    double slack = bcReadInfo.readStartTime - hubReady;
+    double target = bcWaitUsed - slack + MARGIN;
+    if (target < 0.0)
+        target = 0.0;
+    if (target > bcWaitTime)
+        bcWaitTime = std::min(target, MAX_WAIT);        // increase immediately
+    else
+        bcWaitTime += 0.1*(target - bcWaitTime);        // decrease slowly (filter out noise)
+}
+
+int64_t BasePort::GetLatencyTime(void) const
+{
+    return latencyEnabled ? Amp1394_GetTimeNs() : 0;
+}
+
+void BasePort::RecordLatency(LatencyPath path, int64_t send, int64_t wait, int64_t receive,
+                             int64_t process, int64_t total)
+{
+    if (!latencyEnabled)
+        return;
+    // The exchange (atomic read-modify-write) is only done when a reset was requested
+    if (LoadAcquireInt(&latencyResetRequested) && ExchangeInt(&latencyResetRequested, 0)) {
+        for (unsigned int i = 0; i < LATENCY_NUM_PATHS; i++)
+            for (unsigned int j = 0; j < LATENCY_NUM_STAGES; j++)
+                latencyHist[i][j].Reset();
+        latencyResetTime = Amp1394_GetTimeNs();
+    }
+    // Negative values indicate that the stage was not performed
+    if (send >= 0)    latencyHist[path][LATENCY_SEND].Record(send);
+    if (wait >= 0)    latencyHist[path][LATENCY_WAIT].Record(wait);
+    if (receive >= 0) latencyHist[path][LATENCY_RECEIVE].Record(receive);
+    if (process >= 0) latencyHist[path][LATENCY_PROCESS].Record(process);
+    if (total >= 0)   latencyHist[path][LATENCY_TOTAL].Record(total);
+
+    // Publish the statistics to the buffer that was not most recently published, so that
+    // GetLatencySnapshot (any thread) can copy a consistent version
+    unsigned int index = latencyPubLatest^1;
+    StoreRelaxed(&latencyPubSeq[index], latencyPubSeq[index]+1);   // odd: write in progress
+    FenceRelease();
+    LatencyPublished &pub = latencyPub[index];
+    for (unsigned int i = 0; i < LATENCY_NUM_PATHS; i++)
+        for (unsigned int j = 0; j < LATENCY_NUM_STAGES; j++)
+            pub.hist[i][j].CopyFrom(latencyHist[i][j]);
+    pub.resetTime = latencyResetTime;
+    StoreRelease(&latencyPubSeq[index], latencyPubSeq[index]+1);   // even: write complete
+    StoreRelease(&latencyPubLatest, index);
+}
+
+unsigned int BasePort::ProcessRequests(unsigned int maxNum)
+{
+    unsigned int num = 0;
+    PortRequest *req;
+    while (((maxNum == 0) || (num < maxNum)) && ((req = requestQueue.Pop()) != 0)) {
+        if (req->IsCancelRequested()) {
+            req->SetStatus(PortRequest::REQ_CANCELLED);
+            continue;
+        }
+        bool ok = false;
+        switch (req->type) {
+            case PortRequest::READ_QUADLET:
+                ok = ReadQuadlet(req->boardId, req->addr, req->data);
+                break;
+            case PortRequest::WRITE_QUADLET:
+                ok = WriteQuadlet(req->boardId, req->addr, req->data);
+                break;
+            case PortRequest::READ_BLOCK:
+                ok = ReadBlock(req->boardId, req->addr, req->buffer, req->nbytes);
+                break;
+            case PortRequest::WRITE_BLOCK:
+                ok = WriteBlock(req->boardId, req->addr, req->buffer, req->nbytes);
+                break;
+        }
+        req->SetStatus(ok ? PortRequest::REQ_DONE : PortRequest::REQ_FAILED);
+        num++;
+    }
+    return num;
+}
+
+void BasePort::BeginPublishFeedback(void)
+{
+    if (feedbackEnabled)
+        feedbackSnap = &feedbackBuffer.BeginWrite((cycleTimestamp != 0.0) ? cycleTimestamp : Amp1394_GetTime());
+    else
+        feedbackSnap = 0;
+}
+
+void BasePort::PublishBoardFeedback(unsigned int boardNum, const quadlet_t *data)
+{
+    if (!feedbackSnap || !BoardList[boardNum])
+        return;
+    FeedbackSnapshot::BoardData &bd = feedbackSnap->board[boardNum];
+    unsigned int numQuads = BoardList[boardNum]->GetReadNumBytes()/sizeof(quadlet_t);
+    if (numQuads > FeedbackSnapshot::MAX_QUADS)
+        return;
+    bd.hwVersion = HardwareVersion[boardNum];
+    bd.fwVersion = FirmwareVersion[boardNum];
+    bd.numQuads = numQuads;
+    memcpy(bd.data, data, numQuads*sizeof(quadlet_t));
+    bd.valid = true;
+}
+
+void BasePort::EndPublishFeedback(void)
+{
+    if (feedbackSnap) {
+        feedbackBuffer.EndWrite();
+        feedbackSnap = 0;
+    }
+}
+
+void BasePort::GetLatencySnapshot(LatencySnapshot &snap, bool reset)
+{
+    // Copy the most recently published buffer, repeating the copy if RecordLatency started
+    // overwriting it (see FeedbackBuffer::Read)
+    int64_t resetTime;
+    for (;;) {
+        unsigned int index = LoadAcquire(&latencyPubLatest);
+        uint32_t seqStart = LoadAcquire(&latencyPubSeq[index]);
+        if (seqStart & 1)
+            continue;
+        const LatencyPublished &pub = latencyPub[index];
+        for (unsigned int i = 0; i < LATENCY_NUM_PATHS; i++)
+            for (unsigned int j = 0; j < LATENCY_NUM_STAGES; j++)
+                snap.hist[i][j] = pub.hist[i][j];
+        resetTime = pub.resetTime;
+        FenceAcquire();
+        if (LoadRelaxed(&latencyPubSeq[index]) == seqStart)
+            break;
+    }
+    snap.elapsedTime = (Amp1394_GetTimeNs() - resetTime)*1.0e-9;
+    if (reset)
+        ResetLatencyStats();
+}
+
+void BasePort::ResetLatencyStats(void)
+{
+    StoreReleaseInt(&latencyResetRequested, 1);
+}
+
+std::string BasePort::LatencyPathString(LatencyPath path)
+{
+    if (path == LATENCY_READ)
+        return std::string("read");
+    else if (path == LATENCY_WRITE)
+        return std::string("write");
+    else
+        return std::string("unknown");
+}
+
+std::string BasePort::LatencyStageString(LatencyStage stage)
+{
+    if (stage == LATENCY_SEND)
+        return std::string("send");
+    else if (stage == LATENCY_WAIT)
+        return std::string("wait");
+    else if (stage == LATENCY_RECEIVE)
+        return std::string("receive");
+    else if (stage == LATENCY_PROCESS)
+        return std::string("process");
+    else if (stage == LATENCY_TOTAL)
+        return std::string("total");
+    else
+        return std::string("unknown");
+}
+
+void BasePort::LatencySnapshot::Print(std::ostream &outStr) const
+{
+    outStr << "Latency statistics for last " << elapsedTime << " seconds:" << std::endl;
+    for (unsigned int i = 0; i < LATENCY_NUM_PATHS; i++) {
+        for (unsigned int j = 0; j < LATENCY_NUM_STAGES; j++) {
+            if (hist[i][j].GetCount() == 0)
+                continue;
+            std::string name = LatencyPathString(static_cast<LatencyPath>(i)) + " "
+                             + LatencyStageString(static_cast<LatencyStage>(j)) + ":";
+            outStr << "  " << name << std::string((name.size() < 15) ? 15-name.size() : 1, ' ');
+            hist[i][j].PrintSummary(outStr);
+            outStr << std::endl;
+        }
+    }
+}
+
 void BasePort::Reset(void)
 {
     Cleanup();
@@ -383,6 +774,9 @@ bool BasePort::ScanNodes(void)
         }
     }
 
+    // Firmware versions may have changed
+    UpdateBroadcastReadPlan();
+
     return (NumOfNodes_ > 0);
 }
 
@@ -419,6 +813,7 @@ bool BasePort::AddBoard(BoardIO *board)
     // Make sure read/write buffers are allocated
     SetReadBufferBroadcast();
     SetWriteBufferBroadcast();
+    SetBoardBuffers();
 
     if (id >= max_board)
         max_board = id+1;
@@ -426,6 +821,7 @@ bool BasePort::AddBoard(BoardIO *board)
     BoardInUseMask_ = (BoardInUseMask_ | (1 << id));
     bcReadInfo.boardInfo[id].inUse = true;
     NumOfBoards_++;   // increment board counts
+    UpdateBroadcastReadPlan();
 
     return true;
 }
@@ -456,6 +852,7 @@ bool BasePort::RemoveBoard(unsigned char boardId)
         for (int bd = 0; bd < boardId; bd++)
             if (BoardList[bd]) max_board = bd+1;
     }
+    UpdateBroadcastReadPlan();
     return true;
 }
 
@@ -469,6 +866,10 @@ std::string BasePort::PortTypeString(PortType portType)
         return std::string("Ethernet-UDP");
     else if (portType == PORT_ZYNQ_EMIO)
         return std::string("Zynq-EMIO");
+    else if (portType == PORT_SIM)
+        return std::string("Simulated");
+    else if (portType == PORT_ETH_XDP)
+        return std::string("Ethernet-XDP");
     else
         return std::string("Unknown");
 }
@@ -480,6 +881,9 @@ std::string BasePort::PortTypeString(PortType portType)
 // fw:N             for FireWire, where N is the port number
 // eth:N            for raw Ethernet (PCAP), where N is the port number
 // udp:xx.xx.xx.xx  for UDP, where xx.xx.xx.xx is the (optional) server IP address
+// sim:N            for in-process emulated boards, where N is the (optional) number of boards
+// xdp:ifname[:Q]   for raw Ethernet via AF_XDP, where ifname is the network interface (returned in IPaddr)
+//                  and Q is the (optional) receive queue (returned in portNum, default 0)
 bool BasePort::ParseOptions(const char *arg, PortType &portType, int &portNum, std::string &IPaddr,
                             std::ostream &ostr)
 {
@@ -537,6 +941,48 @@ bool BasePort::ParseOptions(const char *arg, PortType &portType, int &portNum, s
         portNum = 0;
         return true;
     }
+    else if (strncmp(arg, "sim", 3) == 0) {
+        portType = PORT_SIM;
+        // no number of boards specified
+        if (strlen(arg) == 3) {
+            portNum = 4;
+            return true;
+        }
+        // make sure separator is here
+        if (arg[3] != ':') {
+            ostr << "ParseOptions: missing \":\" after \"sim\"" << std::endl;
+            return false;
+        }
+        if ((sscanf(arg+4, "%d", &portNum) == 1) && (portNum > 0) && (portNum <= BoardIO::MAX_BOARDS)) {
+            return true;
+        }
+        ostr << "ParseOptions: failed to find a number of boards (1-" << BoardIO::MAX_BOARDS
+             << ") after \"sim:\" in " << arg+4 << std::endl;
+        return false;
+    }
+    else if (strncmp(arg, "xdp", 3) == 0) {
+        portType = PORT_ETH_XDP;
+        portNum = 0;    // queue id
+        if ((arg[3] != ':') || (strlen(arg+4) == 0) || (arg[4] == ':')) {
+            ostr << "ParseOptions: missing network interface after \"xdp:\"" << std::endl;
+            return false;
+        }
+        // optional queue id after network interface
+        const char *queueStr = strchr(arg+4, ':');
+        if (queueStr) {
+            char extra;
+            if ((sscanf(queueStr+1, "%d%c", &portNum, &extra) != 1) || (portNum < 0)) {
+                ostr << "ParseOptions: failed to find a queue number after \"" << std::string(arg, queueStr-arg)
+                     << ":\" in " << arg << std::endl;
+                return false;
+            }
+            IPaddr.assign(arg+4, queueStr-(arg+4));
+        }
+        else {
+            IPaddr.assign(arg+4);
+        }
+        return true;
+    }
     // older default, fw and looking for port number
     portType = PORT_FIREWIRE;
     // scan port number
@@ -731,6 +1177,20 @@ bool BasePort::WriteBlock(unsigned char boardId, nodeaddr_t addr, quadlet_t *wda
     return (node < MAX_NODES) ? WriteBlockNode(node, addr, wdata, nbytes, boardId&FW_NODE_FLAGS_MASK) : false;
 }
 
+void BasePort::ReadBlockMultiple(const unsigned char *boardList, quadlet_t * const *rdata,
+                                 const unsigned int *nbytes, bool *ok, unsigned int num)
+{
+    for (unsigned int i = 0; i < num; i++)
+        ok[i] = ReadBlock(boardList[i], 0, rdata[i], nbytes[i]);
+}
+
+void BasePort::WriteBlockMultiple(const unsigned char *boardList, quadlet_t * const *wdata,
+                                  const unsigned int *nbytes, bool *ok, unsigned int num)
+{
+    for (unsigned int i = 0; i < num; i++)
+        ok[i] = WriteBlock(boardList[i], 0, wdata[i], nbytes[i]);
+}
+
 bool BasePort::ReadAllBoards(void)
 {
     if (!IsOK()) {
@@ -743,55 +1203,148 @@ bool BasePort::ReadAllBoards(void)
         return ReadAllBoardsBroadcast();
     }
 
+    if (!StartReadSequential())
+        return false;
+    return FinishReadSequential();
+}
+
+bool BasePort::ReadAllBoardsBroadcast(void)
+{
+    if (!StartReadBroadcast())
+        return false;
+
+    // Wait for broadcast read data
+    WaitBroadcastRead();
+
+    return FinishReadBroadcast();
+}
+
+bool BasePort::StartReadAllBoards(void)
+{
+    if (pendingRead.active) {
+        outStr << "BasePort::StartReadAllBoards: previous read not finished" << std::endl;
+        pendingRead.active = false;
+    }
+
+    if (!IsOK()) {
+        outStr << "BasePort::StartReadAllBoards: port not initialized" << std::endl;
+        OnNoneRead();
+        return false;
+    }
+
+    if (Protocol_ == BasePort::PROTOCOL_BC_QRW)
+        return StartReadBroadcast();
+    return StartReadSequential();
+}
+
+bool BasePort::FinishReadAllBoards(double)
+{
+    if (!pendingRead.active) {
+        outStr << "BasePort::FinishReadAllBoards: no read pending" << std::endl;
+        return false;
+    }
+
+    if (pendingRead.broadcast) {
+        // Wait for any remaining time (all or part of the wait may already have elapsed)
+        double fixedWait = GetBroadcastReadWait();
+        if (!WaitBroadcastReadAdaptive(fixedWait)) {
+            double timeLeft = bcRequestTime + fixedWait - Amp1394_GetTime();
+            if (timeLeft > 0.0)
+                Amp1394_Sleep(timeLeft);
+        }
+        return FinishReadBroadcast();
+    }
+    return FinishReadSequential();
+}
+
+bool BasePort::StartReadSequential(void)
+{
     if (!CheckFwBusGeneration("ReadAllBoards", autoReScan)) {
         SetReadInvalid();
         OnNoneRead();
         return false;
     }
 
+    latReadStart = GetLatencyTime();
+
+    // Build list of boards to read (possibly batched by the derived class)
+    pendingRead.num = 0;
+    for (unsigned int board = 0; board < max_board; board++) {
+        if (BoardList[board]) {
+            unsigned int i = pendingRead.num;
+            pendingRead.boardList[i] = static_cast<unsigned char>(board);
+            pendingRead.rdata[i] = GetReadSlotData(board);
+            pendingRead.nbytes[i] = BoardList[board]->GetReadNumBytes();
+            pendingRead.num++;
+        }
+    }
+    pendingRead.requestsSent = StartReadBlockMultiple(pendingRead.boardList, pendingRead.rdata, pendingRead.nbytes,
+                                                      pendingRead.ok, pendingRead.num);
+    latReadSent = pendingRead.requestsSent ? GetLatencyTime() : latReadStart;
+    pendingRead.broadcast = false;
+    pendingRead.active = true;
+    return true;
+}
+
+bool BasePort::FinishReadSequential(void)
+{
+    pendingRead.active = false;
+    int64_t tWaited = GetLatencyTime();
+    if (pendingRead.requestsSent)
+        FinishReadBlockMultiple(pendingRead.ok, pendingRead.num);
+    else
+        ReadBlockMultiple(pendingRead.boardList, pendingRead.rdata, pendingRead.nbytes, pendingRead.ok, pendingRead.num);
+    int64_t tReceived = GetLatencyTime();
+
     bool allOK = true;
     bool noneRead = true;
 
     bool rtRead = true;
-    for (unsigned int board = 0; board < max_board; board++) {
-        if (BoardList[board]) {
-            quadlet_t *readBuffer = reinterpret_cast<quadlet_t *>(ReadBufferBroadcast + GetReadQuadAlign() + GetPrefixOffset(RD_FW_BDATA));
-            bool ret = ReadBlock(board, 0, readBuffer, BoardList[board]->GetReadNumBytes());
-            if (ret) {
-                BoardList[board]->SetReadData(readBuffer);
-                noneRead = false;
-            } else {
-                allOK = false;
-            }
-            BoardList[board]->SetReadValid(ret);
 
-            if (ret) {
-                ReadErrorCounter_ = 0;
+    BeginPublishFeedback();
+    for (unsigned int i = 0; i < pendingRead.num; i++) {
+        unsigned int board = pendingRead.boardList[i];
+        bool ret = pendingRead.ok[i];
+        if (ret) {
+            BoardList[board]->SetReadData(pendingRead.rdata[i]);
+            PublishBoardFeedback(board, pendingRead.rdata[i]);
+            noneRead = false;
+        } else {
+            allOK = false;
+        }
+        BoardList[board]->SetReadValid(ret);
+
+        if (ret) {
+            ReadErrorCounter_ = 0;
+        }
+        else {
+            if (ReadErrorCounter_ == 0) {
+                outStr << "BasePort::ReadAllBoards: read failed on port "
+                       << PortNum << ", board " << board << std::endl;
             }
-            else {
-                if (ReadErrorCounter_ == 0) {
-                    outStr << "BasePort::ReadAllBoards: read failed on port "
-                           << PortNum << ", board " << board << std::endl;
-                }
-                ReadErrorCounter_++;
-                if (ReadErrorCounter_ == 10000) {
-                    outStr << "BasePort::ReadAllBoards: read failed on port "
-                           << PortNum << ", board " << board << " occurred 10,000 times" << std::endl;
-                    ReadErrorCounter_ = 0;
-                }
+            ReadErrorCounter_++;
+            if (ReadErrorCounter_ == 10000) {
+                outStr << "BasePort::ReadAllBoards: read failed on port "
+                       << PortNum << ", board " << board << " occurred 10,000 times" << std::endl;
+                ReadErrorCounter_ = 0;
             }
         }
     }
+    EndPublishFeedback();
     if (!rtRead)
         outStr << "BasePort::ReadAllBoards: rtRead is false" << std::endl;
 
     if (noneRead) {
         OnNoneRead();
     }
+
+    int64_t tDone = GetLatencyTime();
+    RecordLatency(LATENCY_READ, pendingRead.requestsSent ? (latReadSent-latReadStart) : -1,
+                  tWaited-latReadSent, tReceived-tWaited, tDone-tReceived, tDone-latReadStart);
     return allOK;
 }
 
-bool BasePort::ReadAllBoardsBroadcast(void)
+bool BasePort::StartReadBroadcast(void)
 {
     if (!IsOK()) {
         outStr << "BasePort::ReadAllBoardsBroadcast: port not initialized" << std::endl;
@@ -811,17 +1364,11 @@ bool BasePort::ReadAllBoardsBroadcast(void)
         return false;
     }
 
-    bool allOK = true;
-    bool noneRead = true;
-
     //--- send out broadcast read request -----
 
-    bool rtRead = true;
-    // sequence number from 16 bits 0 to 65535
-    bcReadInfo.readSequence++;
-    if (bcReadInfo.readSequence == 65536) {
-        bcReadInfo.readSequence = 1;
-    }
+    latReadStart = GetLatencyTime();
+
+    NextBroadcastReadSequence();
 
     if (!WriteBroadcastReadRequest(bcReadInfo.readSequence)) {
         outStr << "BasePort::ReadAllBoardsBroadcast: failed to send broadcast read request, seq = "
@@ -830,47 +1377,70 @@ bool BasePort::ReadAllBoardsBroadcast(void)
         return false;
     }
 
-    // Wait for broadcast read data
-    WaitBroadcastRead();
+    bcRequestTime = Amp1394_GetTime();
+    latReadSent = GetLatencyTime();
 
-    unsigned int readSize;        // Block size per board (depends on firmware version)
-    if (IsAllBoardsRev4_6_)
-        readSize = 17;   // Rev 1-6: 1 seq + 16 data, unit quadlet (should actually be 1 seq + 20 data)
-    else if (IsAllBoardsRev7_)
-        readSize = 29;   // Rev 7: 1 seq + 28 data, unit quadlet (Rev 7)
-    else
-        readSize = 33;   // Rev 8: 1 seq + 32 data, unit quadlet (Rev 8, QLA)
+    pendingRead.broadcast = true;
+    pendingRead.active = true;
+    return true;
+}
 
-    // Note that Rev 8 also supports dRAC, which has readSize = 60
+void BasePort::NextBroadcastReadSequence(void)
+{
+    // sequence number from 16 bits 0 to 65535
+    bcReadInfo.readSequence++;
+    if (bcReadInfo.readSequence == 65536) {
+        bcReadInfo.readSequence = 1;
+    }
+}
 
-    unsigned int hubReadSize;        // Actual read size (depends on firmware version)
-    if (IsAllBoardsRev4_6_)
-        hubReadSize = BoardIO::MAX_BOARDS*readSize;  // Rev 1-6: 16 * 17 = 272 max (though really should have been 16*21)
-    else if (IsAllBoardsRev7_)
-        hubReadSize = readSize*NumOfBoards_+1;       // Rev 7: NumOfBoards * readSize + 1
-    else
-        hubReadSize = (GetBroadcastReadSize()/sizeof(quadlet_t))+1; // Rev 8 (could call this once and save result)
+bool BasePort::FinishReadBroadcast(void)
+{
+    pendingRead.active = false;
+    int64_t tWaited = GetLatencyTime();
 
+    bool allOK = true;
+    bool seqError = false;    // true if any board returned stale data (see UpdateBroadcastWait)
+    bool noneRead = true;
+    bool rtRead = true;
+
+    // The hub data layout was computed by UpdateBroadcastReadPlan
+    unsigned int hubReadSize = bcReadPlan.hubReadSize;
+    if (!bcReadPlan.sizeOK) {
+        outStr << "BasePort::ReadAllBoardsBroadcast: hub read size " << hubReadSize*sizeof(quadlet_t)
+               << " too large (max = " << GetMaxReadDataSize() << " bytes)" << std::endl;
+        SetReadInvalid();
+        BeginPublishFeedback();
+        EndPublishFeedback();
+        OnNoneRead();
+        return false;
+    }
+
+    // The buffer is not cleared before reading; stale data from a previous read is rejected by the
+    // sequence number check below.
     quadlet_t *hubReadBuffer = reinterpret_cast<quadlet_t *>(ReadBufferBroadcast + GetReadQuadAlign() + GetPrefixOffset(RD_FW_BDATA));
-    memset(hubReadBuffer, 0, hubReadSize*sizeof(quadlet_t));
     bool ret = ReadBlock(HubBoard, 0x1000, hubReadBuffer, hubReadSize*sizeof(quadlet_t));
     if (!ret) {
         SetReadInvalid();
+        BeginPublishFeedback();
+        EndPublishFeedback();
         OnNoneRead();
         return false;
     }
+    int64_t tReceived = GetLatencyTime();
 
+    BeginPublishFeedback();
     double clkPeriod = 0.0;  // will be assigned below
-    quadlet_t *curPtr = hubReadBuffer;
     // Loop through all boards, processing the boards in use.
-    // Note that prior to Firmware Rev 7, we always read data for all 16 boards.
     for (unsigned int boardNum = 0; boardNum < BoardIO::MAX_BOARDS; boardNum++) {
         BoardIO *board = BoardList[boardNum];
         if (bcReadInfo.boardInfo[boardNum].inUse && board) {
+            const quadlet_t *curPtr = hubReadBuffer + bcReadPlan.offset[boardNum];
             quadlet_t statusQuad = bswap_32(curPtr[2]);
             unsigned int numAxes = (statusQuad&0xf0000000)>>28;
             unsigned int thisBoard = (statusQuad&0x0f000000)>>24;
             bool thisOK = false;
+            bool sizeError = false;
             if (!IsAllBoardsRev8_ && (numAxes != 4)) {
                 outStr << "BasePort::ReadAllBoardsBroadcast: invalid status (not a 4 axis board): " << std::hex << statusQuad
                        << std::dec << std::endl;
@@ -889,61 +1459,65 @@ bool BasePort::ReadAllBoardsBroadcast(void)
                     if (bcReadInfo.boardInfo[boardNum].sequence != (bcReadInfo.readSequence & 0x00ff))
                         bcReadInfo.boardInfo[boardNum].seq_error = true;
                     bcReadInfo.boardInfo[boardNum].blockSize = (bswap_32(curPtr[0]) & 0xff000000) >> 24;
-                    unsigned int bdReadSize = board->GetReadNumBytes()/sizeof(quadlet_t) + 1;
-                    if (bcReadInfo.boardInfo[boardNum].blockSize != bdReadSize) {
+                    if (bcReadInfo.boardInfo[boardNum].blockSize != bcReadPlan.blockSize[boardNum]) {
                         outStr << "BasePort::ReadAllBoardsBroadcast: board " << boardNum
                                << ", blockSize = " << bcReadInfo.boardInfo[boardNum].blockSize
-                               << ", expected = " << bdReadSize << std::endl;
+                               << ", expected = " << bcReadPlan.blockSize[boardNum] << std::endl;
+                        sizeError = true;
                     }
                 }
                 else {
                     bcReadInfo.boardInfo[boardNum].seq_error = (bcReadInfo.boardInfo[boardNum].sequence != bcReadInfo.readSequence);
-                    bcReadInfo.boardInfo[boardNum].blockSize = readSize;
+                    bcReadInfo.boardInfo[boardNum].blockSize = bcReadPlan.blockSize[boardNum];
                 }
                 if (IsAllBoardsRev7_ || IsAllBoardsRev8_) {
                     unsigned int quad0_lsb = bswap_32(curPtr[0])&0x0000ffff;
                     clkPeriod = board->GetFPGAClockPeriod();
                     bcReadInfo.boardInfo[boardNum].updateTime = (quad0_lsb&0x3fff)*clkPeriod;
                 }
-                if (!bcReadInfo.boardInfo[boardNum].seq_error) {
-                    thisOK = true;
-                }
-                else {
+                if (bcReadInfo.boardInfo[boardNum].seq_error) {
+                    seqError = true;
                     outStr << "BasePort::ReadAllBoardsBroadcast: board " << boardNum
                            << ", seq = " << bcReadInfo.boardInfo[boardNum].sequence
                            << ", expected = " << bcReadInfo.readSequence
                            << ", diff = " << (bcReadInfo.readSequence-bcReadInfo.boardInfo[boardNum].sequence)
                            << std::endl;
                 }
+                else if (!sizeError) {
+                    thisOK = true;
+                }
             }
             board->SetReadValid(thisOK);
             if (thisOK) {
                 board->SetReadData(curPtr+1);
+                PublishBoardFeedback(boardNum, curPtr+1);
                 noneRead = false;
             }
             else {
                 allOK = false;
             }
-            curPtr += bcReadInfo.boardInfo[boardNum].blockSize;
-        }
-        else if (IsAllBoardsRev4_6_) {
-            // Skip unused boards for firmware < 7
-            curPtr += readSize;
         }
     }
 
     if (IsAllBoardsRev7_ || IsAllBoardsRev8_) {
-        quadlet_t timingInfo = bswap_32(curPtr[0]);
+        quadlet_t timingInfo = bswap_32(hubReadBuffer[bcReadPlan.timingOffset]);
         bcReadInfo.readStartTime = ((timingInfo&0x3fff0000) >> 16)*clkPeriod;
         bcReadInfo.readFinishTime = (timingInfo&0x00003fff)*clkPeriod;
     }
 
+    EndPublishFeedback();
+    UpdateBroadcastWait(seqError, allOK);
+
     if (noneRead) {
         OnNoneRead();
     }
     if (!rtRead)
         outStr << "BasePort::ReadAllBoardsBroadcast: rtRead is false" << std::endl;
 
+    int64_t tDone = GetLatencyTime();
+    RecordLatency(LATENCY_READ, latReadSent-latReadStart, tWaited-latReadSent, tReceived-tWaited,
+                  tDone-tReceived, tDone-latReadStart);
+
 #if 0
     if (IsAllBoardsRev7_ || IsAllBoardsRev8_) {
         bcReadInfo.PrintTiming(outStr);
@@ -961,6 +1535,10 @@ bool BasePort::WriteAllBoards(void)
         return false;
     }
 
+    // Queued requests are not processed while a read is pending (see StartReadAllBoards)
+    if ((requestsPerCycle > 0) && !pendingRead.active)
+        ProcessRequests(requestsPerCycle);
+
     if ((Protocol_ == BasePort::PROTOCOL_SEQ_R_BC_W) || (Protocol_ == BasePort::PROTOCOL_BC_QRW)) {
         return WriteAllBoardsBroadcast();
     }
@@ -970,9 +1548,18 @@ bool BasePort::WriteAllBoards(void)
         return false;
     }
 
+    int64_t tStart = GetLatencyTime();
     rtWrite = true;   // for debugging
     bool allOK = true;
     bool noneWritten = true;
+
+    // Boards with Rev 7+ firmware are written using WriteBlockMultiple (below)
+    unsigned char boardList[BoardIO::MAX_BOARDS];
+    quadlet_t *writeBuffer[BoardIO::MAX_BOARDS];
+    unsigned int writeBytes[BoardIO::MAX_BOARDS];
+    bool writeOK[BoardIO::MAX_BOARDS];
+    unsigned int numWrite = 0;
+
     for (unsigned int board = 0; board < max_board; board++) {
         if (BoardList[board]) {
             quadlet_t *buf = reinterpret_cast<quadlet_t *>(WriteBufferBroadcast + GetWriteQuadAlign() + GetPrefixOffset(WR_FW_BDATA));
@@ -1007,31 +1594,92 @@ bool BasePort::WriteAllBoards(void)
             }
             else {
                 // Rev 7 firmware: write DAC (x4) and Status/Control register
+                buf = GetWriteSlotData(board);
                 BoardList[board]->GetWriteData(buf, 0, numQuads);
-                bool ret = WriteBlock(board, 0, buf, numBytes);
-                BoardList[board]->SetWriteValid(ret);
-                // Initialize (clear) the write buffer
-                BoardList[board]->InitWriteBuffer();
-                if (ret) {
-                    noneWritten = false;
-                    // Check for data collection callback
-                    BoardList[board]->CheckCollectCallback();
-                }
-                else {
-                    allOK = false;
-                }
+                boardList[numWrite] = static_cast<unsigned char>(board);
+                writeBuffer[numWrite] = buf;
+                writeBytes[numWrite] = numBytes;
+                numWrite++;
             }
         }
     }
+
+    int64_t tBuilt = GetLatencyTime();
+    if (numWrite > 0)
+        WriteBlockMultiple(boardList, writeBuffer, writeBytes, writeOK, numWrite);
+    int64_t tSent = GetLatencyTime();
+
+    for (unsigned int i = 0; i < numWrite; i++) {
+        unsigned int board = boardList[i];
+        bool ret = writeOK[i];
+        BoardList[board]->SetWriteValid(ret);
+        // Initialize (clear) the write buffer
+        BoardList[board]->InitWriteBuffer();
+        if (ret) {
+            noneWritten = false;
+            // Check for data collection callback
+            BoardList[board]->CheckCollectCallback();
+        }
+        else {
+            allOK = false;
+        }
+    }
+
     if (noneWritten) {
         OnNoneWritten();
     }
     if (!rtWrite)
         outStr << "BasePort::WriteAllBoards: rtWrite is false" << std::endl;
+
+    int64_t tDone = GetLatencyTime();
+    RecordLatency(LATENCY_WRITE, tSent-tBuilt, -1, -1, (tBuilt-tStart)+(tDone-tSent), tDone-tStart);
     return allOK;
 }
 
 bool BasePort::WriteAllBoardsBroadcast(void)
+{
+    return WriteBroadcastCycle(false);
+}
+
+bool BasePort::WriteReadAllBoards(void)
+{
+    // Rev 1-6 firmware writes the control quadlets separately (after the broadcast packet)
+    if ((Protocol_ != BasePort::PROTOCOL_BC_QRW) || IsAllBoardsRev4_6_) {
+        bool writeOK = WriteAllBoards();
+        bool readOK = ReadAllBoards();
+        return writeOK && readOK;
+    }
+
+    if (pendingRead.active) {
+        outStr << "BasePort::WriteReadAllBoards: previous read not finished" << std::endl;
+        pendingRead.active = false;
+    }
+
+    bool writeOK = WriteBroadcastCycle(true);
+    if (!pendingRead.active) {
+        // Read request not sent (error already reported)
+        SetReadInvalid();
+        OnNoneRead();
+        return false;
+    }
+
+    // Wait for broadcast read data
+    WaitBroadcastRead();
+
+    bool readOK = FinishReadBroadcast();
+    if (requestsPerCycle > 0)
+        ProcessRequests(requestsPerCycle);
+    return writeOK && readOK;
+}
+
+unsigned int BasePort::WriteBroadcastOutputAndReadRequest(quadlet_t *buffer, unsigned int size, unsigned int seq)
+{
+    if (!WriteBroadcastOutput(buffer, size))
+        return 0;
+    return WriteBroadcastReadRequest(seq) ? 2 : 1;
+}
+
+bool BasePort::WriteBroadcastCycle(bool sendReadRequest)
 {
     if (!IsOK()) {
         outStr << "BasePort::WriteAllBoardsBroadcast: port not initialized" << std::endl;
@@ -1050,6 +1698,7 @@ bool BasePort::WriteAllBoardsBroadcast(void)
         return false;
     }
 
+    int64_t tStart = GetLatencyTime();
     bool rtWrite = true;   // for debugging
 
     // sanity check vars
@@ -1081,7 +1730,27 @@ bool BasePort::WriteAllBoardsBroadcast(void)
     // now broadcast out the huge packet
     bool ret;
 
-    ret = WriteBroadcastOutput(bcBuffer, bcBufferOffset);
+    int64_t tBuilt = GetLatencyTime();
+    if (sendReadRequest) {
+        latReadStart = tBuilt;
+        NextBroadcastReadSequence();
+        unsigned int numSent = WriteBroadcastOutputAndReadRequest(bcBuffer, bcBufferOffset, bcReadInfo.readSequence);
+        ret = (numSent > 0);
+        if (numSent == 2) {
+            bcRequestTime = Amp1394_GetTime();
+            latReadSent = GetLatencyTime();
+            pendingRead.broadcast = true;
+            pendingRead.active = true;
+        }
+        else {
+            outStr << "BasePort::WriteReadAllBoards: failed to send broadcast read request, seq = "
+                   << bcReadInfo.readSequence << std::endl;
+        }
+    }
+    else {
+        ret = WriteBroadcastOutput(bcBuffer, bcBufferOffset);
+    }
+    int64_t tSent = GetLatencyTime();
 
     // Send out control quadlet if necessary (firmware prior to Rev 7);
     //    also check for data collection
@@ -1128,6 +1797,9 @@ bool BasePort::WriteAllBoardsBroadcast(void)
     if (!rtWrite)
         outStr << "BasePort::WriteAllBoardsBroadcast: rtWrite is false" << std::endl;
 
+    int64_t tDone = GetLatencyTime();
+    RecordLatency(LATENCY_WRITE, tSent-tBuilt, -1, -1, (tBuilt-tStart)+(tDone-tSent), tDone-tStart);
+
     // return
     return allOK;
 }
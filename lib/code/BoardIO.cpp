@@ -17,6 +17,7 @@ http://www.cisst.org/cisst/license.txt.
 
 #include "BoardIO.h"
 #include "BasePort.h"
+#include "FeedbackSnapshot.h"
 
 /*******************************************************************************
  * Get commands
@@ -24,7 +25,7 @@ http://www.cisst.org/cisst/license.txt.
 
 uint32_t BoardIO::GetFirmwareVersion(void) const
 {
-    return (port ? port->GetFirmwareVersion(BoardId) : 0);
+    return (port ? port->GetFirmwareVersion(BoardId) : snapFwVersion);
 }
 
 unsigned int BoardIO::GetFpgaVersionMajor(void) const
@@ -50,7 +51,7 @@ unsigned int BoardIO::GetFpgaVersionMajorFromStatus(uint32_t status)
 
 uint32_t BoardIO::GetHardwareVersion(void) const
 {
-    return (port ? port->GetHardwareVersion(BoardId) : 0);
+    return (port ? port->GetHardwareVersion(BoardId) : snapHwVersion);
 }
 
 std::string BoardIO::GetHardwareVersionString(void) const
@@ -58,6 +59,36 @@ std::string BoardIO::GetHardwareVersionString(void) const
     return (port ? port->GetHardwareVersionString(BoardId) : "");
 }
 
+bool BoardIO::SetFromSnapshot(const FeedbackSnapshot &snap)
+{
+    if (port) {
+        std::cerr << "BoardIO::SetFromSnapshot: board " << static_cast<unsigned int>(BoardId)
+                  << " is in use by a port" << std::endl;
+        return false;
+    }
+    if (!IsValid())
+        return false;
+    const FeedbackSnapshot::BoardData &bd = snap.board[BoardId];
+    if (!bd.valid) {
+        SetReadValid(false);
+        return false;
+    }
+    if ((bd.hwVersion != snapHwVersion) || (bd.fwVersion != snapFwVersion)) {
+        snapHwVersion = bd.hwVersion;
+        snapFwVersion = bd.fwVersion;
+        InitBoard();
+    }
+    if (bd.numQuads*sizeof(quadlet_t) != GetReadNumBytes()) {
+        std::cerr << "BoardIO::SetFromSnapshot: board " << static_cast<unsigned int>(BoardId)
+                  << ", unexpected data size " << bd.numQuads << " quadlets" << std::endl;
+        SetReadValid(false);
+        return false;
+    }
+    SetReadData(bd.data);
+    SetReadValid(true);
+    return true;
+}
+
 /*******************************************************************************
  * Read commands
  */
@@ -0,0 +1,213 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include "CycleExecutor.h"
+#include "BasePort.h"
+#include "Amp1394Time.h"
+
+#ifdef __linux__
+#include <time.h>
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/prctl.h>
+#endif
+
+// Returns current time in nanoseconds. On Linux, this is CLOCK_MONOTONIC, which is the clock
+// used by clock_nanosleep (CLOCK_MONOTONIC_RAW is not supported by clock_nanosleep).
+static int64_t GetCycleTimeNs(void)
+{
+#ifdef __linux__
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec)*1000000000LL + ts.tv_nsec;
+#else
+    return Amp1394_GetTimeNs();
+#endif
+}
+
+// Sleep until the specified time (GetCycleTimeNs)
+static void SleepUntilNs(int64_t deadline)
+{
+#ifdef __linux__
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadline/1000000000LL);
+    ts.tv_nsec = static_cast<long>(deadline%1000000000LL);
+    // Restart if interrupted by a signal (the deadline is absolute)
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#else
+    int64_t timeLeft = deadline - GetCycleTimeNs();
+    if (timeLeft > 0)
+        Amp1394_Sleep(timeLeft*1.0e-9);
+#endif
+}
+
+void CycleExecutor::CycleStats::Reset(void)
+{
+    numCycles = 0;
+    numOverruns = 0;
+    numSkipped = 0;
+    numLateWakeups = 0;
+    numReadErrors = 0;
+    numWriteErrors = 0;
+    wakeup.Reset();
+    execution.Reset();
+    slack.Reset();
+}
+
+void CycleExecutor::CycleStats::Print(std::ostream &outStr) const
+{
+    outStr << "Cycles: " << numCycles << ", overruns: " << numOverruns << ", skipped: " << numSkipped
+           << ", late wakeups: " << numLateWakeups << ", read errors: " << numReadErrors
+           << ", write errors: " << numWriteErrors << std::endl;
+    outStr << "  wakeup:    ";
+    wakeup.PrintSummary(outStr);
+    outStr << std::endl << "  execution: ";
+    execution.PrintSummary(outStr);
+    outStr << std::endl << "  slack:     ";
+    slack.PrintSummary(outStr);
+    outStr << std::endl;
+}
+
+CycleExecutor::CycleExecutor(BasePort &p, double periodSec, std::ostream &debugStream) :
+    port(p), outStr(debugStream), periodNs(0), lateThresholdNs(0), rtPriority(0), cpuNum(-1),
+    readCallback(0), computeCallback(0), writeCallback(0), readData(0), computeData(0), writeData(0),
+    stopRequested(false), isRunning(false)
+{
+    SetPeriod(periodSec);
+}
+
+void CycleExecutor::SetPeriod(double periodSec)
+{
+    if (periodSec <= 0.0) {
+        outStr << "CycleExecutor::SetPeriod: invalid period " << periodSec << std::endl;
+        return;
+    }
+    periodNs = static_cast<int64_t>(periodSec*1.0e9+0.5);
+    lateThresholdNs = periodNs/10;
+}
+
+bool CycleExecutor::SetThreadParameters(void)
+{
+    return SetCurrentThreadParameters(rtPriority, cpuNum, outStr);
+}
+
+bool CycleExecutor::SetCurrentThreadParameters(int rtPriority, int cpuNum, std::ostream &outStr)
+{
+#ifdef __linux__
+    // Reduce the timer slack (default 50 us for non real-time threads), which otherwise
+    // delays the wakeup from clock_nanosleep
+    prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+    if (rtPriority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = rtPriority;
+        // pid 0 is the calling thread
+        if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+            outStr << "SetCurrentThreadParameters: failed to set SCHED_FIFO priority " << rtPriority
+                   << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    if (cpuNum >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpuNum, &cpuSet);
+        if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+            outStr << "SetCurrentThreadParameters: failed to set affinity to CPU " << cpuNum
+                   << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+#else
+    if ((rtPriority > 0) || (cpuNum >= 0)) {
+        outStr << "SetCurrentThreadParameters: real-time priority and CPU affinity only supported on Linux" << std::endl;
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool CycleExecutor::Run(unsigned long numCycles)
+{
+    if (isRunning) {
+        outStr << "CycleExecutor::Run: already running" << std::endl;
+        return false;
+    }
+    if (periodNs <= 0) {
+        outStr << "CycleExecutor::Run: period not set" << std::endl;
+        return false;
+    }
+    if (!SetThreadParameters())
+        return false;
+
+    isRunning = true;
+    stopRequested = false;
+    unsigned long cycle = 0;
+    int64_t deadline = GetCycleTimeNs();   // start of next cycle
+    while (!stopRequested && ((numCycles == 0) || (cycle < numCycles))) {
+        SleepUntilNs(deadline);
+        int64_t wakeTime = GetCycleTimeNs();
+        int64_t late = wakeTime - deadline;
+        if (late < 0) late = 0;
+        stats.wakeup.Record(late);
+        if (late > lateThresholdNs)
+            stats.numLateWakeups++;
+
+        // A callback that returns false stops the loop; for the read and write callbacks,
+        // this is also counted as an error
+        bool ok = true;
+        if (readCallback) {
+            ok = readCallback(port, readData);
+            if (!ok)
+                stats.numReadErrors++;
+        }
+        else if (!port.ReadAllBoards())
+            stats.numReadErrors++;
+        if (ok && computeCallback)
+            ok = computeCallback(port, computeData);
+        if (ok) {
+            if (writeCallback) {
+                ok = writeCallback(port, writeData);
+                if (!ok)
+                    stats.numWriteErrors++;
+            }
+            else if (!port.WriteAllBoards())
+                stats.numWriteErrors++;
+        }
+
+        int64_t endTime = GetCycleTimeNs();
+        stats.execution.Record(endTime - wakeTime);
+        stats.numCycles++;
+        cycle++;
+        if (!ok) {
+            isRunning = false;
+            return false;
+        }
+
+        deadline += periodNs;
+        if (endTime > deadline) {
+            // Overrun: skip the missed cycles, so that the schedule is maintained
+            stats.numOverruns++;
+            int64_t missed = (endTime - deadline)/periodNs + 1;
+            stats.numSkipped += static_cast<unsigned long>(missed);
+            deadline += missed*periodNs;
+        }
+        else
+            stats.slack.Record(deadline - endTime);
+    }
+    isRunning = false;
+    return true;
+}
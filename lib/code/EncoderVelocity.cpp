@@ -69,7 +69,7 @@ void EncoderVelocity::Init()
 void EncoderVelocity::SetData(uint32_t rawPeriod, uint32_t rawQtr1, uint32_t rawQtr5, uint32_t rawRun,
                               bool isESPM)
 {
-    Init();
+    // All members are set below, so there is no need to call Init
     clkPeriod = isESPM ? VEL_PERD_ESPM : VEL_PERD;
     velPeriodMax = ENC_VEL_MASK_26;
     qtrPeriodMax = ENC_VEL_QTR_MASK;  // 26 bits
@@ -20,6 +20,7 @@ http://www.cisst.org/cisst/license.txt.
 #include "Amp1394Time.h"
 #include "Amp1394BSwap.h"
 #include <iomanip>
+#include <algorithm>   // for std::min, std::swap_ranges
 
 #ifdef _MSC_VER
 #include <string>
@@ -36,7 +37,15 @@ EthBasePort::EthBasePort(int portNum, std::ostream &debugStream, EthCallbackType
     BasePort(portNum, debugStream),
     fw_tl(0),
     eth_read_callback(cb),
-    ReceiveTimeout(0.02)
+    ReceiveTimeout(0.02),
+    ReceiveMode(RECV_WAIT),
+    BusyPollUsec(0),
+    RecvSpinCount(0),
+    RecvSpinMax(0),
+    Timestamping(false),
+    TimestampingHardware(false),
+    LastTimingPending(false),
+    LastTimingRoundTrip(0.0)
 {
 }
 
@@ -44,6 +53,47 @@ EthBasePort::~EthBasePort()
 {
 }
 
+// Default implementation only supports RECV_WAIT
+bool EthBasePort::SetReceiveMode(ReceiveModeType mode, unsigned int)
+{
+    if (mode != RECV_WAIT) {
+        outStr << "SetReceiveMode: receive mode not supported by " << GetPortTypeString() << " port" << std::endl;
+        return false;
+    }
+    ReceiveMode = mode;
+    BusyPollUsec = 0;
+    return true;
+}
+
+// Default implementation does not support timestamps
+bool EthBasePort::SetTimestamping(bool enable, bool)
+{
+    if (enable) {
+        outStr << "SetTimestamping: packet timestamps not supported by " << GetPortTypeString() << " port" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void EthBasePort::SetTransactionTiming(double sendTime, const EthTimestamp &txStamp,
+                                       const EthTimestamp &rxStamp, double recvTime)
+{
+    LastTiming = TransactionTiming();
+    LastTimingPending = false;
+    // The host times require the software timestamps, which use the same clock as sendTime and recvTime
+    if ((txStamp.sw == 0.0) || (rxStamp.sw == 0.0))
+        return;
+    LastTiming.hostSend = txStamp.sw - sendTime;
+    LastTiming.hostReceive = recvTime - rxStamp.sw;
+    // Hardware timestamps (if available) give a better measurement of the wire time
+    LastTiming.hardware = (txStamp.hw != 0.0) && (rxStamp.hw != 0.0);
+    if (LastTiming.hardware)
+        LastTimingRoundTrip = rxStamp.hw - txStamp.hw;
+    else
+        LastTimingRoundTrip = rxStamp.sw - txStamp.sw;
+    LastTimingPending = true;
+}
+
 void EthBasePort::GetDestMacAddr(unsigned char *macAddr)
 {
     // CID,0x1394,boardid(0)
@@ -107,6 +157,13 @@ void EthBasePort::ProcessExtraData(const unsigned char *packet)
     FPGA_RecvTime = bswap_16(packetW[2])/(FPGA_sysclk_MHz*1.0e6);
     FPGA_TotalTime = bswap_16(packetW[3])/(FPGA_sysclk_MHz*1.0e6);
 
+    if (LastTimingPending) {
+        LastTiming.fpga = FPGA_TotalTime;
+        LastTiming.wire = LastTimingRoundTrip - FPGA_TotalTime;
+        LastTiming.valid = true;
+        LastTimingPending = false;
+    }
+
     if (FwBusGeneration_FPGA != FwBusGeneration)
         OnFwBusReset(FwBusGeneration_FPGA);
 }
@@ -677,20 +734,28 @@ bool EthBasePort::ReadQuadletNode(nodeid_t node, nodeaddr_t addr, quadlet_t &dat
 
     // Build FireWire packet
     make_qread_packet(reinterpret_cast<quadlet_t *>(sendPacket+GetPrefixOffset(WR_FW_HEADER)), node, addr, fw_tl);
-    if (!PacketSend(sendPacket, sendPacketSize, flags&FW_NODE_ETH_BROADCAST_MASK))
-        return false;
-
-    // Invoke callback (if defined) between sending read request
-    // and checking for read response. If callback returns false, we
-    // skip checking for a received packet.
-    if (eth_read_callback && !(*eth_read_callback)(*this, node, outStr)) {
-        outStr << "ReadQuadlet: callback aborting (not reading packet)" << std::endl;
-        return false;
-    }
 
     unsigned char *recvPacket = GenericBuffer+GetReadQuadAlign();
     unsigned int recvPacketSize = GetPrefixOffset(RD_FW_HEADER)+FW_QRESPONSE_SIZE+FW_EXTRA_SIZE;
-    int nRecv = PacketReceive(recvPacket, recvPacketSize);
+    int nRecv;
+    if (eth_read_callback) {
+        if (!PacketSend(sendPacket, sendPacketSize, flags&FW_NODE_ETH_BROADCAST_MASK))
+            return false;
+        // Invoke callback (if defined) between sending read request
+        // and checking for read response. If callback returns false, we
+        // skip checking for a received packet.
+        if (!(*eth_read_callback)(*this, node, outStr)) {
+            outStr << "ReadQuadlet: callback aborting (not reading packet)" << std::endl;
+            return false;
+        }
+        nRecv = PacketReceive(recvPacket, recvPacketSize);
+    }
+    else {
+        nRecv = PacketSendReceive(sendPacket, sendPacketSize, flags&FW_NODE_ETH_BROADCAST_MASK,
+                                  recvPacket, recvPacketSize);
+        if (nRecv < 0)
+            return false;
+    }
     if (nRecv != static_cast<int>(recvPacketSize)) {
         // Only print message if Node2Board contains valid board number, to avoid unnecessary error messages during ScanNodes.
         unsigned int boardId = Node2Board[node];
@@ -758,28 +823,42 @@ bool EthBasePort::ReadBlockNode(nodeid_t node, nodeaddr_t addr, quadlet_t *rdata
 
     // Build FireWire packet
     make_bread_packet(reinterpret_cast<quadlet_t *>(sendPacket+GetPrefixOffset(WR_FW_HEADER)), node, addr, nbytes, fw_tl);
-    if (!PacketSend(sendPacket, sendPacketSize, flags&FW_NODE_ETH_BROADCAST_MASK))
-        return false;
-
-    // Invoke callback (if defined) between sending read request
-    // and checking for read response. If callback returns false, we
-    // skip checking for a received packet.
-    if (eth_read_callback && !(*eth_read_callback)(*this, node, outStr)) {
-        outStr << "ReadBlock: callback aborting (not reading packet)" << std::endl;
-        return false;
-    }
 
     // Packet to receive
     unsigned char *packet = GenericBuffer+GetReadQuadAlign();;
     unsigned int packetSize = GetPrefixOffset(RD_FW_BDATA) + nbytes + GetReadPostfixSize();
 
-    // Check for real-time read
+    // Check for real-time read, which is received directly into the broadcast buffer or the
+    // board's read slot (see BasePort::GetReadSlotData), so that the data is not copied
     unsigned char *rdata_base = reinterpret_cast<unsigned char *>(rdata)-GetReadQuadAlign()-GetPrefixOffset(RD_FW_BDATA);
     if (rdata_base == ReadBufferBroadcast) {
-        packet = ReadBufferBroadcast;
+        packet = ReadBufferBroadcast+GetReadQuadAlign();
+    }
+    else {
+        unsigned char *slotPacket = GetReadSlotPacket(rdata, nbytes);
+        if (slotPacket)
+            packet = slotPacket;
     }
 
-    int nRecv = PacketReceive(packet, packetSize);
+    int nRecv;
+    if (eth_read_callback) {
+        if (!PacketSend(sendPacket, sendPacketSize, flags&FW_NODE_ETH_BROADCAST_MASK))
+            return false;
+        // Invoke callback (if defined) between sending read request
+        // and checking for read response. If callback returns false, we
+        // skip checking for a received packet.
+        if (!(*eth_read_callback)(*this, node, outStr)) {
+            outStr << "ReadBlock: callback aborting (not reading packet)" << std::endl;
+            return false;
+        }
+        nRecv = PacketReceive(packet, packetSize);
+    }
+    else {
+        nRecv = PacketSendReceive(sendPacket, sendPacketSize, flags&FW_NODE_ETH_BROADCAST_MASK,
+                                  packet, packetSize);
+        if (nRecv < 0)
+            return false;
+    }
     if (nRecv != static_cast<int>(packetSize)) {
         unsigned char boardId = Node2Board[node];
         outStr << "ReadBlock: failed to receive read response from board " << (boardId&FW_NODE_MASK)
@@ -832,6 +911,266 @@ bool EthBasePort::WriteBlockNode(nodeid_t node, nodeaddr_t addr, quadlet_t *wdat
     return PacketSend(packet, packetSize, flags&FW_NODE_ETH_BROADCAST_MASK);
 }
 
+int EthBasePort::PacketSendReceive(unsigned char *sendPacket, size_t sendBytes, bool useEthernetBroadcast,
+                                   unsigned char *recvPacket, size_t recvBytes)
+{
+    if (!PacketSend(sendPacket, sendBytes, useEthernetBroadcast))
+        return -1;
+    return PacketReceive(recvPacket, recvBytes);
+}
+
+unsigned int EthBasePort::PacketSendBatch(unsigned char * const *packets, const size_t *nbytes,
+                                          unsigned int num, bool useEthernetBroadcast)
+{
+    unsigned int i;
+    for (i = 0; i < num; i++) {
+        if (!PacketSend(packets[i], nbytes[i], useEthernetBroadcast))
+            break;
+    }
+    return i;
+}
+
+unsigned int EthBasePort::PacketReceiveBatch(unsigned char * const *packets, const size_t *nbytes,
+                                             int *nRecv, unsigned int num)
+{
+    unsigned int i;
+    for (i = 0; i < num; i++) {
+        nRecv[i] = PacketReceive(packets[i], nbytes[i]);
+        if (nRecv[i] <= 0)
+            break;
+    }
+    return i;
+}
+
+void EthBasePort::ReadBlockMultiple(const unsigned char *boardList, quadlet_t * const *rdata,
+                                    const unsigned int *nbytes, bool *ok, unsigned int num)
+{
+    if (StartReadBlockMultiple(boardList, rdata, nbytes, ok, num))
+        FinishReadBlockMultiple(ok, num);
+}
+
+bool EthBasePort::StartReadBlockMultiple(const unsigned char *boardList, quadlet_t * const *rdata,
+                                         const unsigned int *nbytes, bool *ok, unsigned int num)
+{
+    unsigned int i;
+    for (i = 0; i < num; i++)
+        ok[i] = false;
+    blockReadPending.num = 0;
+    for (i = 0; i <= FW_TL_MASK; i++)
+        inFlight[i].active = false;
+    // Responses to these requests are not timed
+    LastTimingPending = false;
+
+    if (!CheckFwBusGeneration("ReadBlockMultiple"))
+        return false;
+
+    // Note that there is no need to flush before reading, because any stale packets
+    // are discarded by FinishReadBlockMultiple (based on the transaction label).
+
+    // Buffer for the read requests; 16 quadlets is large enough for the prefix
+    // (including the Ethernet frame header for EthRawPort) and FW_BREAD_SIZE.
+    quadlet_t sendBuffer[BoardIO::MAX_BOARDS][16];
+    unsigned char *sendPackets[BoardIO::MAX_BOARDS];
+    size_t sendSizes[BoardIO::MAX_BOARDS];
+    unsigned int numReq = 0;
+
+    for (i = 0; (i < num) && (numReq < BoardIO::MAX_BOARDS); i++) {
+        if ((nbytes[i] <= sizeof(quadlet_t)) || ((nbytes[i]%4) != 0) || (nbytes[i] > GetMaxReadDataSize())) {
+            // Let ReadBlock handle (or report) anything unusual
+            ok[i] = ReadBlock(boardList[i], 0, rdata[i], nbytes[i]);
+            continue;
+        }
+        nodeid_t node = ConvertBoardToNode(boardList[i]);
+        if (node >= MAX_NODES)
+            continue;
+
+        // Increment transaction label
+        fw_tl = (fw_tl+1)&FW_TL_MASK;
+
+        unsigned char *sendPacket = reinterpret_cast<unsigned char *>(sendBuffer[numReq])+GetWriteQuadAlign();
+        sendSizes[numReq] = GetPrefixOffset(WR_FW_HEADER)+FW_BREAD_SIZE;
+        make_write_header(sendPacket, sendSizes[numReq], 0);
+        make_bread_packet(reinterpret_cast<quadlet_t *>(sendPacket+GetPrefixOffset(WR_FW_HEADER)), node, 0, nbytes[i], fw_tl);
+        sendPackets[numReq] = sendPacket;
+
+        // Receive directly into the caller's buffer (see BasePort::GetReadSlotData)
+        blockReadPending.packet[numReq] = reinterpret_cast<unsigned char *>(rdata[i])-GetPrefixOffset(RD_FW_BDATA);
+        blockReadPending.size[numReq] = GetPrefixOffset(RD_FW_BDATA) + nbytes[i] + GetReadPostfixSize();
+        // Use the full slot, since a response may be received into the slot of another request
+        // (with a different size) and then moved
+        blockReadPending.capacity[numReq] = GetReadSlotPacket(rdata[i], nbytes[i])
+                                            ? (ReadSlotSize - GetReadQuadAlign()) : blockReadPending.size[numReq];
+        blockReadPending.nbytes[numReq] = nbytes[i];
+        blockReadPending.index[numReq] = i;
+        blockReadPending.boardId[numReq] = boardList[i];
+        blockReadPending.node[numReq] = node;
+        blockReadPending.tl[numReq] = fw_tl;
+        inFlight[fw_tl].request = numReq;
+        numReq++;
+    }
+    if (numReq == 0)
+        return false;
+
+    unsigned int numSent = PacketSendBatch(sendPackets, sendSizes, numReq, false);
+    if (numSent != numReq)
+        outStr << "ReadBlockMultiple: sent " << numSent << " of " << numReq << " requests" << std::endl;
+    for (i = 0; i < numSent; i++)
+        inFlight[blockReadPending.tl[i]].active = true;
+    blockReadPending.num = numSent;
+    return true;
+}
+
+void EthBasePort::FinishReadBlockMultiple(bool *ok, unsigned int)
+{
+    unsigned int i;
+    unsigned int numSent = blockReadPending.num;
+    blockReadPending.num = 0;
+
+    // Invoke callback (if defined) between sending read requests
+    // and checking for read responses.
+    if (eth_read_callback) {
+        for (i = 0; i < numSent; i++) {
+            if (!(*eth_read_callback)(*this, blockReadPending.node[i], outStr)) {
+                outStr << "ReadBlockMultiple: callback aborting (not reading packets)" << std::endl;
+                return;
+            }
+        }
+    }
+
+    // Receive the responses, which may arrive in any order. Each response is received into the
+    // slot (packet buffer) of a request that has not yet been answered; the transaction label
+    // is then used to find the request that it belongs to.
+    int nRecv[BoardIO::MAX_BOARDS];      // bytes received, indexed by slot
+    int holder[BoardIO::MAX_BOARDS];     // slot holding the response, indexed by request (-1 if none)
+    bool slotUsed[BoardIO::MAX_BOARDS];
+    for (i = 0; i < numSent; i++) {
+        nRecv[i] = 0;
+        holder[i] = -1;
+        slotUsed[i] = false;
+    }
+    unsigned int numDone = 0;
+    while (numDone < numSent) {
+        unsigned char *freePackets[BoardIO::MAX_BOARDS];
+        size_t freeSizes[BoardIO::MAX_BOARDS];
+        unsigned int freeSlots[BoardIO::MAX_BOARDS];
+        int freeRecv[BoardIO::MAX_BOARDS];
+        unsigned int numFree = 0;
+        for (i = 0; i < numSent; i++) {
+            if (!slotUsed[i]) {
+                freePackets[numFree] = blockReadPending.packet[i];
+                freeSizes[numFree] = blockReadPending.capacity[i];
+                freeSlots[numFree] = i;
+                numFree++;
+            }
+        }
+        unsigned int numRecv = PacketReceiveBatch(freePackets, freeSizes, freeRecv, numSent-numDone);
+        if (numRecv == 0)
+            break;
+        for (i = 0; i < numRecv; i++) {
+            unsigned int slot = freeSlots[i];
+            if (freeRecv[i] < static_cast<int>(GetPrefixOffset(RD_FW_HEADER)+FW_QRESPONSE_SIZE))
+                continue;
+            unsigned int tl_recv = blockReadPending.packet[slot][GetPrefixOffset(RD_FW_HEADER)+2] >> 2;
+            if (!inFlight[tl_recv].active) {
+                outStr << "ReadBlockMultiple: discarding packet with tl = " << tl_recv << std::endl;
+                continue;
+            }
+            inFlight[tl_recv].active = false;
+            holder[inFlight[tl_recv].request] = slot;
+            slotUsed[slot] = true;
+            nRecv[slot] = freeRecv[i];
+            numDone++;
+        }
+    }
+    for (i = 0; i < numSent; i++)
+        inFlight[blockReadPending.tl[i]].active = false;
+
+    // Move responses to the slot of the corresponding request (usually not needed, because
+    // the responses are normally received in the same order as the requests).
+    for (i = 0; i < numSent; i++) {
+        int slot = holder[i];
+        if ((slot < 0) || (static_cast<unsigned int>(slot) == i))
+            continue;
+        size_t len = std::min(blockReadPending.capacity[i], blockReadPending.capacity[slot]);
+        std::swap_ranges(blockReadPending.packet[i], blockReadPending.packet[i]+len, blockReadPending.packet[slot]);
+        std::swap(nRecv[i], nRecv[slot]);
+        // Update the request whose response was in slot i (if any)
+        for (unsigned int j = i+1; j < numSent; j++) {
+            if (holder[j] == static_cast<int>(i)) {
+                holder[j] = slot;
+                break;
+            }
+        }
+        holder[i] = i;
+    }
+
+    for (i = 0; i < numSent; i++) {
+        if (holder[i] < 0) {
+            outStr << "ReadBlockMultiple: failed to receive read response from board "
+                   << static_cast<unsigned int>(blockReadPending.boardId[i]) << std::endl;
+            continue;
+        }
+        unsigned char *packet = blockReadPending.packet[i];
+        if (nRecv[i] != static_cast<int>(blockReadPending.size[i])) {
+            outStr << "ReadBlockMultiple: failed to receive read response from board "
+                   << static_cast<unsigned int>(blockReadPending.boardId[i]) << ": return value = " << nRecv[i]
+                   << ", expected = " << blockReadPending.size[i] << std::endl;
+            continue;
+        }
+        ProcessExtraData(packet+blockReadPending.size[i]-FW_EXTRA_SIZE);
+        if (!CheckEthernetHeader(packet, false))
+            continue;
+        if (!CheckFirewirePacket(packet+GetPrefixOffset(RD_FW_HEADER), blockReadPending.nbytes[i], blockReadPending.node[i],
+                                 EthBasePort::BRESPONSE, blockReadPending.tl[i]))
+            continue;
+        ok[blockReadPending.index[i]] = true;
+    }
+}
+
+void EthBasePort::WriteBlockMultiple(const unsigned char *boardList, quadlet_t * const *wdata,
+                                     const unsigned int *nbytes, bool *ok, unsigned int num)
+{
+    unsigned int i;
+    for (i = 0; i < num; i++)
+        ok[i] = false;
+
+    if (!CheckFwBusGeneration("WriteBlockMultiple"))
+        return;
+
+    unsigned char *sendPackets[BoardIO::MAX_BOARDS];
+    size_t sendSizes[BoardIO::MAX_BOARDS];
+    unsigned int index[BoardIO::MAX_BOARDS];     // index into boardList
+    unsigned int numReq = 0;
+
+    for (i = 0; (i < num) && (numReq < BoardIO::MAX_BOARDS); i++) {
+        if ((nbytes[i] <= sizeof(quadlet_t)) || ((nbytes[i]%4) != 0) || (nbytes[i] > GetMaxWriteDataSize())) {
+            ok[i] = WriteBlock(boardList[i], 0, wdata[i], nbytes[i]);
+            continue;
+        }
+        nodeid_t node = ConvertBoardToNode(boardList[i]);
+        if (node >= MAX_NODES)
+            continue;
+
+        // Build the packet in place (see BasePort::GetWriteSlotData)
+        unsigned char *packet = reinterpret_cast<unsigned char *>(wdata[i])-GetPrefixOffset(WR_FW_BDATA);
+        sendSizes[numReq] = GetPrefixOffset(WR_FW_BDATA) + nbytes[i] + GetWritePostfixSize();
+
+        // Increment transaction label
+        fw_tl = (fw_tl+1)&FW_TL_MASK;
+
+        make_write_header(packet, sendSizes[numReq], 0);
+        make_bwrite_packet(reinterpret_cast<quadlet_t *>(packet+GetPrefixOffset(WR_FW_HEADER)), node, 0,
+                           wdata[i], nbytes[i], fw_tl);
+        sendPackets[numReq] = packet;
+        index[numReq] = i;
+        numReq++;
+    }
+
+    unsigned int numSent = (numReq > 0) ? PacketSendBatch(sendPackets, sendSizes, numReq, false) : 0;
+    for (i = 0; i < numSent; i++)
+        ok[index[i]] = true;
+}
+
 void EthBasePort::OnNoneRead(void)
 {
     outStr << "Failed to read any board, check Ethernet physical connection" << std::endl;
@@ -859,13 +1198,65 @@ bool EthBasePort::WriteBroadcastReadRequest(unsigned int seq)
     return WriteQuadlet(FW_NODE_BROADCAST, 0x1800, bcReqData);
 }
 
-void EthBasePort::WaitBroadcastRead(void)
+unsigned int EthBasePort::WriteBroadcastOutputAndReadRequest(quadlet_t *buffer, unsigned int size, unsigned int seq)
+{
+    // Each Ethernet frame carries a single FireWire packet, so the two packets are sent back-to-back
+    SetGenericBuffer();   // Make sure buffer is allocated
+    unsigned char *sendPackets[2];
+    size_t sendSizes[2];
+
+    // Broadcast write (as in WriteBlockNode)
+    unsigned char *packet = GenericBuffer+GetWriteQuadAlign();
+    unsigned char *wdata_base = reinterpret_cast<unsigned char *>(buffer)-GetWriteQuadAlign()-GetPrefixOffset(WR_FW_BDATA);
+    if (wdata_base == WriteBufferBroadcast) {
+        packet = WriteBufferBroadcast+GetWriteQuadAlign();
+    }
+    sendSizes[0] = GetPrefixOffset(WR_FW_BDATA) + size + GetWritePostfixSize();
+    fw_tl = (fw_tl+1)&FW_TL_MASK;
+    make_write_header(packet, sendSizes[0], 0);
+    make_bwrite_packet(reinterpret_cast<quadlet_t *>(packet+GetPrefixOffset(WR_FW_HEADER)), FW_NODE_BROADCAST, 0, buffer, size, fw_tl);
+    sendPackets[0] = packet;
+
+    // Broadcast read request (as in WriteBroadcastReadRequest); 16 quadlets is large enough
+    // for the prefix and FW_QWRITE_SIZE.
+    quadlet_t reqBuffer[16];
+    unsigned char *reqPacket = reinterpret_cast<unsigned char *>(reqBuffer)+GetWriteQuadAlign();
+    sendSizes[1] = GetPrefixOffset(WR_FW_HEADER)+FW_QWRITE_SIZE;
+    fw_tl = (fw_tl+1)&FW_TL_MASK;
+    make_write_header(reqPacket, sendSizes[1], 0);
+    quadlet_t bcReqData = (seq << 16) | BoardInUseMask_;
+    make_qwrite_packet(reinterpret_cast<quadlet_t *>(reqPacket+GetPrefixOffset(WR_FW_HEADER)), FW_NODE_BROADCAST, 0x1800, bcReqData, fw_tl);
+    sendPackets[1] = reqPacket;
+
+    return PacketSendBatch(sendPackets, sendSizes, 2, false);
+}
+
+double EthBasePort::GetBroadcastReadWait(void) const
 {
-    // Wait for all boards to respond with data
     // Shorter wait: 10 + 5 * Nb us, where Nb is number of boards used in this configuration
     // Standard wait: 5 + 5 * Nn us, where Nn is the total number of nodes on the FireWire bus
     double waitTime_uS = 10.0 + 5.0*NumOfBoards_;
-    Amp1394_Sleep(waitTime_uS*1e-6);
+    return waitTime_uS*1e-6;
+}
+
+void EthBasePort::WaitBroadcastRead(void)
+{
+    // Wait for all boards to respond with data
+    double waitTime = GetBroadcastReadWait();
+    if (!WaitBroadcastReadAdaptive(waitTime))
+        Amp1394_Sleep(waitTime);
+}
+
+bool EthBasePort::FinishReadAllBoards(double timeoutSec)
+{
+    if (timeoutSec < 0.0)
+        return BasePort::FinishReadAllBoards(timeoutSec);
+    // Temporarily use the specified receive timeout
+    double saveTimeout = ReceiveTimeout;
+    ReceiveTimeout = timeoutSec;
+    bool ret = BasePort::FinishReadAllBoards(timeoutSec);
+    ReceiveTimeout = saveTimeout;
+    return ret;
 }
 
 void EthBasePort::PromDelay(void) const
@@ -19,6 +19,22 @@ http://www.cisst.org/cisst/license.txt.
 #include "Amp1394Time.h"
 #include "Amp1394BSwap.h"
 
+#if Amp1394_HAS_PACKET_MMAP
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#else // pcap
 #ifdef _MSC_VER
 // Following seems to be necessary on Windows, at least with Npcap
 #define PCAP_DONT_INCLUDE_PCAP_BPF_H
@@ -43,9 +59,224 @@ http://www.cisst.org/cisst/license.txt.
 #include <linux/if.h>
 #include <unistd.h>
 #endif
+#endif // Amp1394_HAS_PACKET_MMAP
+
+#if Amp1394_HAS_PACKET_MMAP
+
+// Receive ring shared with the kernel (AF_PACKET socket with PACKET_RX_RING). TPACKET_V2 is used
+// rather than TPACKET_V3 because V3 only passes a block of frames to user space when the block is
+// full or its timeout (at least 1 msec) expires, which is too long for a real-time read. With V2,
+// each frame is available as soon as its status is set to TP_STATUS_USER.
+struct PacketRing {
+    std::ostream &outStr;
+    int fd;
+    unsigned char *ring;
+    size_t ringSize;
+    unsigned int frameNum;
+    unsigned int index;         // next frame to check
+    bool BusyPoll;              // true to spin on the ring (rather than poll)
+    unsigned long SpinCount;    // number of times the ring was checked by last call to Receive
+    bool Timestamping;          // true if packet timestamps enabled
+    EthTimestamp TxStamp;       // transmit timestamp of last packet sent
+    EthTimestamp RxStamp;       // receive timestamp of last packet received
+
+    enum { FRAME_SIZE = 2048, BLOCK_SIZE = 4096, BLOCK_NUM = 64 };
+
+    PacketRing(std::ostream &ostr) : outStr(ostr), fd(-1), ring(0), ringSize(0), frameNum(0), index(0),
+                                     BusyPoll(false), SpinCount(0), Timestamping(false) {}
+    ~PacketRing() { Close(); }
+
+    // Open socket on the specified interface (index in if_nameindex list); returns local MAC address
+    bool Open(int portNum, uint8_t *localMac);
+    void Close(void);
+
+    // Returns the next frame in the ring (0 if none available); Release must be called when done.
+    struct tpacket2_hdr *Next(void) const
+    {
+        struct tpacket2_hdr *hdr = reinterpret_cast<struct tpacket2_hdr *>(ring + index*FRAME_SIZE);
+        return (__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) ? hdr : 0;
+    }
+    void Release(struct tpacket2_hdr *hdr)
+    {
+        __atomic_store_n(&hdr->tp_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        index = (index+1)%frameNum;
+    }
+
+    // Wait for the next frame, up to timeoutSec; returns 0 if timeout
+    struct tpacket2_hdr *Receive(double timeoutSec);
+};
+
+bool PacketRing::Open(int portNum, uint8_t *localMac)
+{
+    // Find interface
+    struct if_nameindex *ifList = if_nameindex();
+    if (!ifList) {
+        outStr << "ERROR: could not get list of network interfaces: " << strerror(errno) << std::endl;
+        return false;
+    }
+    int i;
+    for (i = 0; ifList[i].if_index != 0; i++) {
+        if (i == portNum) break;
+    }
+    if (ifList[i].if_index == 0) {
+        outStr << "Invalid Port Number, device does not exist" << std::endl;
+        for (i = 0; ifList[i].if_index != 0; i++)
+            outStr << i << " " << ifList[i].if_name << std::endl;
+        if_freenameindex(ifList);
+        return false;
+    }
+    unsigned int ifIndex = ifList[i].if_index;
+    std::string ifName(ifList[i].if_name);
+    if_freenameindex(ifList);
+
+    // Protocol 0, so that no packets are received until the socket is bound (after the filter is attached)
+    fd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (fd < 0) {
+        outStr << "ERROR: could not create AF_PACKET socket: " << strerror(errno)
+               << " -- perhaps need root privileges (or CAP_NET_RAW)?" << std::endl;
+        return false;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifName.c_str(), IFNAMSIZ-1);
+    if (ioctl(fd, SIOCGIFHWADDR, &ifr) != 0) {
+        outStr << "ERROR: could not get local MAC address for " << ifName << std::endl;
+        Close();
+        return false;
+    }
+    memcpy(localMac, ifr.ifr_hwaddr.sa_data, 6);
+
+    // BPF filter: only accept packets sent to this PC (destination is local MAC address) by an FPGA board
+    // (source address is FA:61:0E:13:94:xx, where xx is the board id). BPF loads are big endian.
+    uint8_t fpgaMac[6];
+    EthBasePort::GetDestMacAddr(fpgaMac);
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 0),
+        BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, (static_cast<uint32_t>(localMac[0])<<24)|(localMac[1]<<16)|(localMac[2]<<8)|localMac[3], 0, 7),
+        BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 4),
+        BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, (static_cast<uint32_t>(localMac[4])<<8)|localMac[5], 0, 5),
+        BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 6),
+        BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, (static_cast<uint32_t>(fpgaMac[0])<<24)|(fpgaMac[1]<<16)|(fpgaMac[2]<<8)|fpgaMac[3], 0, 3),
+        BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 10),
+        BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, fpgaMac[4], 0, 1),
+        BPF_STMT(BPF_RET|BPF_K, 0xffff),    // accept
+        BPF_STMT(BPF_RET|BPF_K, 0)          // drop
+    };
+    struct sock_fprog prog;
+    prog.len = sizeof(code)/sizeof(code[0]);
+    prog.filter = code;
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0) {
+        outStr << "ERROR: could not attach packet filter: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+
+    // Do not pass packets sent by this PC (on any socket) to the filter (Linux 4.20+)
+#ifdef PACKET_IGNORE_OUTGOING
+    int ignoreOutgoing = 1;
+    setsockopt(fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignoreOutgoing, sizeof(ignoreOutgoing));
+#endif
+
+    int version = TPACKET_V2;
+    if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+        outStr << "ERROR: could not set TPACKET_V2: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    struct tpacket_req req;
+    req.tp_block_size = BLOCK_SIZE;
+    req.tp_block_nr = BLOCK_NUM;
+    req.tp_frame_size = FRAME_SIZE;
+    req.tp_frame_nr = (BLOCK_SIZE/FRAME_SIZE)*BLOCK_NUM;
+    if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0) {
+        outStr << "ERROR: could not create receive ring: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    ringSize = static_cast<size_t>(req.tp_block_size)*req.tp_block_nr;
+    void *mem = mmap(0, ringSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_LOCKED, fd, 0);
+    if (mem == MAP_FAILED) {
+        // MAP_LOCKED may fail due to RLIMIT_MEMLOCK
+        mem = mmap(0, ringSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (mem == MAP_FAILED) {
+        outStr << "ERROR: could not map receive ring: " << strerror(errno) << std::endl;
+        ringSize = 0;
+        Close();
+        return false;
+    }
+    ring = static_cast<unsigned char *>(mem);
+    frameNum = req.tp_frame_nr;
+    index = 0;
+
+    struct sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = ifIndex;
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        outStr << "ERROR: could not bind to " << ifName << ": " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    outStr << "Opened " << ifName << " (AF_PACKET, " << frameNum << " frame receive ring)" << std::endl;
+    return true;
+}
+
+void PacketRing::Close(void)
+{
+    if (ring) {
+        munmap(ring, ringSize);
+        ring = 0;
+        ringSize = 0;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+struct tpacket2_hdr *PacketRing::Receive(double timeoutSec)
+{
+    SpinCount = 1;
+    struct tpacket2_hdr *hdr = Next();
+    if (hdr)
+        return hdr;
+
+    // Not yet available, so wait (or spin) until timeout
+    double deadline = Amp1394_GetTime() + timeoutSec;
+    for (;;) {
+        if (!BusyPoll) {
+            double timeLeft = deadline - Amp1394_GetTime();
+            if (timeLeft <= 0.0)
+                return 0;
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(timeLeft);
+            ts.tv_nsec = static_cast<long>((timeLeft-ts.tv_sec)*1.0e9);
+            ppoll(&pfd, 1, &ts, 0);
+            // A transmit timestamp in the error queue also wakes up ppoll
+            if (pfd.revents & POLLERR)
+                EthTimestampReadTx(fd, TxStamp);
+        }
+        SpinCount++;
+        hdr = Next();
+        if (hdr)
+            return hdr;
+        // When spinning, only check the time occasionally
+        if (BusyPoll && ((SpinCount%64) == 0) && (Amp1394_GetTime() > deadline))
+            return 0;
+    }
+}
+
+#endif // Amp1394_HAS_PACKET_MMAP
 
 EthRawPort::EthRawPort(int portNum, std::ostream &debugStream, EthCallbackType cb):
-    EthBasePort(portNum, debugStream, cb)
+    EthBasePort(portNum, debugStream, cb), handle(0), ringPtr(0)
 {
     if (Init())
         outStr << "Initialization done" << std::endl;
@@ -53,6 +284,11 @@ EthRawPort::EthRawPort(int portNum, std::ostream &debugStream, EthCallbackType c
         outStr << "Initialization failed" << std::endl;
 }
 
+EthRawPort::EthRawPort(int portNum, std::ostream &debugStream, EthCallbackType cb, bool):
+    EthBasePort(portNum, debugStream, cb), handle(0), ringPtr(0)
+{
+}
+
 EthRawPort::~EthRawPort()
 {
     Cleanup();
@@ -68,6 +304,17 @@ bool EthRawPort::Init(void)
     // Increase ReceiveTimeout
     ReceiveTimeout = 0.1;
 
+#if Amp1394_HAS_PACKET_MMAP
+    uint8_t eth_src[6];   // Ethernet source address (local MAC address)
+
+    ringPtr = new PacketRing(outStr);
+    if (!ringPtr->Open(PortNum, eth_src)) {
+        delete ringPtr;
+        ringPtr = 0;
+        return false;
+    }
+    EthBasePort::PrintMAC(outStr, "Local MAC address", eth_src);
+#else
     // Ethernet initialization
     pcap_if_t* alldevs;
     char errbuf[PCAP_ERRBUF_SIZE];
@@ -111,9 +358,6 @@ bool EthRawPort::Init(void)
         return false;
     }
 
-    // initialize ethernet header (FA-61-OE is CID assigned to LCSR by IEEE)
-    uint8_t eth_dst[6];
-    GetDestMacAddr(eth_dst);
     uint8_t eth_src[6];   // Ethernet source address (local MAC address, see below)
 
     // Get local MAC address. There doesn't seem to be a better (portable) way to do this.
@@ -190,11 +434,9 @@ bool EthRawPort::Init(void)
         outStr << "ERROR: could not install filter " << ss_filter.str() << "\n";
         return false;
     }
+#endif // Amp1394_HAS_PACKET_MMAP
 
-    memcpy(frame_hdr, eth_dst, 6);
-    memcpy(frame_hdr+6, eth_src, 6);
-    frame_hdr[12] = 0;   // length field
-    frame_hdr[13] = 0;   // length field
+    SetFrameHeader(eth_src);
 
     bool ret = ScanNodes();
 
@@ -212,7 +454,14 @@ bool EthRawPort::Init(void)
 
 void EthRawPort::Cleanup(void)
 {
-    pcap_close(handle);
+#if Amp1394_HAS_PACKET_MMAP
+    delete ringPtr;
+    ringPtr = 0;
+#else
+    if (handle)
+        pcap_close(handle);
+    handle = 0;
+#endif
 }
 
 nodeid_t EthRawPort::InitNodes(void)
@@ -257,7 +506,53 @@ nodeid_t EthRawPort::InitNodes(void)
 
 bool EthRawPort::IsOK(void)
 {
+#if Amp1394_HAS_PACKET_MMAP
+    return (ringPtr != 0);
+#else
     return (handle != NULL);
+#endif
+}
+
+bool EthRawPort::SetReceiveMode(ReceiveModeType mode, unsigned int busyPollUsec)
+{
+#if Amp1394_HAS_PACKET_MMAP
+    if ((mode != RECV_WAIT) && (mode != RECV_BUSY_POLL)) {
+        outStr << "SetReceiveMode: invalid receive mode: " << mode << std::endl;
+        return false;
+    }
+    if (!ringPtr)
+        return false;
+    if (busyPollUsec != 0)
+        outStr << "SetReceiveMode: SO_BUSY_POLL not used by raw Ethernet port" << std::endl;
+    ringPtr->BusyPoll = (mode == RECV_BUSY_POLL);
+    ReceiveMode = mode;
+    BusyPollUsec = 0;
+    return true;
+#else
+    return EthBasePort::SetReceiveMode(mode, busyPollUsec);
+#endif
+}
+
+bool EthRawPort::SetTimestamping(bool enable, bool hardware)
+{
+#if Amp1394_HAS_PACKET_MMAP
+    if (ringPtr) {
+        // The receive ring provides one timestamp per frame, which is used for the software timestamp
+        if (enable && hardware)
+            outStr << "SetTimestamping: hardware timestamps not supported by raw Ethernet port, "
+                   << "using software timestamps" << std::endl;
+        bool hwEnabled;
+        if (!EthTimestampEnable(ringPtr->fd, enable, "", false, hwEnabled, outStr))
+            return false;
+        ringPtr->Timestamping = enable;
+        Timestamping = enable;
+        TimestampingHardware = false;
+        LastTiming = TransactionTiming();
+        LastTimingPending = false;
+        return true;
+    }
+#endif
+    return EthBasePort::SetTimestamping(enable, hardware);
 }
 
 unsigned int EthRawPort::GetPrefixOffset(MsgType msg) const
@@ -285,15 +580,82 @@ unsigned int EthRawPort::GetMaxWriteDataSize(void) const
 
 bool EthRawPort::PacketSend(unsigned char *packet, size_t nbytes, bool)
 {
+#if Amp1394_HAS_PACKET_MMAP
+    ssize_t nSent;
+    if (ringPtr->Timestamping) {
+        // Request transmit timestamp (discarding any old ones)
+        EthTimestampReadTx(ringPtr->fd, ringPtr->TxStamp);
+        ringPtr->TxStamp.Clear();
+        char control[ETH_TIMESTAMP_CONTROL_SIZE];
+        struct iovec vec;
+        vec.iov_base = packet;
+        vec.iov_len = nbytes;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &vec;
+        msg.msg_iovlen = 1;
+        EthTimestampRequestTx(&msg, control, false);
+        nSent = sendmsg(ringPtr->fd, &msg, 0);
+    }
+    else
+        nSent = send(ringPtr->fd, packet, nbytes, 0);
+    if (nSent != static_cast<ssize_t>(nbytes)) {
+        outStr << "ERROR: send packet failed: " << ((nSent < 0) ? strerror(errno) : "incomplete") << std::endl;
+        return false;
+    }
+    return true;
+#else
     if (pcap_sendpacket(handle, packet, nbytes) != 0)  {
         outStr << "ERROR: PCAP send packet failed" << std::endl;
         return false;
     }
     return true;
+#endif
+}
+
+unsigned int EthRawPort::GetFrameLength(const unsigned char *packet, unsigned int caplen)
+{
+    unsigned int nRead = bswap_16(*reinterpret_cast<const uint16_t *>(packet+ETH_FRAME_LENGTH_OFFSET));
+    if (nRead < 1500) {
+        nRead += ETH_FRAME_HEADER_SIZE;
+    }
+    else {
+        // Shouldn't happen with raw Ethernet, but in case it does, use the capture length instead
+        nRead = caplen;
+    }
+    return nRead;
 }
 
 int EthRawPort::PacketReceive(unsigned char *recvPacket, size_t nbytes)
 {
+#if Amp1394_HAS_PACKET_MMAP
+    // The kernel filter only passes packets from the FPGA to this PC (see PacketRing::Open),
+    // so the first packet is used (in place).
+    struct tpacket2_hdr *hdr = ringPtr->Receive(ReceiveTimeout);
+    UpdateSpinCount(ringPtr->SpinCount);
+    if (!hdr)
+        return 0;
+    if (ringPtr->Timestamping)
+        ringPtr->RxStamp.sw = hdr->tp_sec + hdr->tp_nsec*1.0e-9;
+    const unsigned char *packet = reinterpret_cast<const unsigned char *>(hdr)+hdr->tp_mac;
+    unsigned int nRead = GetFrameLength(packet, hdr->tp_snaplen);
+    if (nRead == (ETH_FRAME_HEADER_SIZE + FW_EXTRA_SIZE)) {
+        outStr << "PacketReceive: only extra data" << std::endl;
+        ProcessExtraData(packet+ETH_FRAME_HEADER_SIZE);
+        nRead = 0;
+    }
+    if (nRead > hdr->tp_snaplen)
+        nRead = hdr->tp_snaplen;
+    if (nRead > nbytes) {
+        outStr << "PacketReceive: truncating packet from " << std::dec << nRead << " to "
+               << nbytes << " bytes" << std::endl;
+        nRead = nbytes;
+    }
+    if (nRead > 0)
+        memcpy(recvPacket, packet, nRead);
+    ringPtr->Release(hdr);
+    return static_cast<int>(nRead);
+#else
     struct pcap_pkthdr header;      /* The header that pcap gives us */
     const unsigned char *packet;    /* The actual packet */
     unsigned int numPackets = 0;
@@ -308,17 +670,10 @@ int EthRawPort::PacketReceive(unsigned char *recvPacket, size_t nbytes)
             numPackets++;
             if (headercheck(packet, true)) {
                 // Get length from Ethernet header
-                nRead = bswap_16(*reinterpret_cast<const uint16_t *>(packet+ETH_FRAME_LENGTH_OFFSET));
-                if (nRead < 1500) {
-                    nRead += ETH_FRAME_HEADER_SIZE;
-                }
-                else {
-                    // Shouldn't happen with raw Ethernet, but in case it does, use the capture length instead
-                    nRead = header.caplen;
-                }
+                nRead = GetFrameLength(packet, header.caplen);
                 if (nRead == (ETH_FRAME_HEADER_SIZE + FW_EXTRA_SIZE)) {
                     outStr << "PacketReceive: only extra data" << std::endl;
-                    ProcessExtraData(packet);
+                    ProcessExtraData(packet+ETH_FRAME_HEADER_SIZE);
                     nRead = 0;
                 }
                 numPacketsValid++;
@@ -339,15 +694,44 @@ int EthRawPort::PacketReceive(unsigned char *recvPacket, size_t nbytes)
            << ", time = " << timeDiffSec << " sec" << std::endl;
 #endif
     return static_cast<int>(nRead);
+#endif // Amp1394_HAS_PACKET_MMAP
+}
+
+int EthRawPort::PacketSendReceive(unsigned char *sendPacket, size_t sendBytes, bool useEthernetBroadcast,
+                                  unsigned char *recvPacket, size_t recvBytes)
+{
+#if Amp1394_HAS_PACKET_MMAP
+    if (ringPtr && ringPtr->Timestamping) {
+        ringPtr->RxStamp.Clear();
+        double sendTime = EthTimestampNow();
+        int nRecv = EthBasePort::PacketSendReceive(sendPacket, sendBytes, useEthernetBroadcast,
+                                                   recvPacket, recvBytes);
+        double recvTime = EthTimestampNow();
+        if (nRecv > 0) {
+            EthTimestampReadTx(ringPtr->fd, ringPtr->TxStamp);
+            SetTransactionTiming(sendTime, ringPtr->TxStamp, ringPtr->RxStamp, recvTime);
+        }
+        return nRecv;
+    }
+#endif
+    return EthBasePort::PacketSendReceive(sendPacket, sendBytes, useEthernetBroadcast, recvPacket, recvBytes);
 }
 
 int EthRawPort::PacketFlushAll(void)
 {
+    int numFlushed = 0;
+#if Amp1394_HAS_PACKET_MMAP
+    struct tpacket2_hdr *hdr;
+    while ((hdr = ringPtr->Next()) != 0) {
+        ringPtr->Release(hdr);
+        numFlushed++;
+    }
+#else
     struct pcap_pkthdr header;      /* The header that pcap gives us */
 
-    int numFlushed = 0;
     while (pcap_next(handle, &header))
         numFlushed++;
+#endif
     return numFlushed;
 }
 
@@ -361,6 +745,15 @@ bool EthRawPort::CheckEthernetHeader(const unsigned char *packet, bool useEthern
     return true;
 }
 
+void EthRawPort::SetFrameHeader(const uint8_t *localMac)
+{
+    // initialize ethernet header (FA-61-OE is CID assigned to LCSR by IEEE)
+    GetDestMacAddr(frame_hdr);
+    memcpy(frame_hdr+6, localMac, 6);
+    frame_hdr[12] = 0;   // length field
+    frame_hdr[13] = 0;   // length field
+}
+
 void EthRawPort::make_write_header(unsigned char *packet, unsigned int nBytes, unsigned char flags)
 {
     make_ethernet_header(packet, nBytes, flags);
@@ -0,0 +1,134 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include "EthTimestamp.h"
+
+#ifdef __linux__
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+
+static double TimespecToSec(const struct timespec &ts)
+{
+    return ts.tv_sec + ts.tv_nsec*1.0e-9;
+}
+
+double EthTimestampNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return TimespecToSec(ts);
+}
+
+bool EthTimestampEnable(int fd, bool enable, const std::string &ifName, bool hardware, bool &hwEnabled,
+                        std::ostream &outStr)
+{
+    hwEnabled = false;
+    if (enable && hardware) {
+        // Enable hardware timestamping of all packets on the interface
+        struct hwtstamp_config config;
+        memset(&config, 0, sizeof(config));
+        config.tx_type = HWTSTAMP_TX_ON;
+        config.rx_filter = HWTSTAMP_FILTER_ALL;
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, ifName.c_str(), IFNAMSIZ-1);
+        ifr.ifr_data = reinterpret_cast<char *>(&config);
+        if (ioctl(fd, SIOCSHWTSTAMP, &ifr) == 0)
+            hwEnabled = (config.rx_filter != HWTSTAMP_FILTER_NONE);
+        if (!hwEnabled)
+            outStr << "EthTimestampEnable: hardware timestamps not available on " << ifName
+                   << ", using software timestamps" << std::endl;
+    }
+    // The transmit timestamps are requested for each packet (see EthTimestampRequestTx)
+    int flags = 0;
+    if (enable) {
+        flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_TSONLY;
+        if (hwEnabled)
+            flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    }
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0) {
+        outStr << "EthTimestampEnable: failed to set SO_TIMESTAMPING: " << strerror(errno) << std::endl;
+        hwEnabled = false;
+        return false;
+    }
+    return true;
+}
+
+void EthTimestampRequestTx(struct msghdr *msg, char *controlBuf, bool hardware)
+{
+    memset(controlBuf, 0, ETH_TIMESTAMP_CONTROL_SIZE);
+    msg->msg_control = controlBuf;
+    msg->msg_controllen = CMSG_SPACE(sizeof(uint32_t));
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SO_TIMESTAMPING;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint32_t));
+    uint32_t flags = SOF_TIMESTAMPING_TX_SOFTWARE;
+    if (hardware)
+        flags |= SOF_TIMESTAMPING_TX_HARDWARE;
+    memcpy(CMSG_DATA(cmsg), &flags, sizeof(flags));
+}
+
+bool EthTimestampParse(struct msghdr *msg, EthTimestamp &ts)
+{
+    bool found = false;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != 0; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SO_TIMESTAMPING)) {
+            // ts[0] is the software timestamp and ts[2] is the (raw) hardware timestamp
+            struct timespec stamps[3];
+            memcpy(stamps, CMSG_DATA(cmsg), sizeof(stamps));
+            if (stamps[0].tv_sec || stamps[0].tv_nsec)
+                ts.sw = TimespecToSec(stamps[0]);
+            if (stamps[2].tv_sec || stamps[2].tv_nsec)
+                ts.hw = TimespecToSec(stamps[2]);
+            found = true;
+        }
+    }
+    return found;
+}
+
+int EthTimestampReadTx(int fd, EthTimestamp &ts)
+{
+    // With hardware timestamps, the software and hardware timestamps are reported separately
+    int num = 0;
+    for (;;) {
+        char control[ETH_TIMESTAMP_CONTROL_SIZE];
+        char data[64];    // not used (SOF_TIMESTAMPING_OPT_TSONLY)
+        struct iovec vec;
+        vec.iov_base = data;
+        vec.iov_len = sizeof(data);
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &vec;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE|MSG_DONTWAIT) < 0)
+            break;
+        if (EthTimestampParse(&msg, ts))
+            num++;
+    }
+    return num;
+}
+
+#endif // __linux__
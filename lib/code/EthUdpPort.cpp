@@ -15,6 +15,7 @@ http://www.cisst.org/cisst/license.txt.
 --- end cisst license ---
 */
 
+#include <Amp1394/AmpIORevision.h>
 #include "EthUdpPort.h"
 #include "Amp1394Time.h"
 #include "Amp1394BSwap.h"
@@ -48,6 +49,42 @@ typedef char assertion_on_in_addr[(sizeof(struct in_addr)==sizeof(uint32_t))*2-1
 
 #include <algorithm>   // for std::min
 
+#ifdef __linux__
+#include <time.h>      // for clock_gettime
+#include "EthTimestamp.h"
+// Socket options for busy polling (may not be defined by older headers)
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#endif
+
+#if Amp1394_HAS_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+// Flag for a non-blocking recv; on Windows, the socket itself is made
+// non-blocking (see SocketInternals::SetBusyPoll).
+#ifdef _MSC_VER
+#define RECV_DONTWAIT 0
+#else
+#define RECV_DONTWAIT MSG_DONTWAIT
+#endif
+
+// Returns true if the last socket error indicates that the non-blocking call would block
+static bool SocketWouldBlock(void)
+{
+#ifdef _MSC_VER
+    return (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    return ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+#endif
+}
+
 #ifdef _MSC_VER
 
 typedef WSAMSG     MsgHeaderType;
@@ -71,6 +108,288 @@ typedef struct msghdr  MsgHeaderType;
 typedef struct cmsghdr CMsgHdrType;
 #endif
 
+#if Amp1394_HAS_IO_URING
+
+// io_uring instance for the UDP socket (Linux only). The system calls are used directly, so that liburing
+// is not required. A read transaction (request and response) is submitted as a chain of linked operations:
+// send the request (SENDMSG), receive the response (RECV) and a timeout for the receive (LINK_TIMEOUT),
+// so that it only requires one call to io_uring_enter, instead of sendto, select and recv. In busy-poll
+// mode, the operations are submitted without waiting and the completion queue is checked in user space.
+// Only read transactions (PacketSendReceive) use the ring; a standalone send or receive is a single
+// system call either way, so PacketSend and PacketReceive use sendto and recv.
+struct UringInternals {
+    std::ostream &outStr;
+    int RingFD;
+    unsigned char *sqMap;
+    size_t sqMapSize;
+    unsigned char *cqMap;
+    size_t cqMapSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    uint32_t *sqTail;
+    uint32_t sqMask;
+    uint32_t *sqArray;
+    uint32_t *cqHead;
+    uint32_t *cqTail;
+    uint32_t cqMask;
+    struct io_uring_cqe *cqes;
+
+    // Must remain valid until the operations complete
+    struct msghdr sendMsg;
+    struct iovec sendVec;
+    struct __kernel_timespec recvTimeout;
+
+    enum { RING_SIZE = 8 };
+    enum { TAG_SEND = 1, TAG_RECV, TAG_TIMEOUT, TAG_CANCEL };
+    enum { NUM_OPS = 3 };     // operations (and completions) per read transaction
+
+    UringInternals(std::ostream &ostr);
+    ~UringInternals() { Close(); }
+
+    // Create the ring and register the socket
+    bool Open(int socketFD);
+    void Close(void);
+
+    // Send the packet to addr and receive the response, waiting at most timeoutSec. Returns the number
+    // of bytes received (0 if timeout, -1 on receive error) and sets sendOK. If busyPoll is true, spins
+    // on the completion queue; numSpins is the number of times the completion queue was checked.
+    // If io_uring_enter fails, the ring is closed (see Abort) and IsOpen returns false.
+    int SendRecv(const unsigned char *bufsend, size_t msglen, struct sockaddr_in *addr,
+                 unsigned char *bufrecv, size_t maxlen, double timeoutSec, bool busyPoll,
+                 bool &sendOK, unsigned long &numSpins);
+
+    bool IsOpen(void) const { return (RingFD >= 0); }
+
+    // Discard any completions left from a previous (failed) call to SendRecv
+    void DiscardCompletions(void)
+    { __atomic_store_n(cqHead, __atomic_load_n(cqTail, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE); }
+
+protected:
+    // Returns next SQE (cleared), with the fixed file (index 0) set
+    struct io_uring_sqe *NextSqe(uint8_t opcode, uint64_t tag, uint8_t flags);
+
+    // Called by SendRecv when io_uring_enter fails, where toSubmit is the number of operations not yet
+    // submitted and numDone is the number of completions already received. If the chain was submitted,
+    // cancels the receive and waits for the remaining completions, so that the kernel no longer uses the
+    // caller's buffers. Then closes the ring, so that stale operations or completions cannot be mistaken
+    // for those of a later transaction.
+    void Abort(unsigned int toSubmit, unsigned int numDone);
+};
+
+UringInternals::UringInternals(std::ostream &ostr) : outStr(ostr), RingFD(-1), sqMap(0), sqMapSize(0),
+    cqMap(0), cqMapSize(0), sqes(0), sqesSize(0), sqTail(0), sqMask(0), sqArray(0), cqHead(0), cqTail(0),
+    cqMask(0), cqes(0)
+{
+    memset(&sendMsg, 0, sizeof(sendMsg));
+    memset(&sendVec, 0, sizeof(sendVec));
+    memset(&recvTimeout, 0, sizeof(recvTimeout));
+}
+
+bool UringInternals::Open(int socketFD)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP;
+    RingFD = static_cast<int>(syscall(__NR_io_uring_setup, RING_SIZE, &params));
+    if (RingFD < 0) {
+        outStr << "Open: io_uring not available (" << strerror(errno) << "), using socket calls" << std::endl;
+        return false;
+    }
+
+    sqMapSize = params.sq_off.array + params.sq_entries*sizeof(uint32_t);
+    cqMapSize = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (cqMapSize > sqMapSize)
+            sqMapSize = cqMapSize;
+        cqMapSize = 0;    // shares sqMap
+    }
+    void *mem = mmap(0, sqMapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, RingFD, IORING_OFF_SQ_RING);
+    if (mem == MAP_FAILED) {
+        outStr << "Open: failed to map io_uring submission queue: " << strerror(errno) << std::endl;
+        sqMapSize = 0;
+        Close();
+        return false;
+    }
+    sqMap = static_cast<unsigned char *>(mem);
+    if (cqMapSize == 0) {
+        cqMap = sqMap;
+    }
+    else {
+        mem = mmap(0, cqMapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, RingFD, IORING_OFF_CQ_RING);
+        if (mem == MAP_FAILED) {
+            outStr << "Open: failed to map io_uring completion queue: " << strerror(errno) << std::endl;
+            cqMapSize = 0;
+            Close();
+            return false;
+        }
+        cqMap = static_cast<unsigned char *>(mem);
+    }
+    sqesSize = params.sq_entries*sizeof(struct io_uring_sqe);
+    mem = mmap(0, sqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, RingFD, IORING_OFF_SQES);
+    if (mem == MAP_FAILED) {
+        outStr << "Open: failed to map io_uring SQEs: " << strerror(errno) << std::endl;
+        sqesSize = 0;
+        Close();
+        return false;
+    }
+    sqes = static_cast<struct io_uring_sqe *>(mem);
+
+    sqTail = reinterpret_cast<uint32_t *>(sqMap+params.sq_off.tail);
+    sqMask = *reinterpret_cast<uint32_t *>(sqMap+params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<uint32_t *>(sqMap+params.sq_off.array);
+    cqHead = reinterpret_cast<uint32_t *>(cqMap+params.cq_off.head);
+    cqTail = reinterpret_cast<uint32_t *>(cqMap+params.cq_off.tail);
+    cqMask = *reinterpret_cast<uint32_t *>(cqMap+params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe *>(cqMap+params.cq_off.cqes);
+
+    // Register the socket, so that the kernel does not need to look it up for each operation
+    if (syscall(__NR_io_uring_register, RingFD, IORING_REGISTER_FILES, &socketFD, 1) != 0) {
+        outStr << "Open: failed to register socket with io_uring: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    sendMsg.msg_iov = &sendVec;
+    sendMsg.msg_iovlen = 1;
+    sendMsg.msg_namelen = sizeof(struct sockaddr_in);
+    return true;
+}
+
+void UringInternals::Close(void)
+{
+    if (sqes)
+        munmap(sqes, sqesSize);
+    if (cqMap && (cqMap != sqMap))
+        munmap(cqMap, cqMapSize);
+    if (sqMap)
+        munmap(sqMap, sqMapSize);
+    sqes = 0;
+    cqMap = 0;
+    sqMap = 0;
+    if (RingFD >= 0) {
+        close(RingFD);
+        RingFD = -1;
+    }
+}
+
+struct io_uring_sqe *UringInternals::NextSqe(uint8_t opcode, uint64_t tag, uint8_t flags)
+{
+    // Only one chain is submitted at a time, so the submission queue is never full
+    uint32_t tail = *sqTail;
+    uint32_t idx = tail&sqMask;
+    struct io_uring_sqe *sqe = &sqes[idx];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = opcode;
+    sqe->flags = flags|IOSQE_FIXED_FILE;
+    sqe->fd = 0;          // index of registered socket
+    sqe->user_data = tag;
+    sqArray[idx] = idx;
+    __atomic_store_n(sqTail, tail+1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+int UringInternals::SendRecv(const unsigned char *bufsend, size_t msglen, struct sockaddr_in *addr,
+                             unsigned char *bufrecv, size_t maxlen, double timeoutSec, bool busyPoll,
+                             bool &sendOK, unsigned long &numSpins)
+{
+    DiscardCompletions();
+    sendVec.iov_base = const_cast<unsigned char *>(bufsend);
+    sendVec.iov_len = msglen;
+    sendMsg.msg_name = addr;
+    struct io_uring_sqe *sqe = NextSqe(IORING_OP_SENDMSG, TAG_SEND, IOSQE_IO_LINK);
+    sqe->addr = reinterpret_cast<uint64_t>(&sendMsg);
+    sqe = NextSqe(IORING_OP_RECV, TAG_RECV, IOSQE_IO_LINK);
+    sqe->addr = reinterpret_cast<uint64_t>(bufrecv);
+    sqe->len = static_cast<uint32_t>(maxlen);
+    recvTimeout.tv_sec = static_cast<long long>(timeoutSec);
+    recvTimeout.tv_nsec = static_cast<long long>((timeoutSec-recvTimeout.tv_sec)*1.0e9);
+    sqe = NextSqe(IORING_OP_LINK_TIMEOUT, TAG_TIMEOUT, 0);
+    sqe->fd = -1;
+    sqe->flags = 0;
+    sqe->addr = reinterpret_cast<uint64_t>(&recvTimeout);
+    sqe->len = 1;
+
+    // Each of the 3 operations produces a completion: if the receive completes, the timeout is canceled;
+    // if the timeout expires, the receive is canceled; if the send fails, both are canceled.
+    unsigned int toSubmit = NUM_OPS;
+    unsigned int numDone = 0;
+    int nRecv = -1;
+    sendOK = false;
+    numSpins = 0;
+    while (numDone < NUM_OPS) {
+        uint32_t head = *cqHead;
+        uint32_t tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        numSpins++;
+        while (head != tail) {
+            const struct io_uring_cqe *cqe = &cqes[head&cqMask];
+            if (cqe->user_data == TAG_SEND) {
+                sendOK = (cqe->res == static_cast<int>(msglen));
+                if (cqe->res < 0)
+                    outStr << "SendRecv: failed to send: " << strerror(-cqe->res) << std::endl;
+            }
+            else if (cqe->user_data == TAG_RECV) {
+                if (cqe->res >= 0)
+                    nRecv = cqe->res;
+                else if (cqe->res == -ECANCELED)
+                    nRecv = 0;    // timeout (same as select) or send failed
+                else
+                    outStr << "SendRecv: failed to receive: " << strerror(-cqe->res) << std::endl;
+            }
+            head++;
+            numDone++;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        if ((numDone == NUM_OPS) || (busyPoll && (toSubmit == 0)))
+            continue;
+        // Submit (first time) and wait for the remaining completions (unless busy polling)
+        unsigned int minComplete = busyPoll ? 0 : NUM_OPS-numDone;
+        int ret = static_cast<int>(syscall(__NR_io_uring_enter, RingFD, toSubmit, minComplete,
+                                           busyPoll ? 0 : IORING_ENTER_GETEVENTS, 0, 0));
+        if (ret >= 0)
+            toSubmit -= std::min(toSubmit, static_cast<unsigned int>(ret));
+        else if (errno != EINTR) {
+            outStr << "SendRecv: io_uring_enter failed: " << strerror(errno) << std::endl;
+            Abort(toSubmit, numDone);
+            return -1;
+        }
+    }
+    return nRecv;
+}
+
+void UringInternals::Abort(unsigned int toSubmit, unsigned int numDone)
+{
+    if (toSubmit < NUM_OPS) {
+        // Cancel the receive (if still pending) and wait for all completions, including that of the
+        // cancel request. The receive is also limited by its linked timeout.
+        struct io_uring_sqe *sqe = NextSqe(IORING_OP_ASYNC_CANCEL, TAG_CANCEL, 0);
+        sqe->fd = -1;
+        sqe->flags = 0;
+        sqe->addr = TAG_RECV;
+        toSubmit++;
+        unsigned int numPending = NUM_OPS+1-numDone;
+        while (numPending > 0) {
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, RingFD, toSubmit, numPending,
+                                               IORING_ENTER_GETEVENTS, 0, 0));
+            if (ret >= 0)
+                toSubmit -= std::min(toSubmit, static_cast<unsigned int>(ret));
+            else if (errno != EINTR) {
+                outStr << "SendRecv: failed to cancel pending operations: " << strerror(errno) << std::endl;
+                break;
+            }
+            uint32_t head = *cqHead;
+            uint32_t tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            while ((head != tail) && (numPending > 0)) {
+                head++;
+                numPending--;
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+    }
+    // Operations that were not submitted are discarded with the ring
+    Close();
+}
+
+#endif // Amp1394_HAS_IO_URING
+
 struct SocketInternals {
     std::ostream &outStr;
 #ifdef _MSC_VER
@@ -87,6 +406,20 @@ struct SocketInternals {
 
     bool FirstRun;
 
+    bool BusyPoll;              // true to spin on a non-blocking receive (rather than select)
+    unsigned long SpinCount;    // number of receive attempts by last call to Recv or RecvBatch
+
+#if Amp1394_HAS_IO_URING
+    UringInternals *uringPtr;   // 0 if io_uring is not available
+#endif
+
+#ifdef __linux__
+    bool Timestamping;              // true if packet timestamps enabled
+    bool TimestampingHardware;      // true if hardware timestamps enabled
+    EthTimestamp TxStamp;           // transmit timestamp of last request sent by SendRecvTimed
+    EthTimestamp RxStamp;           // receive timestamp of last response received by SendRecvTimed
+#endif
+
     SocketInternals(std::ostream &ostr);
     ~SocketInternals();
 
@@ -99,6 +432,40 @@ struct SocketInternals {
     // Returns the number of bytes received (-1 on error)
     int Recv(unsigned char *bufrecv, size_t maxlen, const double timeoutSec);
 
+    // Send a packet and receive the response (using io_uring, if available). Returns the number
+    // of bytes received (-1 on receive error); sendOK is set false if the packet was not sent.
+    int SendRecv(const unsigned char *bufsend, size_t msglen, bool useBroadcast,
+                 unsigned char *bufrecv, size_t maxlen, const double timeoutSec, bool &sendOK);
+
+#ifdef __linux__
+    // Enable or disable packet timestamps (SO_TIMESTAMPING)
+    bool SetTimestamping(bool enable, bool hardware);
+
+    // Same as SendRecv, but also gets the transmit and receive timestamps (TxStamp and RxStamp)
+    int SendRecvTimed(const unsigned char *bufsend, size_t msglen, bool useBroadcast,
+                      unsigned char *bufrecv, size_t maxlen, const double timeoutSec, bool &sendOK);
+#endif
+
+    // Send multiple packets (using sendmmsg, if available).
+    // Returns the number of packets sent.
+    unsigned int SendBatch(const unsigned char * const *bufsend, const size_t *msglen, unsigned int num,
+                           bool useBroadcast = false);
+
+    // Receive up to num packets (using recvmmsg, if available), waiting at most timeoutSec in total.
+    // The number of bytes received for each packet is returned in nrecv.
+    // Returns the number of packets received.
+    unsigned int RecvBatch(unsigned char * const *bufrecv, const size_t *maxlen, int *nrecv, unsigned int num,
+                           const double timeoutSec);
+
+    // Wait until data is available to read (select with timeout).
+    // Returns 1 if data available, 0 if timeout, and SOCKET_ERROR on error.
+    int WaitRecv(const double timeoutSec);
+
+    // Enable or disable busy polling. If busyPollUsec is non-zero, also sets the
+    // SO_BUSY_POLL and SO_PREFER_BUSY_POLL socket options (Linux only). Returns false, without
+    // changing the receive mode, if the options cannot be set.
+    bool SetBusyPoll(bool enable, unsigned int busyPollUsec);
+
     // Flush the receive buffer
     int FlushRecv(void);
 
@@ -107,8 +474,16 @@ struct SocketInternals {
 };
 
 SocketInternals::SocketInternals(std::ostream &ostr) : outStr(ostr), SocketFD(INVALID_SOCKET),
-                 InterfaceIndex(0), InterfaceName("undefined"), InterfaceMTU(ETH_MTU_DEFAULT), FirstRun(true)
+                 InterfaceIndex(0), InterfaceName("undefined"), InterfaceMTU(ETH_MTU_DEFAULT), FirstRun(true),
+                 BusyPoll(false), SpinCount(0)
 {
+#if Amp1394_HAS_IO_URING
+    uringPtr = 0;
+#endif
+#ifdef __linux__
+    Timestamping = false;
+    TimestampingHardware = false;
+#endif
     memset(&ServerAddr, 0, sizeof(ServerAddr));
     memset(&ServerAddrBroadcast, 0, sizeof(ServerAddrBroadcast));
 }
@@ -187,11 +562,23 @@ bool SocketInternals::Open(const std::string &host, unsigned short port)
     outStr << "Server IP: " << host << ", Port: " << std::dec << port << std::endl;
     outStr << "Broadcast IP: " << EthUdpPort::IP_String(ServerAddrBroadcast.sin_addr.s_addr)
            << ", Port: " << std::dec << port << std::endl;
+#if Amp1394_HAS_IO_URING
+    // If io_uring is not available (e.g., disabled by the system), the socket calls are used
+    uringPtr = new UringInternals(outStr);
+    if (!uringPtr->Open(SocketFD)) {
+        delete uringPtr;
+        uringPtr = 0;
+    }
+#endif
     return true;
 }
 
 bool SocketInternals::Close()
 {
+#if Amp1394_HAS_IO_URING
+    delete uringPtr;
+    uringPtr = 0;
+#endif
     if (SocketFD != INVALID_SOCKET) {
 #ifdef _MSC_VER
         if (closesocket(SocketFD) != 0) {
@@ -234,7 +621,7 @@ int SocketInternals::Send(const unsigned char *bufsend, size_t msglen, bool useB
     return retval;
 }
 
-int SocketInternals::Recv(unsigned char *bufrecv, size_t maxlen, const double timeoutSec)
+int SocketInternals::WaitRecv(const double timeoutSec)
 {
     fd_set readfds;
     FD_ZERO(&readfds);
@@ -261,7 +648,70 @@ int SocketInternals::Recv(unsigned char *bufrecv, size_t maxlen, const double ti
         outStr << "Recv: select failed: " << strerror(errno) << std::endl;
 #endif
     }
-    else if (retval > 0) {
+    return retval;
+}
+
+bool SocketInternals::SetBusyPoll(bool enable, unsigned int busyPollUsec)
+{
+    // On failure, the receive mode (BusyPoll) and socket options are not changed
+#ifdef _MSC_VER
+    u_long nonBlocking = enable ? 1 : 0;
+    if (ioctlsocket(SocketFD, FIONBIO, &nonBlocking) != 0) {
+        outStr << "SetBusyPoll: failed to set non-blocking mode: " << WSAGetLastError() << std::endl;
+        return false;
+    }
+    if (busyPollUsec != 0)
+        outStr << "SetBusyPoll: SO_BUSY_POLL not supported on this platform" << std::endl;
+#elif defined(__linux__)
+    int busyPoll = enable ? static_cast<int>(busyPollUsec) : 0;
+    int preferBusyPoll = (busyPoll != 0) ? 1 : 0;
+    if ((busyPoll != 0) || BusyPoll) {
+        if (setsockopt(SocketFD, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll)) != 0) {
+            outStr << "SetBusyPoll: failed to set SO_BUSY_POLL: " << strerror(errno) << std::endl;
+            return false;
+        }
+        // SO_PREFER_BUSY_POLL is only available with Linux 5.11+, so failure is not an error
+        if (setsockopt(SocketFD, SOL_SOCKET, SO_PREFER_BUSY_POLL, &preferBusyPoll, sizeof(preferBusyPoll)) != 0)
+            outStr << "SetBusyPoll: SO_PREFER_BUSY_POLL not supported: " << strerror(errno) << std::endl;
+    }
+#else
+    if (busyPollUsec != 0)
+        outStr << "SetBusyPoll: SO_BUSY_POLL not supported on this platform" << std::endl;
+#endif
+    BusyPoll = enable;
+    return true;
+}
+
+int SocketInternals::Recv(unsigned char *bufrecv, size_t maxlen, const double timeoutSec)
+{
+    SpinCount = 1;
+    if (BusyPoll && !FirstRun) {
+        // Spin on non-blocking receive until packet available or deadline reached
+        double deadline = Amp1394_GetTime() + timeoutSec;
+        int retval;
+        for (;;) {
+            retval = recv(SocketFD, reinterpret_cast<char *>(bufrecv), maxlen, RECV_DONTWAIT);
+            if (retval != SOCKET_ERROR)
+                break;
+            if (!SocketWouldBlock()) {
+#ifdef _MSC_VER
+                outStr << "Recv: failed to receive: " << WSAGetLastError() << std::endl;
+#else
+                outStr << "Recv: failed to receive: " << strerror(errno) << std::endl;
+#endif
+                break;
+            }
+            if (Amp1394_GetTime() > deadline) {
+                retval = 0;    // timeout (same as select)
+                break;
+            }
+            SpinCount++;
+        }
+        return retval;
+    }
+
+    int retval = WaitRecv(timeoutSec);
+    if (retval > 0) {
 
         if (FirstRun) {
 
@@ -340,6 +790,223 @@ int SocketInternals::Recv(unsigned char *bufrecv, size_t maxlen, const double ti
     return retval;
 }
 
+int SocketInternals::SendRecv(const unsigned char *bufsend, size_t msglen, bool useBroadcast,
+                              unsigned char *bufrecv, size_t maxlen, const double timeoutSec, bool &sendOK)
+{
+#ifdef __linux__
+    if (Timestamping && !FirstRun)
+        return SendRecvTimed(bufsend, msglen, useBroadcast, bufrecv, maxlen, timeoutSec, sendOK);
+#endif
+#if Amp1394_HAS_IO_URING
+    // The first receive extracts the interface information (see Recv)
+    if (uringPtr && !FirstRun) {
+        int nRecv = uringPtr->SendRecv(bufsend, msglen, useBroadcast ? &ServerAddrBroadcast : &ServerAddr,
+                                       bufrecv, maxlen, timeoutSec, BusyPoll, sendOK, SpinCount);
+        if (!uringPtr->IsOpen()) {
+            outStr << "SendRecv: io_uring closed, using socket calls" << std::endl;
+            delete uringPtr;
+            uringPtr = 0;
+        }
+        return nRecv;
+    }
+#endif
+    sendOK = (Send(bufsend, msglen, useBroadcast) == static_cast<int>(msglen));
+    if (!sendOK)
+        return -1;
+    return Recv(bufrecv, maxlen, timeoutSec);
+}
+
+#ifdef __linux__
+bool SocketInternals::SetTimestamping(bool enable, bool hardware)
+{
+    // The interface name (needed for hardware timestamps) is obtained from the first received packet
+    if (enable && hardware && FirstRun) {
+        outStr << "SetTimestamping: interface not yet known, using software timestamps" << std::endl;
+        hardware = false;
+    }
+    bool hwEnabled;
+    if (!EthTimestampEnable(SocketFD, enable, InterfaceName, hardware, hwEnabled, outStr))
+        return false;
+    Timestamping = enable;
+    TimestampingHardware = hwEnabled;
+    return true;
+}
+
+int SocketInternals::SendRecvTimed(const unsigned char *bufsend, size_t msglen, bool useBroadcast,
+                                   unsigned char *bufrecv, size_t maxlen, const double timeoutSec, bool &sendOK)
+{
+    char control[ETH_TIMESTAMP_CONTROL_SIZE];
+    struct iovec vec;
+    struct msghdr msg;
+
+    // Discard any old transmit timestamps
+    EthTimestampReadTx(SocketFD, TxStamp);
+    TxStamp.Clear();
+    RxStamp.Clear();
+
+    vec.iov_base = const_cast<unsigned char *>(bufsend);
+    vec.iov_len = msglen;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = useBroadcast ? &ServerAddrBroadcast : &ServerAddr;
+    msg.msg_namelen = sizeof(ServerAddr);
+    msg.msg_iov = &vec;
+    msg.msg_iovlen = 1;
+    EthTimestampRequestTx(&msg, control, TimestampingHardware);
+    int retval = sendmsg(SocketFD, &msg, 0);
+    sendOK = (retval == static_cast<int>(msglen));
+    if (!sendOK) {
+        outStr << "SendRecvTimed: failed to send: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    // The transmit timestamp in the error queue also wakes up select, so the socket is read
+    // without blocking until the response arrives or the deadline is reached.
+    double deadline = Amp1394_GetTime() + timeoutSec;
+    SpinCount = 0;
+    for (;;) {
+        SpinCount++;
+        vec.iov_base = bufrecv;
+        vec.iov_len = maxlen;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &vec;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        retval = recvmsg(SocketFD, &msg, MSG_DONTWAIT);
+        if (retval >= 0) {
+            EthTimestampParse(&msg, RxStamp);
+            break;
+        }
+        if (!SocketWouldBlock()) {
+            outStr << "SendRecvTimed: failed to receive: " << strerror(errno) << std::endl;
+            break;
+        }
+        EthTimestampReadTx(SocketFD, TxStamp);
+        double remaining = deadline - Amp1394_GetTime();
+        if (remaining <= 0.0) {
+            retval = 0;    // timeout (same as select)
+            break;
+        }
+        if (!BusyPoll && (WaitRecv(remaining) == SOCKET_ERROR)) {
+            retval = -1;
+            break;
+        }
+    }
+    // Transmit timestamps not yet read
+    EthTimestampReadTx(SocketFD, TxStamp);
+    return retval;
+}
+#endif
+
+unsigned int SocketInternals::SendBatch(const unsigned char * const *bufsend, const size_t *msglen, unsigned int num,
+                                        bool useBroadcast)
+{
+    unsigned int numSent = 0;
+#ifdef __linux__
+    struct sockaddr_in *addr = useBroadcast ? &ServerAddrBroadcast : &ServerAddr;
+    struct mmsghdr msgs[BoardIO::MAX_BOARDS];
+    struct iovec vecs[BoardIO::MAX_BOARDS];
+    while (numSent < num) {
+        unsigned int numBatch = std::min(num-numSent, static_cast<unsigned int>(BoardIO::MAX_BOARDS));
+        memset(msgs, 0, numBatch*sizeof(struct mmsghdr));
+        for (unsigned int i = 0; i < numBatch; i++) {
+            vecs[i].iov_base = const_cast<unsigned char *>(bufsend[numSent+i]);
+            vecs[i].iov_len = msglen[numSent+i];
+            msgs[i].msg_hdr.msg_name = addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            msgs[i].msg_hdr.msg_iov = &vecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int retval = sendmmsg(SocketFD, msgs, numBatch, 0);
+        if (retval == SOCKET_ERROR) {
+            outStr << "SendBatch: failed to send: " << strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < retval; i++) {
+            if (msgs[i].msg_len != msglen[numSent+i])
+                outStr << "SendBatch: failed to send the whole message" << std::endl;
+        }
+        numSent += retval;
+        if (retval == 0)
+            break;
+    }
+#else
+    // No sendmmsg, so send packets individually
+    for (numSent = 0; numSent < num; numSent++) {
+        if (Send(bufsend[numSent], msglen[numSent], useBroadcast) != static_cast<int>(msglen[numSent]))
+            break;
+    }
+#endif
+    return numSent;
+}
+
+unsigned int SocketInternals::RecvBatch(unsigned char * const *bufrecv, const size_t *maxlen, int *nrecv, unsigned int num,
+                                        const double timeoutSec)
+{
+    unsigned int numRecv = 0;
+    unsigned long numSpins = 0;
+    // The first receive extracts the interface information (see Recv)
+    if (FirstRun && (num > 0)) {
+        nrecv[0] = Recv(bufrecv[0], maxlen[0], timeoutSec);
+        if (nrecv[0] <= 0)
+            return 0;
+        numRecv++;
+    }
+    double deadline = Amp1394_GetTime() + timeoutSec;
+#ifdef __linux__
+    struct mmsghdr msgs[BoardIO::MAX_BOARDS];
+    struct iovec vecs[BoardIO::MAX_BOARDS];
+#endif
+    while (numRecv < num) {
+        double timeLeft = deadline - Amp1394_GetTime();
+        if (BusyPoll) {
+            // In busy-poll mode, the non-blocking receive below is the wait
+            if (timeLeft < 0.0)
+                break;
+        }
+        else if (WaitRecv((timeLeft > 0.0) ? timeLeft : 0.0) <= 0) {
+            break;
+        }
+        numSpins++;
+#ifdef __linux__
+        // Get all packets that are already available
+        unsigned int numBatch = std::min(num-numRecv, static_cast<unsigned int>(BoardIO::MAX_BOARDS));
+        memset(msgs, 0, numBatch*sizeof(struct mmsghdr));
+        for (unsigned int i = 0; i < numBatch; i++) {
+            vecs[i].iov_base = bufrecv[numRecv+i];
+            vecs[i].iov_len = maxlen[numRecv+i];
+            msgs[i].msg_hdr.msg_iov = &vecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int retval = recvmmsg(SocketFD, msgs, numBatch, MSG_DONTWAIT, 0);
+        if (retval == SOCKET_ERROR) {
+            if (SocketWouldBlock())
+                continue;
+            outStr << "RecvBatch: failed to receive: " << strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < retval; i++)
+            nrecv[numRecv+i] = static_cast<int>(msgs[i].msg_len);
+        numRecv += retval;
+#else
+        nrecv[numRecv] = recv(SocketFD, reinterpret_cast<char *>(bufrecv[numRecv]), maxlen[numRecv], RECV_DONTWAIT);
+        if (nrecv[numRecv] == SOCKET_ERROR) {
+            if (SocketWouldBlock())
+                continue;
+#ifdef _MSC_VER
+            outStr << "RecvBatch: failed to receive: " << WSAGetLastError() << std::endl;
+#else
+            outStr << "RecvBatch: failed to receive: " << strerror(errno) << std::endl;
+#endif
+            break;
+        }
+        numRecv++;
+#endif
+    }
+    SpinCount = numSpins;
+    return numRecv;
+}
+
 int SocketInternals::FlushRecv(void)
 {
     unsigned char buffer[FW_QRESPONSE_SIZE];
@@ -563,9 +1230,26 @@ bool EthUdpPort::PacketSend(unsigned char *packet, size_t nbytes, bool useEthern
     return true;
 }
 
+bool EthUdpPort::SetReceiveMode(ReceiveModeType mode, unsigned int busyPollUsec)
+{
+    if ((mode != RECV_WAIT) && (mode != RECV_BUSY_POLL)) {
+        outStr << "SetReceiveMode: invalid receive mode: " << mode << std::endl;
+        return false;
+    }
+    bool busyPoll = (mode == RECV_BUSY_POLL);
+    if (!busyPoll)
+        busyPollUsec = 0;
+    if (!sockPtr->SetBusyPoll(busyPoll, busyPollUsec))
+        return false;
+    ReceiveMode = mode;
+    BusyPollUsec = busyPollUsec;
+    return true;
+}
+
 int EthUdpPort::PacketReceive(unsigned char *packet, size_t nbytes)
 {
     int nRecv = sockPtr->Recv(packet, nbytes, ReceiveTimeout);
+    UpdateSpinCount(sockPtr->SpinCount);
     if (nRecv == static_cast<int>(FW_EXTRA_SIZE)) {
         outStr << "PacketReceive: only extra data" << std::endl;
         ProcessExtraData(packet);
@@ -574,6 +1258,92 @@ int EthUdpPort::PacketReceive(unsigned char *packet, size_t nbytes)
     return nRecv;
 }
 
+int EthUdpPort::PacketSendReceive(unsigned char *sendPacket, size_t sendBytes, bool useEthernetBroadcast,
+                                  unsigned char *recvPacket, size_t recvBytes)
+{
+    bool sendOK;
+#ifdef __linux__
+    double sendTime = Timestamping ? EthTimestampNow() : 0.0;
+#endif
+    int nRecv = sockPtr->SendRecv(sendPacket, sendBytes, useEthernetBroadcast, recvPacket, recvBytes,
+                                  ReceiveTimeout, sendOK);
+#ifdef __linux__
+    double recvTime = Timestamping ? EthTimestampNow() : 0.0;
+#endif
+    if (!sendOK) {
+        outStr << "PacketSendReceive: failed to send via UDP" << std::endl;
+        return -1;
+    }
+    UpdateSpinCount(sockPtr->SpinCount);
+    if (nRecv == static_cast<int>(FW_EXTRA_SIZE)) {
+        outStr << "PacketSendReceive: only extra data" << std::endl;
+        ProcessExtraData(recvPacket);
+        nRecv = 0;
+    }
+#ifdef __linux__
+    if (Timestamping && (nRecv > 0))
+        SetTransactionTiming(sendTime, sockPtr->TxStamp, sockPtr->RxStamp, recvTime);
+#endif
+    return nRecv;
+}
+
+bool EthUdpPort::SetTimestamping(bool enable, bool hardware)
+{
+#ifdef __linux__
+    if (!sockPtr->SetTimestamping(enable, hardware))
+        return false;
+    Timestamping = enable;
+    TimestampingHardware = sockPtr->TimestampingHardware;
+    LastTiming = TransactionTiming();
+    LastTimingPending = false;
+    return true;
+#else
+    return EthBasePort::SetTimestamping(enable, hardware);
+#endif
+}
+
+unsigned int EthUdpPort::PacketSendBatch(unsigned char * const *packets, const size_t *nbytes,
+                                         unsigned int num, bool useEthernetBroadcast)
+{
+    unsigned int numSent = sockPtr->SendBatch(packets, nbytes, num, useEthernetBroadcast);
+    if (numSent != num) {
+        outStr << "PacketSendBatch: failed to send via UDP: sent " << numSent
+               << " of " << num << " packets" << std::endl;
+    }
+    return numSent;
+}
+
+unsigned int EthUdpPort::PacketReceiveBatch(unsigned char * const *packets, const size_t *nbytes,
+                                            int *nRecv, unsigned int num)
+{
+    unsigned int numRecv = 0;
+    while (numRecv < num) {
+        unsigned int numNew = sockPtr->RecvBatch(packets+numRecv, nbytes+numRecv, nRecv+numRecv,
+                                                 num-numRecv, ReceiveTimeout);
+        UpdateSpinCount(sockPtr->SpinCount);
+        if (numNew == 0)
+            break;
+        // Remove any packets that only contain extra data (see PacketReceive)
+        unsigned int last = numRecv+numNew;
+        for (unsigned int i = numRecv; i < last; ) {
+            if (nRecv[i] == static_cast<int>(FW_EXTRA_SIZE)) {
+                outStr << "PacketReceiveBatch: only extra data" << std::endl;
+                ProcessExtraData(packets[i]);
+                for (unsigned int j = i+1; j < last; j++) {
+                    memcpy(packets[j-1], packets[j], std::min(static_cast<size_t>(nRecv[j]), nbytes[j-1]));
+                    nRecv[j-1] = nRecv[j];
+                }
+                last--;
+            }
+            else {
+                i++;
+            }
+        }
+        numRecv = last;
+    }
+    return numRecv;
+}
+
 int EthUdpPort::PacketFlushAll(void)
 {
     return sockPtr->FlushRecv();
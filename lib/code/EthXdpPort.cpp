@@ -0,0 +1,632 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include "EthXdpPort.h"
+#include "Amp1394Time.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <net/if.h>
+#include <linux/if_xdp.h>
+#include <linux/if_link.h>
+#include <linux/bpf.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+
+// Older C libraries do not define these
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+// Single-producer/single-consumer ring shared with the kernel. For the fill and transmit rings, the
+// application is the producer; for the receive and completion rings, the application is the consumer.
+struct XdpRing {
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void *desc;
+    uint32_t mask;
+    uint32_t prod;         // local copy of producer index (producer rings)
+    uint32_t cons;         // local copy of consumer index (consumer rings)
+    void *map;
+    size_t mapSize;
+
+    XdpRing() : producer(0), consumer(0), flags(0), desc(0), mask(0), prod(0), cons(0), map(0), mapSize(0) {}
+
+    uint64_t *Addr(uint32_t idx) const { return static_cast<uint64_t *>(desc)+(idx&mask); }
+    struct xdp_desc *Desc(uint32_t idx) const { return static_cast<struct xdp_desc *>(desc)+(idx&mask); }
+
+    // Number of entries that can be consumed (consumer rings)
+    uint32_t Available(void) const { return __atomic_load_n(producer, __ATOMIC_ACQUIRE) - cons; }
+    // Publish the consumed entries (consumer rings)
+    void Consume(void) { __atomic_store_n(consumer, cons, __ATOMIC_RELEASE); }
+    // Publish the produced entries (producer rings)
+    void Produce(void) { __atomic_store_n(producer, prod, __ATOMIC_RELEASE); }
+
+    bool NeedWakeup(void) const { return (__atomic_load_n(flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP); }
+};
+
+// AF_XDP socket with its UMEM (frame buffers), rings and XDP program. The first half of the
+// UMEM frames is used for receiving (these frames are always owned by the fill or receive ring,
+// except while a received frame is processed), and the second half for transmitting.
+struct XdpSocket {
+    std::ostream &outStr;
+    int fd;
+    int mapFd;                  // XSKMAP (queue id to socket)
+    int progFd;                 // XDP program
+    int linkFd;                 // Attachment of XDP program to interface
+    unsigned char *umem;
+    XdpRing fill, comp, rx, tx;
+    uint64_t txFree[256];       // TX frames that are not in use
+    unsigned int numTxFree;
+    bool BusyPoll;              // true to spin on the ring (rather than poll)
+    unsigned long SpinCount;    // number of times the ring was checked by last call to Receive
+
+    enum { FRAME_SIZE = 2048, NUM_FRAMES = 512, RX_FRAMES = 256, RING_SIZE = 256 };
+
+    XdpSocket(std::ostream &ostr) : outStr(ostr), fd(-1), mapFd(-1), progFd(-1), linkFd(-1), umem(0),
+                                    numTxFree(0), BusyPoll(false), SpinCount(0) {}
+    ~XdpSocket() { Close(); }
+
+    // Open socket on the specified interface and queue; returns local MAC address
+    bool Open(const std::string &ifName, unsigned int queueId, uint8_t *localMac);
+    void Close(void);
+
+    bool IsZeroCopy(void) const;
+
+    // Returns the next received frame (0 if none available); Release must be called when done.
+    const struct xdp_desc *Next(void)
+    {
+        return (rx.Available() > 0) ? rx.Desc(rx.cons) : 0;
+    }
+    // Return the frame to the fill ring
+    void Release(const struct xdp_desc *desc)
+    {
+        *fill.Addr(fill.prod++) = desc->addr & ~static_cast<uint64_t>(FRAME_SIZE-1);
+        fill.Produce();
+        rx.cons++;
+        rx.Consume();
+    }
+
+    // Wait for the next frame, up to timeoutSec; returns 0 if timeout
+    const struct xdp_desc *Receive(double timeoutSec);
+
+    // Copy the packets to TX frames and send them; returns number of packets sent
+    unsigned int Send(unsigned char * const *packets, const size_t *nbytes, unsigned int num);
+
+    // Return completed TX frames to txFree
+    void ReapCompletions(void);
+
+protected:
+    bool MapRing(XdpRing &ring, const struct xdp_ring_offset &off, uint64_t pgoff, size_t descSize);
+    bool AttachProgram(unsigned int ifIndex, const uint8_t *localMac, bool &skbMode);
+};
+
+static long BpfCall(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static struct bpf_insn BpfInsn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm)
+{
+    struct bpf_insn insn;
+    insn.code = code;
+    insn.dst_reg = dst;
+    insn.src_reg = src;
+    insn.off = off;
+    insn.imm = imm;
+    return insn;
+}
+
+bool XdpSocket::MapRing(XdpRing &ring, const struct xdp_ring_offset &off, uint64_t pgoff, size_t descSize)
+{
+    ring.mapSize = off.desc + RING_SIZE*descSize;
+    void *mem = mmap(0, ring.mapSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, pgoff);
+    if (mem == MAP_FAILED) {
+        outStr << "ERROR: could not map AF_XDP ring: " << strerror(errno) << std::endl;
+        ring.mapSize = 0;
+        return false;
+    }
+    unsigned char *base = static_cast<unsigned char *>(mem);
+    ring.map = mem;
+    ring.producer = reinterpret_cast<uint32_t *>(base+off.producer);
+    ring.consumer = reinterpret_cast<uint32_t *>(base+off.consumer);
+    ring.flags = reinterpret_cast<uint32_t *>(base+off.flags);
+    ring.desc = base+off.desc;
+    ring.mask = RING_SIZE-1;
+    ring.prod = *ring.producer;
+    ring.cons = *ring.consumer;
+    return true;
+}
+
+// Load an XDP program that redirects the frames sent by an FPGA board to this PC (destination is
+// local MAC address, source is FA:61:0E:13:94:xx) to the socket in the XSKMAP entry for the receive
+// queue, and passes all other frames to the network stack. The program is attached to the interface
+// using a BPF link, so that it is detached when the link is closed (or the process exits).
+bool XdpSocket::AttachProgram(unsigned int ifIndex, const uint8_t *localMac, bool &skbMode)
+{
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = 64;
+    mapFd = static_cast<int>(BpfCall(BPF_MAP_CREATE, &attr));
+    if (mapFd < 0) {
+        outStr << "ERROR: could not create XSKMAP: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // eBPF loads are in host byte order, so the addresses are compared in host byte order
+    uint8_t fpgaMac[6];
+    EthBasePort::GetDestMacAddr(fpgaMac);
+    uint32_t localMac0, fpgaMac0;
+    uint16_t localMac4;
+    memcpy(&localMac0, localMac, sizeof(localMac0));
+    memcpy(&localMac4, localMac+4, sizeof(localMac4));
+    memcpy(&fpgaMac0, fpgaMac, sizeof(fpgaMac0));
+
+    // Jump offsets are relative to the next instruction; all jumps are to "pass" (instruction 20)
+    struct bpf_insn prog[] = {
+        BpfInsn(BPF_ALU64|BPF_MOV|BPF_X, BPF_REG_6, BPF_REG_1, 0, 0),                          // r6 = ctx
+        BpfInsn(BPF_LDX|BPF_MEM|BPF_W, BPF_REG_2, BPF_REG_1, offsetof(struct xdp_md, data), 0),
+        BpfInsn(BPF_LDX|BPF_MEM|BPF_W, BPF_REG_3, BPF_REG_1, offsetof(struct xdp_md, data_end), 0),
+        BpfInsn(BPF_ALU64|BPF_MOV|BPF_X, BPF_REG_4, BPF_REG_2, 0, 0),
+        BpfInsn(BPF_ALU64|BPF_ADD|BPF_K, BPF_REG_4, 0, 0, 14),
+        BpfInsn(BPF_JMP|BPF_JGT|BPF_X, BPF_REG_4, BPF_REG_3, 14, 0),                           // frame too short
+        BpfInsn(BPF_LDX|BPF_MEM|BPF_W, BPF_REG_5, BPF_REG_2, 0, 0),
+        BpfInsn(BPF_JMP32|BPF_JNE|BPF_K, BPF_REG_5, 0, 12, static_cast<int32_t>(localMac0)),
+        BpfInsn(BPF_LDX|BPF_MEM|BPF_H, BPF_REG_5, BPF_REG_2, 4, 0),
+        BpfInsn(BPF_JMP32|BPF_JNE|BPF_K, BPF_REG_5, 0, 10, localMac4),
+        BpfInsn(BPF_LDX|BPF_MEM|BPF_W, BPF_REG_5, BPF_REG_2, 6, 0),
+        BpfInsn(BPF_JMP32|BPF_JNE|BPF_K, BPF_REG_5, 0, 8, static_cast<int32_t>(fpgaMac0)),
+        BpfInsn(BPF_LDX|BPF_MEM|BPF_B, BPF_REG_5, BPF_REG_2, 10, 0),
+        BpfInsn(BPF_JMP32|BPF_JNE|BPF_K, BPF_REG_5, 0, 6, fpgaMac[4]),
+        BpfInsn(BPF_LD|BPF_DW|BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, mapFd),               // r1 = map
+        BpfInsn(0, 0, 0, 0, 0),
+        BpfInsn(BPF_LDX|BPF_MEM|BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, rx_queue_index), 0),
+        BpfInsn(BPF_ALU64|BPF_MOV|BPF_K, BPF_REG_3, 0, 0, XDP_PASS),                           // if no socket
+        BpfInsn(BPF_JMP|BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+        BpfInsn(BPF_JMP|BPF_EXIT, 0, 0, 0, 0),
+        BpfInsn(BPF_ALU64|BPF_MOV|BPF_K, BPF_REG_0, 0, 0, XDP_PASS),                           // pass:
+        BpfInsn(BPF_JMP|BPF_EXIT, 0, 0, 0, 0)
+    };
+    static const char license[] = "Dual BSD/GPL";
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insn_cnt = sizeof(prog)/sizeof(prog[0]);
+    attr.insns = reinterpret_cast<uint64_t>(prog);
+    attr.license = reinterpret_cast<uint64_t>(license);
+    progFd = static_cast<int>(BpfCall(BPF_PROG_LOAD, &attr));
+    if (progFd < 0) {
+        outStr << "ERROR: could not load XDP program: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Try native (driver) mode first, then generic (skb) mode
+    skbMode = false;
+    for (int i = 0; i < 2; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.link_create.prog_fd = progFd;
+        attr.link_create.target_ifindex = ifIndex;
+        attr.link_create.attach_type = BPF_XDP;
+        attr.link_create.flags = skbMode ? XDP_FLAGS_SKB_MODE : XDP_FLAGS_DRV_MODE;
+        linkFd = static_cast<int>(BpfCall(BPF_LINK_CREATE, &attr));
+        if ((linkFd >= 0) || (errno == EBUSY))
+            break;
+        skbMode = true;
+    }
+    if (linkFd < 0) {
+        outStr << "ERROR: could not attach XDP program: " << strerror(errno);
+        if (errno == EBUSY)
+            outStr << " -- another XDP program is attached to the interface";
+        outStr << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool XdpSocket::Open(const std::string &ifName, unsigned int queueId, uint8_t *localMac)
+{
+    unsigned int ifIndex = if_nametoindex(ifName.c_str());
+    if (ifIndex == 0) {
+        outStr << "ERROR: network interface " << ifName << " does not exist" << std::endl;
+        return false;
+    }
+    if (queueId >= 64) {
+        outStr << "ERROR: invalid queue id " << queueId << std::endl;
+        return false;
+    }
+
+    fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (fd < 0) {
+        outStr << "ERROR: could not create AF_XDP socket: " << strerror(errno)
+               << " -- perhaps need root privileges?" << std::endl;
+        return false;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifName.c_str(), IFNAMSIZ-1);
+    if (ioctl(fd, SIOCGIFHWADDR, &ifr) != 0) {
+        // AF_XDP sockets may not support this ioctl, so use a datagram socket
+        int tmpFd = socket(AF_INET, SOCK_DGRAM, 0);
+        bool ok = (tmpFd >= 0) && (ioctl(tmpFd, SIOCGIFHWADDR, &ifr) == 0);
+        if (tmpFd >= 0)
+            close(tmpFd);
+        if (!ok) {
+            outStr << "ERROR: could not get local MAC address for " << ifName << std::endl;
+            Close();
+            return false;
+        }
+    }
+    memcpy(localMac, ifr.ifr_hwaddr.sa_data, 6);
+
+    // Register the UMEM
+    void *mem = mmap(0, NUM_FRAMES*FRAME_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE, -1, 0);
+    if (mem == MAP_FAILED) {
+        outStr << "ERROR: could not allocate UMEM: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    umem = static_cast<unsigned char *>(mem);
+    struct xdp_umem_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.addr = reinterpret_cast<uint64_t>(umem);
+    reg.len = NUM_FRAMES*FRAME_SIZE;
+    reg.chunk_size = FRAME_SIZE;
+    reg.headroom = 0;
+    if (setsockopt(fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) != 0) {
+        outStr << "ERROR: could not register UMEM: " << strerror(errno)
+               << " -- perhaps need to increase RLIMIT_MEMLOCK?" << std::endl;
+        Close();
+        return false;
+    }
+
+    // Create and map the rings
+    int ringSize = RING_SIZE;
+    if ((setsockopt(fd, SOL_XDP, XDP_UMEM_FILL_RING, &ringSize, sizeof(ringSize)) != 0) ||
+        (setsockopt(fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ringSize, sizeof(ringSize)) != 0) ||
+        (setsockopt(fd, SOL_XDP, XDP_RX_RING, &ringSize, sizeof(ringSize)) != 0) ||
+        (setsockopt(fd, SOL_XDP, XDP_TX_RING, &ringSize, sizeof(ringSize)) != 0)) {
+        outStr << "ERROR: could not create AF_XDP rings: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    struct xdp_mmap_offsets off;
+    socklen_t optlen = sizeof(off);
+    if (getsockopt(fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) != 0) {
+        outStr << "ERROR: could not get AF_XDP ring offsets: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    if (!MapRing(fill, off.fr, XDP_UMEM_PGOFF_FILL_RING, sizeof(uint64_t)) ||
+        !MapRing(comp, off.cr, XDP_UMEM_PGOFF_COMPLETION_RING, sizeof(uint64_t)) ||
+        !MapRing(rx, off.rx, XDP_PGOFF_RX_RING, sizeof(struct xdp_desc)) ||
+        !MapRing(tx, off.tx, XDP_PGOFF_TX_RING, sizeof(struct xdp_desc))) {
+        Close();
+        return false;
+    }
+
+    // Give all receive frames to the kernel; the other frames are available for transmit
+    unsigned int i;
+    for (i = 0; i < RX_FRAMES; i++)
+        *fill.Addr(fill.prod++) = static_cast<uint64_t>(i)*FRAME_SIZE;
+    fill.Produce();
+    for (numTxFree = 0; i < NUM_FRAMES; i++)
+        txFree[numTxFree++] = static_cast<uint64_t>(i)*FRAME_SIZE;
+
+    bool skbMode;
+    if (!AttachProgram(ifIndex, localMac, skbMode)) {
+        Close();
+        return false;
+    }
+
+    // Zero-copy mode is used if supported by the driver, unless the XDP program is in generic mode
+    struct sockaddr_xdp addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sxdp_family = AF_XDP;
+    addr.sxdp_flags = XDP_USE_NEED_WAKEUP | (skbMode ? XDP_COPY : 0);
+    addr.sxdp_ifindex = ifIndex;
+    addr.sxdp_queue_id = queueId;
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        outStr << "ERROR: could not bind AF_XDP socket to " << ifName << " queue " << queueId
+               << ": " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    uint32_t key = queueId;
+    uint32_t value = static_cast<uint32_t>(fd);
+    attr.map_fd = mapFd;
+    attr.key = reinterpret_cast<uint64_t>(&key);
+    attr.value = reinterpret_cast<uint64_t>(&value);
+    attr.flags = BPF_ANY;
+    if (BpfCall(BPF_MAP_UPDATE_ELEM, &attr) != 0) {
+        outStr << "ERROR: could not add AF_XDP socket to XSKMAP: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+
+    outStr << "Opened " << ifName << " queue " << queueId << " (AF_XDP, "
+           << (IsZeroCopy() ? "zero-copy" : "copy") << " mode, "
+           << (skbMode ? "generic" : "native") << " XDP)" << std::endl;
+    return true;
+}
+
+void XdpSocket::Close(void)
+{
+    // Closing the link detaches the XDP program
+    if (linkFd >= 0) {
+        close(linkFd);
+        linkFd = -1;
+    }
+    if (progFd >= 0) {
+        close(progFd);
+        progFd = -1;
+    }
+    if (mapFd >= 0) {
+        close(mapFd);
+        mapFd = -1;
+    }
+    XdpRing *rings[4] = { &fill, &comp, &rx, &tx };
+    for (unsigned int i = 0; i < 4; i++) {
+        if (rings[i]->map)
+            munmap(rings[i]->map, rings[i]->mapSize);
+        *rings[i] = XdpRing();
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    if (umem) {
+        munmap(umem, NUM_FRAMES*FRAME_SIZE);
+        umem = 0;
+    }
+    numTxFree = 0;
+}
+
+bool XdpSocket::IsZeroCopy(void) const
+{
+    struct xdp_options opts;
+    socklen_t optlen = sizeof(opts);
+    if ((fd < 0) || (getsockopt(fd, SOL_XDP, XDP_OPTIONS, &opts, &optlen) != 0))
+        return false;
+    return (opts.flags & XDP_OPTIONS_ZEROCOPY);
+}
+
+const struct xdp_desc *XdpSocket::Receive(double timeoutSec)
+{
+    SpinCount = 1;
+    const struct xdp_desc *desc = Next();
+    if (desc)
+        return desc;
+
+    // Not yet available, so wait (or spin) until timeout
+    double deadline = Amp1394_GetTime() + timeoutSec;
+    for (;;) {
+        if (!BusyPoll) {
+            double timeLeft = deadline - Amp1394_GetTime();
+            if (timeLeft <= 0.0)
+                return 0;
+            // poll also wakes up the driver, if needed
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(timeLeft);
+            ts.tv_nsec = static_cast<long>((timeLeft-ts.tv_sec)*1.0e9);
+            ppoll(&pfd, 1, &ts, 0);
+        }
+        else if (fill.NeedWakeup()) {
+            recvfrom(fd, 0, 0, MSG_DONTWAIT, 0, 0);
+        }
+        SpinCount++;
+        desc = Next();
+        if (desc)
+            return desc;
+        // When spinning, only check the time occasionally
+        if (BusyPoll && ((SpinCount%64) == 0) && (Amp1394_GetTime() > deadline))
+            return 0;
+    }
+}
+
+void XdpSocket::ReapCompletions(void)
+{
+    uint32_t num = comp.Available();
+    if (num == 0)
+        return;
+    for (uint32_t i = 0; i < num; i++)
+        txFree[numTxFree++] = *comp.Addr(comp.cons++);
+    comp.Consume();
+}
+
+unsigned int XdpSocket::Send(unsigned char * const *packets, const size_t *nbytes, unsigned int num)
+{
+    ReapCompletions();
+    unsigned int i;
+    for (i = 0; i < num; i++) {
+        if (nbytes[i] > FRAME_SIZE) {
+            outStr << "ERROR: packet too large for AF_XDP frame: " << nbytes[i] << " bytes" << std::endl;
+            break;
+        }
+        if (numTxFree == 0) {
+            // All TX frames in use; kick the kernel and wait (briefly) for completions
+            double deadline = Amp1394_GetTime() + 0.001;
+            while (numTxFree == 0) {
+                sendto(fd, 0, 0, MSG_DONTWAIT, 0, 0);
+                ReapCompletions();
+                if ((numTxFree == 0) && (Amp1394_GetTime() > deadline))
+                    break;
+            }
+            if (numTxFree == 0) {
+                outStr << "ERROR: no AF_XDP transmit frames available" << std::endl;
+                break;
+            }
+        }
+        uint64_t frameAddr = txFree[--numTxFree];
+        memcpy(umem+frameAddr, packets[i], nbytes[i]);
+        struct xdp_desc *desc = tx.Desc(tx.prod++);
+        desc->addr = frameAddr;
+        desc->len = static_cast<uint32_t>(nbytes[i]);
+        desc->options = 0;
+    }
+    if (i > 0) {
+        tx.Produce();
+        if (tx.NeedWakeup()) {
+            if ((sendto(fd, 0, 0, MSG_DONTWAIT, 0, 0) < 0) &&
+                (errno != EAGAIN) && (errno != EBUSY) && (errno != ENOBUFS)) {
+                outStr << "ERROR: AF_XDP send failed: " << strerror(errno) << std::endl;
+                return 0;
+            }
+        }
+    }
+    return i;
+}
+
+EthXdpPort::EthXdpPort(const std::string &ifName, unsigned int queueId, std::ostream &debugStream,
+                       EthCallbackType cb):
+    EthRawPort(static_cast<int>(queueId), debugStream, cb, false), IfName(ifName), xskPtr(0)
+{
+    if (Init())
+        outStr << "Initialization done" << std::endl;
+    else
+        outStr << "Initialization failed" << std::endl;
+}
+
+EthXdpPort::~EthXdpPort()
+{
+    Cleanup();
+}
+
+bool EthXdpPort::Init(void)
+{
+    // Increase ReceiveTimeout
+    ReceiveTimeout = 0.1;
+
+    uint8_t eth_src[6];   // Ethernet source address (local MAC address)
+    xskPtr = new XdpSocket(outStr);
+    if (!xskPtr->Open(IfName, static_cast<unsigned int>(PortNum), eth_src)) {
+        delete xskPtr;
+        xskPtr = 0;
+        return false;
+    }
+    EthBasePort::PrintMAC(outStr, "Local MAC address", eth_src);
+
+    SetFrameHeader(eth_src);
+
+    bool ret = ScanNodes();
+
+    if (ret)
+        SetDefaultProtocol();
+
+    return ret;
+}
+
+void EthXdpPort::Cleanup(void)
+{
+    delete xskPtr;
+    xskPtr = 0;
+}
+
+bool EthXdpPort::IsOK(void)
+{
+    return (xskPtr != 0);
+}
+
+bool EthXdpPort::IsZeroCopy(void) const
+{
+    return xskPtr ? xskPtr->IsZeroCopy() : false;
+}
+
+bool EthXdpPort::SetReceiveMode(ReceiveModeType mode, unsigned int busyPollUsec)
+{
+    if ((mode != RECV_WAIT) && (mode != RECV_BUSY_POLL)) {
+        outStr << "SetReceiveMode: invalid receive mode: " << mode << std::endl;
+        return false;
+    }
+    if (!xskPtr)
+        return false;
+    if (busyPollUsec != 0)
+        outStr << "SetReceiveMode: SO_BUSY_POLL not used by AF_XDP port" << std::endl;
+    xskPtr->BusyPoll = (mode == RECV_BUSY_POLL);
+    ReceiveMode = mode;
+    BusyPollUsec = 0;
+    return true;
+}
+
+bool EthXdpPort::PacketSend(unsigned char *packet, size_t nbytes, bool)
+{
+    return (xskPtr->Send(&packet, &nbytes, 1) == 1);
+}
+
+unsigned int EthXdpPort::PacketSendBatch(unsigned char * const *packets, const size_t *nbytes,
+                                         unsigned int num, bool)
+{
+    return xskPtr->Send(packets, nbytes, num);
+}
+
+int EthXdpPort::PacketReceive(unsigned char *recvPacket, size_t nbytes)
+{
+    // The XDP program only redirects packets from the FPGA to this PC (see XdpSocket::AttachProgram),
+    // so the first packet is used (in place).
+    const struct xdp_desc *desc = xskPtr->Receive(ReceiveTimeout);
+    UpdateSpinCount(xskPtr->SpinCount);
+    if (!desc)
+        return 0;
+    const unsigned char *packet = xskPtr->umem + desc->addr;
+    unsigned int nRead = GetFrameLength(packet, desc->len);
+    if (nRead == (ETH_FRAME_HEADER_SIZE + FW_EXTRA_SIZE)) {
+        outStr << "PacketReceive: only extra data" << std::endl;
+        ProcessExtraData(packet+ETH_FRAME_HEADER_SIZE);
+        nRead = 0;
+    }
+    if (nRead > desc->len)
+        nRead = desc->len;
+    if (nRead > nbytes) {
+        outStr << "PacketReceive: truncating packet from " << std::dec << nRead << " to "
+               << nbytes << " bytes" << std::endl;
+        nRead = nbytes;
+    }
+    if (nRead > 0)
+        memcpy(recvPacket, packet, nRead);
+    xskPtr->Release(desc);
+    return static_cast<int>(nRead);
+}
+
+int EthXdpPort::PacketFlushAll(void)
+{
+    int numFlushed = 0;
+    const struct xdp_desc *desc;
+    while ((desc = xskPtr->Next()) != 0) {
+        xskPtr->Release(desc);
+        numFlushed++;
+    }
+    xskPtr->ReapCompletions();
+    return numFlushed;
+}
@@ -0,0 +1,83 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include "FeedbackSnapshot.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Memory ordering for the seqlock. With GCC/Clang, the __atomic builtins are used. With MSVC
+// (x86/x64 only), volatile accesses have acquire/release semantics and the hardware does not
+// reorder loads with loads or stores with stores, so a compiler barrier is sufficient.
+#if defined(__GNUC__)
+static inline uint32_t LoadAcquire(const volatile uint32_t *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline uint32_t LoadRelaxed(const volatile uint32_t *p) { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+static inline void StoreRelease(volatile uint32_t *p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline void StoreRelaxed(volatile uint32_t *p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_RELAXED); }
+static inline void FenceAcquire(void) { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+static inline void FenceRelease(void) { __atomic_thread_fence(__ATOMIC_RELEASE); }
+#else
+static inline uint32_t LoadAcquire(const volatile uint32_t *p) { return *p; }
+static inline uint32_t LoadRelaxed(const volatile uint32_t *p) { return *p; }
+static inline void StoreRelease(volatile uint32_t *p, uint32_t v) { *p = v; }
+static inline void StoreRelaxed(volatile uint32_t *p, uint32_t v) { *p = v; }
+static inline void FenceAcquire(void) { _ReadWriteBarrier(); }
+static inline void FenceRelease(void) { _ReadWriteBarrier(); }
+#endif
+
+FeedbackBuffer::FeedbackBuffer() : latest(1), numPublished(0), writeIndex(0)
+{
+    seq[0] = 0;
+    seq[1] = 0;
+}
+
+FeedbackSnapshot &FeedbackBuffer::BeginWrite(double timestamp)
+{
+    // Write to the buffer that was not most recently published
+    writeIndex = latest^1;
+    StoreRelaxed(&seq[writeIndex], seq[writeIndex]+1);   // odd: write in progress
+    FenceRelease();
+    FeedbackSnapshot &snap = buffer[writeIndex];
+    // Sequence 0 indicates that nothing was published
+    if (++numPublished == 0)
+        numPublished = 1;
+    snap.sequence = numPublished;
+    snap.timestamp = timestamp;
+    for (unsigned int i = 0; i < BoardIO::MAX_BOARDS; i++)
+        snap.board[i].valid = false;
+    return snap;
+}
+
+void FeedbackBuffer::EndWrite(void)
+{
+    StoreRelease(&seq[writeIndex], seq[writeIndex]+1);   // even: write complete
+    StoreRelease(&latest, writeIndex);
+}
+
+bool FeedbackBuffer::Read(FeedbackSnapshot &snap) const
+{
+    for (;;) {
+        unsigned int index = LoadAcquire(&latest);
+        uint32_t seqStart = LoadAcquire(&seq[index]);
+        if (seqStart & 1)
+            continue;     // writer has wrapped around to this buffer
+        snap = buffer[index];
+        FenceAcquire();
+        if (LoadRelaxed(&seq[index]) == seqStart)
+            break;
+    }
+    return (snap.sequence != 0);
+}
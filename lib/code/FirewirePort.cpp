@@ -292,13 +292,20 @@ bool FirewirePort::WriteBroadcastReadRequest(unsigned int seq)
 #endif
 }
 
-void FirewirePort::WaitBroadcastRead(void)
+double FirewirePort::GetBroadcastReadWait(void) const
 {
-    // Wait for all boards to respond with data
     // Shorter wait: 10 + 5 * Nb us, where Nb is number of boards used in this configuration
     // Standard wait: 5 + 5 * Nn us, where Nn is the total number of nodes on the FireWire bus
     double waitTime_uS = IsBroadcastShorterWait() ? (10.0 + 5.0*NumOfBoards_) : (5.0 + 5.0*NumOfNodes_);
-    Amp1394_Sleep(waitTime_uS*1e-6);
+    return waitTime_uS*1e-6;
+}
+
+void FirewirePort::WaitBroadcastRead(void)
+{
+    // Wait for all boards to respond with data
+    double waitTime = GetBroadcastReadWait();
+    if (!WaitBroadcastReadAdaptive(waitTime))
+        Amp1394_Sleep(waitTime);
 }
 
 void FirewirePort::OnNoneRead(void)
@@ -0,0 +1,758 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <math.h>
+#include <algorithm>   // for std::min
+#include "FpgaEmulator.h"
+#include "EthBasePort.h"
+#include "Amp1394Time.h"
+#include "Amp1394BSwap.h"
+
+// crc related (see EthBasePort.cpp)
+uint32_t BitReverse32(uint32_t input);
+uint32_t crc32(uint32_t crc, const void *buf, size_t size);
+
+// Register bits (from AmpIO.cpp)
+const uint32_t VALID_BIT         = 0x80000000;  /*!< High bit of 32-bit word */
+const uint32_t MOTOR_ENABLE_MASK = 0x20000000;  /*!< Mask for enable bit (Firmware Rev 8+) */
+const uint32_t MOTOR_ENABLE_BIT  = 0x10000000;  /*!< Enable amplifier for motor (Firmware Rev 8+) */
+const uint32_t MSTAT_AMP_STATUS  = 0x20000000;  /*!< Motor status bit for amplifier (1=on, 0=off) (Rev 8+) */
+const uint32_t MSTAT_AMP_REQ     = 0x10000000;  /*!< Motor status bit for amplifier enable request (Rev 8+) */
+const uint32_t MV_GOOD_BIT       = 0x00080000;  /*!< Motor voltage good (read only) */
+const uint32_t PWR_ENABLE_MASK   = 0x00080000;  /*!< Power enable mask (write only) */
+const uint32_t PWR_ENABLE_BIT    = 0x00040000;  /*!< Power enable status (read/write) */
+const uint32_t RELAY_FB          = 0x00020000;  /*!< Safety relay feedback (read only) */
+const uint32_t RELAY_MASK        = 0x00020000;  /*!< Safety relay enable mask (write only) */
+const uint32_t RELAY_BIT         = 0x00010000;  /*!< Safety relay enable (read/write) */
+const uint32_t DAC_MASK          = 0x0000ffff;  /*!< Mask for 16-bit DAC values */
+const uint32_t MIDRANGE_ADC      = 0x00008000;  /*!< Midrange value of ADC bits */
+const int32_t  ENC_MIDRANGE      = 0x00800000;  /*!< Encoder position midrange value */
+const uint32_t ENC_POS_MASK      = 0x00ffffff;  /*!< Encoder position mask (24 bits) */
+
+// Encoder velocity bits (from EncoderVelocity.cpp)
+const uint32_t ENC_VEL_MASK_26   = 0x03ffffff;  /*!< Mask for encoder velocity (period) bits, Firmware Version >= 7 */
+const uint32_t ENC_VEL_OVER_MASK = 0x80000000;  /*!< Mask for encoder velocity (period) overflow bit */
+const uint32_t ENC_DIR_MASK      = 0x40000000;  /*!< Mask for encoder velocity (period) direction bit */
+const uint32_t ENC_VEL_MASK_22   = 0x003fffff;  /*!< Mask for encoder velocity (period) bits, Firmware Version == 6 */
+const uint32_t ENC_ACC_REV6_MASK = 0xffffffff;  /*!< Quarter-cycle periods (Rev 6) at maximum value */
+const double   VEL_FREQ          = 49152000.0;  /* Clock for velocity measurements (Rev 7+ firmware) */
+const double   VEL_FREQ_ESPM     = 80000000.0;  /* Clock for ESPM velocity measurements (dRA1) */
+const double   VEL_FREQ_REV6     = 3072000.0;   /* Clock for velocity measurements (Rev 6 firmware) */
+
+const double FPGA_sysclk_MHz     = 49.152;      /* FPGA sysclk in MHz (from AmpIO.cpp) */
+const double ENC_COUNTS_PER_DAC  = 1.0;         /* Simulated encoder velocity (counts/sec) per DAC unit */
+const double ETH_BITS_PER_SEC    = 100.0e6;     /* Simulated Ethernet speed (for extra data) */
+
+const nodeaddr_t HUB_ADDR        = 0x1000;      /* Address of hub data (broadcast read) */
+const nodeaddr_t BC_QUERY_ADDR   = 0x1800;      /* Address of broadcast query */
+
+// Convert time (seconds) to FPGA clock ticks, saturating at maxTicks
+static uint32_t TimeToTicks(double sec, uint32_t maxTicks)
+{
+    if (sec <= 0.0)
+        return 0;
+    double ticks = sec*FPGA_sysclk_MHz*1.0e6;
+    return (ticks >= maxTicks) ? maxTicks : static_cast<uint32_t>(ticks);
+}
+
+// Encoder period (time for 4 counts), in ticks of the velocity clock, as in EncoderVelocity::SetData
+static quadlet_t GetEncoderPeriod(unsigned long hwVersion, unsigned long fwVersion, double vel)
+{
+    quadlet_t mask = (fwVersion < 7) ? ENC_VEL_MASK_22 : ENC_VEL_MASK_26;
+    double absVel = fabs(vel);
+    if (absVel < 1.0)
+        return ENC_VEL_OVER_MASK|mask;
+    double clkFreq = VEL_FREQ;
+    if (fwVersion < 7)
+        clkFreq = VEL_FREQ_REV6;
+    else if (hwVersion == dRA1_String)
+        clkFreq = VEL_FREQ_ESPM;
+    double ticks = 4.0*clkFreq/absVel;
+    quadlet_t period = (ticks >= mask) ? mask : static_cast<quadlet_t>(ticks);
+    if (vel > 0.0)
+        period |= ENC_DIR_MASK;
+    return period;
+}
+
+// Read big-endian quadlet from (possibly unaligned) packet
+static quadlet_t GetPacketQuadlet(const unsigned char *packet)
+{
+    quadlet_t data;
+    memcpy(&data, packet, sizeof(quadlet_t));
+    return bswap_32(data);
+}
+
+FpgaEmulator::FpgaEmulator(std::ostream &debugStream) : outStr(debugStream), NumBoards(0), BusGeneration(1),
+                                                        BoardUpdateTime(5.0e-6), EnforceUpdateTime(false),
+                                                        QueryTime(0.0),
+                                                        NumPackets(0), NumPacketErrors(0)
+{
+    for (unsigned int i = 0; i < MAX_BOARDS; i++)
+        Boards[i] = 0;
+}
+
+FpgaEmulator::~FpgaEmulator()
+{
+    RemoveAllBoards();
+}
+
+bool FpgaEmulator::AddBoard(unsigned char boardId, unsigned long hwVersion, unsigned long fwVersion)
+{
+    if (NumBoards >= MAX_BOARDS) {
+        outStr << "FpgaEmulator::AddBoard: too many boards" << std::endl;
+        return false;
+    }
+    if (boardId >= MAX_BOARDS) {
+        outStr << "FpgaEmulator::AddBoard: invalid board id " << static_cast<unsigned int>(boardId) << std::endl;
+        return false;
+    }
+    if (GetBoardById(boardId)) {
+        outStr << "FpgaEmulator::AddBoard: board " << static_cast<unsigned int>(boardId)
+               << " already exists" << std::endl;
+        return false;
+    }
+    if ((fwVersion < 6) || (fwVersion > 8)) {
+        outStr << "FpgaEmulator::AddBoard: unsupported firmware version " << fwVersion << std::endl;
+        return false;
+    }
+
+    EmulatedBoard *board = new EmulatedBoard;
+    board->boardId = boardId;
+    board->hwVersion = hwVersion;
+    board->fwVersion = fwVersion;
+    if (hwVersion == QLA1_String) {
+        board->numMotors = 4;
+        board->numEncoders = 4;
+        board->ethStatus = 0x80000000;   // FPGA V2
+    }
+    else if ((hwVersion == DQLA_String) && (fwVersion >= 8)) {
+        board->numMotors = 8;
+        board->numEncoders = 8;
+        board->ethStatus = 0x40000000;   // FPGA V3
+    }
+    else if ((hwVersion == dRA1_String) && (fwVersion >= 8)) {
+        board->numMotors = 10;
+        board->numEncoders = 7;
+        board->ethStatus = 0x40000000;   // FPGA V3
+    }
+    else {
+        outStr << "FpgaEmulator::AddBoard: unsupported hardware version " << std::hex << hwVersion
+               << std::dec << " for firmware version " << fwVersion << std::endl;
+        delete board;
+        return false;
+    }
+    board->status = 0;
+    board->ipAddr = 0xffffffff;
+    for (unsigned int i = 0; i < MAX_CHANNELS; i++) {
+        board->dac[i] = MIDRANGE_ADC;
+        board->ampEnable[i] = false;
+        board->encPos[i] = 0.0;
+        board->encVel[i] = 0.0;
+    }
+    board->lastSampleTime = Amp1394_GetTime();
+    board->lastReadTime = board->lastSampleTime;
+    memset(board->hubData, 0, sizeof(board->hubData));
+    board->hubQuads = (fwVersion < 7) ? 17 : GetReadNumQuads(*board)+1;
+    memset(board->hubPending, 0, sizeof(board->hubPending));
+    board->hubReadyTime = 0.0;
+    board->hubPendingValid = false;
+
+    Boards[NumBoards++] = board;
+    return true;
+}
+
+void FpgaEmulator::RemoveAllBoards(void)
+{
+    for (unsigned int i = 0; i < NumBoards; i++) {
+        delete Boards[i];
+        Boards[i] = 0;
+    }
+    NumBoards = 0;
+}
+
+unsigned char FpgaEmulator::GetHubBoard(void) const
+{
+    const EmulatedBoard *hub = GetHub();
+    return hub ? hub->boardId : static_cast<unsigned char>(MAX_BOARDS);
+}
+
+void FpgaEmulator::BusReset(void)
+{
+    BusGeneration = (BusGeneration+1)&0xff;
+}
+
+unsigned long FpgaEmulator::ParseHardwareVersion(const std::string &str)
+{
+    if (str == "QLA1") return QLA1_String;
+    if (str == "DQLA") return DQLA_String;
+    if (str == "dRA1") return dRA1_String;
+    return 0;
+}
+
+FpgaEmulator::EmulatedBoard *FpgaEmulator::GetBoardByNode(nodeid_t node) const
+{
+    return (node < NumBoards) ? Boards[node] : 0;
+}
+
+FpgaEmulator::EmulatedBoard *FpgaEmulator::GetBoardById(unsigned char boardId) const
+{
+    for (unsigned int i = 0; i < NumBoards; i++) {
+        if (Boards[i]->boardId == boardId)
+            return Boards[i];
+    }
+    return 0;
+}
+
+// Same as AmpIO::GetReadNumBytes, but in quadlets
+unsigned int FpgaEmulator::GetReadNumQuads(const EmulatedBoard &board)
+{
+    if (board.fwVersion < 7)
+        return 4 + 4*board.numEncoders;
+    else if (board.fwVersion == 7)
+        return 4 + 6*board.numEncoders;
+    return 4 + 2*board.numMotors + 5*board.numEncoders;
+}
+
+// Same as AmpIO::GetWriteNumBytes, but in quadlets
+unsigned int FpgaEmulator::GetWriteNumQuads(const EmulatedBoard &board)
+{
+    return (board.fwVersion < 8) ? board.numMotors+1 : board.numMotors+2;
+}
+
+void FpgaEmulator::SampleFeedback(EmulatedBoard &board, quadlet_t *data, double now, bool clearTimestamp)
+{
+    unsigned int i;
+    double dt = now - board.lastSampleTime;
+    board.lastSampleTime = now;
+    for (i = 0; i < board.numEncoders; i++) {
+        board.encVel[i] = 0.0;
+        if ((i < board.numMotors) && board.ampEnable[i])
+            board.encVel[i] = (static_cast<double>(board.dac[i])-MIDRANGE_ADC)*ENC_COUNTS_PER_DAC;
+        board.encPos[i] += board.encVel[i]*dt;
+    }
+
+    // Timestamp is the number of clock ticks since the last block read
+    quadlet_t timestamp = TimeToTicks(now-board.lastReadTime, 0xffffffff);
+    if (clearTimestamp)
+        board.lastReadTime = now;
+
+    quadlet_t status = (board.numMotors << 28) | ((board.boardId&0x0f) << 24) | board.status;
+    if (board.status & PWR_ENABLE_BIT) status |= MV_GOOD_BIT;
+    if ((board.status & RELAY_BIT) && (board.hwVersion != DQLA_String)) status |= RELAY_FB;
+    if (board.hwVersion == QLA1_String) {
+        for (i = 0; i < board.numMotors; i++) {
+            if (board.ampEnable[i]) status |= (0x00000101 << i);
+        }
+    }
+
+    unsigned int n = 0;
+    data[n++] = bswap_32(timestamp);
+    data[n++] = bswap_32(status);
+    data[n++] = 0;                         // digital I/O
+    data[n++] = bswap_32(0x00005050);      // temperature
+    for (i = 0; i < board.numMotors; i++) {
+        // Upper half is pot (follows the encoder), lower half is measured motor current
+        double pos = (i < board.numEncoders) ? board.encPos[i] : 0.0;
+        long pot = static_cast<long>(MIDRANGE_ADC) + (static_cast<long>(floor(pos)) >> 8);
+        if (pot < 0) pot = 0;
+        if (pot > 0xffff) pot = 0xffff;
+        quadlet_t cur = board.ampEnable[i] ? (board.dac[i]&DAC_MASK) : MIDRANGE_ADC;
+        data[n++] = bswap_32((static_cast<quadlet_t>(pot) << 16) | cur);
+    }
+    for (i = 0; i < board.numEncoders; i++) {
+        int32_t pos = static_cast<int32_t>(floor(board.encPos[i])) + ENC_MIDRANGE;
+        data[n++] = bswap_32(static_cast<quadlet_t>(pos)&ENC_POS_MASK);
+    }
+    if (board.fwVersion < 7) {
+        // Period, followed by quarter-cycle periods (not emulated, so set to overflow value)
+        for (i = 0; i < board.numEncoders; i++)
+            data[n++] = bswap_32(GetEncoderPeriod(board.hwVersion, board.fwVersion, board.encVel[i]));
+        for (i = 0; i < board.numEncoders; i++)
+            data[n++] = bswap_32(ENC_ACC_REV6_MASK);
+    }
+    else {
+        quadlet_t velData[MAX_CHANNELS];
+        for (i = 0; i < board.numEncoders; i++)
+            velData[i] = GetEncoderPeriod(board.hwVersion, board.fwVersion, board.encVel[i]);
+        for (i = 0; i < board.numEncoders; i++)    // period
+            data[n++] = bswap_32(velData[i]);
+        for (i = 0; i < board.numEncoders; i++) {  // QTR1
+            quadlet_t qtr = (velData[i]&ENC_VEL_OVER_MASK) ? velData[i] : ((velData[i]&ENC_VEL_MASK_26)/4)|(velData[i]&ENC_DIR_MASK);
+            data[n++] = bswap_32(qtr);
+        }
+        for (i = 0; i < board.numEncoders; i++) {  // QTR5
+            quadlet_t qtr = (velData[i]&ENC_VEL_OVER_MASK) ? velData[i] : ((velData[i]&ENC_VEL_MASK_26)/4)|(velData[i]&ENC_DIR_MASK);
+            data[n++] = bswap_32(qtr);
+        }
+        for (i = 0; i < board.numEncoders; i++)    // running counter
+            data[n++] = 0;
+        if (board.fwVersion >= 8) {
+            for (i = 0; i < board.numMotors; i++) {
+                quadlet_t mstat = board.ampEnable[i] ? (MSTAT_AMP_STATUS|MSTAT_AMP_REQ) : 0;
+                data[n++] = bswap_32(mstat | (board.dac[i]&DAC_MASK));
+            }
+        }
+    }
+}
+
+void FpgaEmulator::WriteStatus(EmulatedBoard &board, quadlet_t data)
+{
+    if (data & PWR_ENABLE_MASK) {
+        if (data & PWR_ENABLE_BIT)
+            board.status |= PWR_ENABLE_BIT;
+        else
+            board.status &= ~PWR_ENABLE_BIT;
+    }
+    if (data & RELAY_MASK) {
+        if (data & RELAY_BIT)
+            board.status |= RELAY_BIT;
+        else
+            board.status &= ~RELAY_BIT;
+    }
+    // Amplifier enable: mask in bits 15-8, state in bits 7-0
+    quadlet_t ampMask = (data >> 8) & 0x000000ff;
+    for (unsigned int i = 0; (i < board.numMotors) && (i < 8); i++) {
+        if (ampMask & (1 << i))
+            board.ampEnable[i] = (data & (1 << i));
+    }
+    if (!(board.status & PWR_ENABLE_BIT)) {
+        for (unsigned int i = 0; i < board.numMotors; i++)
+            board.ampEnable[i] = false;
+    }
+}
+
+unsigned int FpgaEmulator::WriteRealtime(EmulatedBoard &board, const quadlet_t *data, unsigned int numQuads)
+{
+    unsigned int n = 0;
+    unsigned int numExpected = GetWriteNumQuads(board);
+    if (board.fwVersion >= 8) {
+        quadlet_t header = bswap_32(data[n++]);
+        if (((header >> 8) & 0x0f) != board.boardId) {
+            outStr << "FpgaEmulator::WriteRealtime: board id mismatch in header " << std::hex
+                   << header << std::dec << std::endl;
+            return 0;
+        }
+        numExpected = header & 0xff;
+    }
+    if ((numExpected > numQuads) && (board.fwVersion >= 7)) {
+        outStr << "FpgaEmulator::WriteRealtime: block too small for board "
+               << static_cast<unsigned int>(board.boardId) << std::endl;
+        return 0;
+    }
+    for (unsigned int i = 0; (i < board.numMotors) && (n < numQuads); i++) {
+        quadlet_t mdata = bswap_32(data[n++]);
+        if (mdata & VALID_BIT)
+            board.dac[i] = mdata & DAC_MASK;
+        if ((board.fwVersion >= 8) && (mdata & MOTOR_ENABLE_MASK))
+            board.ampEnable[i] = (mdata & MOTOR_ENABLE_BIT) && (board.status & PWR_ENABLE_BIT);
+    }
+    // Control quadlet, if present (always present for Firmware Rev 7+)
+    if (n < numQuads) {
+        quadlet_t ctrl = bswap_32(data[n++]);
+        if (ctrl)
+            WriteStatus(board, ctrl);
+    }
+    return n;
+}
+
+void FpgaEmulator::WriteBroadcast(const quadlet_t *data, unsigned int numQuads)
+{
+    const EmulatedBoard *hub = GetHub();
+    if (!hub)
+        return;
+    unsigned int offset = 0;
+    while (offset < numQuads) {
+        EmulatedBoard *board;
+        unsigned int blockQuads;
+        quadlet_t first = bswap_32(data[offset]);
+        if (hub->fwVersion >= 8) {
+            // Header quadlet contains board id and block size
+            board = GetBoardById((first >> 8) & 0x0f);
+            blockQuads = first & 0xff;
+        }
+        else {
+            // Board id is in each DAC quadlet; prior to Rev 7 control quadlet is written separately
+            board = GetBoardById((first >> 24) & 0x0f);
+            blockQuads = board ? ((board->fwVersion < 7) ? board->numMotors : board->numMotors+1) : 0;
+        }
+        if (blockQuads == 0)
+            break;
+        if (board)
+            WriteRealtime(*board, data+offset, std::min(blockQuads, numQuads-offset));
+        offset += blockQuads;
+    }
+}
+
+void FpgaEmulator::BroadcastQuery(quadlet_t data)
+{
+    unsigned int seq = data >> 16;
+    unsigned int mask = data & 0x0000ffff;
+    const EmulatedBoard *hub = GetHub();
+    if (!hub)
+        return;
+
+    double now = Amp1394_GetTime();
+    QueryTime = now;
+    unsigned int num = 0;
+    // Boards transfer their data to the hub in order of board id
+    for (unsigned int id = 0; id < MAX_BOARDS; id++) {
+        EmulatedBoard *board = GetBoardById(id);
+        if (!board)
+            continue;
+        if ((hub->fwVersion >= 7) && !(mask & (1 << id)))
+            continue;
+        double updateTime = BoardUpdateTime*(++num);
+        quadlet_t quad0;
+        if (hub->fwVersion >= 8)
+            quad0 = (board->hubQuads << 24) | ((seq & 0x00ff) << 16) | TimeToTicks(updateTime, 0x3fff);
+        else if (hub->fwVersion == 7)
+            quad0 = (seq << 16) | TimeToTicks(updateTime, 0x3fff);
+        else
+            quad0 = (seq << 16);
+        board->hubPending[0] = bswap_32(quad0);
+        if (hub->fwVersion < 7) {
+            // Prior to Rev 7, only 16 quadlets of data per board
+            quadlet_t feedback[MAX_QUADS];
+            SampleFeedback(*board, feedback, now, false);
+            memcpy(board->hubPending+1, feedback, 16*sizeof(quadlet_t));
+        }
+        else {
+            SampleFeedback(*board, board->hubPending+1, now, false);
+        }
+        board->hubReadyTime = now + updateTime;
+        board->hubPendingValid = true;
+    }
+}
+
+unsigned int FpgaEmulator::ReadHub(quadlet_t *data, unsigned int maxQuads)
+{
+    const EmulatedBoard *hub = GetHub();
+    memset(data, 0, maxQuads*sizeof(quadlet_t));
+    if (!hub)
+        return 0;
+
+    double now = Amp1394_GetTime();
+    double finishTime = QueryTime;
+    unsigned int n = 0;
+    for (unsigned int id = 0; id < MAX_BOARDS; id++) {
+        EmulatedBoard *board = GetBoardById(id);
+        if (board && board->hubPendingValid) {
+            if (!EnforceUpdateTime || (now >= board->hubReadyTime)) {
+                memcpy(board->hubData, board->hubPending, board->hubQuads*sizeof(quadlet_t));
+                board->hubPendingValid = false;
+            }
+            if (board->hubReadyTime > finishTime)
+                finishTime = board->hubReadyTime;
+        }
+        if (hub->fwVersion < 7) {
+            // Prior to Rev 7, data for all 16 boards (whether or not present)
+            if (board && (n+17 <= maxQuads))
+                memcpy(data+n, board->hubData, 17*sizeof(quadlet_t));
+            n += 17;
+        }
+        else if (board && (board->hubReadyTime >= QueryTime)) {
+            // Only boards included in the last query
+            if (n+board->hubQuads <= maxQuads)
+                memcpy(data+n, board->hubData, board->hubQuads*sizeof(quadlet_t));
+            n += board->hubQuads;
+        }
+    }
+    if (hub->fwVersion >= 7) {
+        // Timing quadlet: time from query to start of hub read, and to completion of all transfers
+        quadlet_t timing = (TimeToTicks(now-QueryTime, 0x3fff) << 16) | TimeToTicks(finishTime-QueryTime, 0x3fff);
+        if (n < maxQuads)
+            data[n] = bswap_32(timing);
+        n++;
+    }
+    return n;
+}
+
+bool FpgaEmulator::ReadQuadlet(nodeid_t node, nodeaddr_t addr, quadlet_t &data)
+{
+    // Broadcast read is handled by the hub (Ethernet-connected board)
+    EmulatedBoard *board = (node == FW_NODE_BROADCAST) ? GetHub() : GetBoardByNode(node);
+    if (!board)
+        return false;
+
+    data = 0;
+    switch (addr) {
+        case BoardIO::BOARD_STATUS:
+            {
+                quadlet_t feedback[MAX_QUADS];
+                SampleFeedback(*board, feedback, Amp1394_GetTime(), false);
+                data = bswap_32(feedback[1]);
+            }
+            break;
+        case BoardIO::HARDWARE_VERSION:
+            data = static_cast<quadlet_t>(board->hwVersion);
+            break;
+        case BoardIO::FIRMWARE_VERSION:
+            data = static_cast<quadlet_t>(board->fwVersion);
+            break;
+        case BoardIO::IP_ADDR:
+            data = board->ipAddr;
+            break;
+        case BoardIO::ETH_STATUS:
+            data = board->ethStatus;
+            break;
+        case BoardIO::FW_PHY_RESP:
+        case BoardIO::GIT_DESC:
+            break;
+        default:
+            {
+                std::map<nodeaddr_t, quadlet_t>::const_iterator it = board->regs.find(addr);
+                if (it != board->regs.end())
+                    data = it->second;
+            }
+            break;
+    }
+    return true;
+}
+
+bool FpgaEmulator::WriteQuadlet(nodeid_t node, nodeaddr_t addr, quadlet_t data)
+{
+    if (node == FW_NODE_BROADCAST) {
+        if (addr == BC_QUERY_ADDR) {
+            BroadcastQuery(data);
+        }
+        else {
+            for (unsigned int i = 0; i < NumBoards; i++)
+                WriteQuadlet(i, addr, data);
+        }
+        return true;
+    }
+
+    EmulatedBoard *board = GetBoardByNode(node);
+    if (!board)
+        return false;
+
+    switch (addr) {
+        case BoardIO::BOARD_STATUS:
+            WriteStatus(*board, data);
+            break;
+        case BoardIO::IP_ADDR:
+            board->ipAddr = data;
+            break;
+        case BoardIO::FW_PHY_REQ:
+        case BoardIO::ETH_STATUS:
+            break;
+        case BoardIO::HARDWARE_VERSION:
+        case BoardIO::FIRMWARE_VERSION:
+        case BoardIO::FW_PHY_RESP:
+        case BoardIO::GIT_DESC:
+            // read-only
+            break;
+        default:
+            board->regs[addr] = data;
+            break;
+    }
+    return true;
+}
+
+bool FpgaEmulator::ReadBlock(nodeid_t node, nodeaddr_t addr, quadlet_t *rdata, unsigned int nbytes)
+{
+    EmulatedBoard *board = (node == FW_NODE_BROADCAST) ? GetHub() : GetBoardByNode(node);
+    if (!board || (nbytes%4 != 0))
+        return false;
+
+    unsigned int numQuads = nbytes/4;
+    if (addr == 0) {
+        quadlet_t feedback[MAX_QUADS];
+        unsigned int readQuads = GetReadNumQuads(*board);
+        SampleFeedback(*board, feedback, Amp1394_GetTime(), true);
+        memset(rdata, 0, nbytes);
+        memcpy(rdata, feedback, std::min(numQuads, readQuads)*sizeof(quadlet_t));
+    }
+    else if (addr == HUB_ADDR) {
+        ReadHub(rdata, numQuads);
+    }
+    else {
+        for (unsigned int i = 0; i < numQuads; i++) {
+            std::map<nodeaddr_t, quadlet_t>::const_iterator it = board->regs.find(addr+i);
+            rdata[i] = (it != board->regs.end()) ? bswap_32(it->second) : 0;
+        }
+    }
+    return true;
+}
+
+bool FpgaEmulator::WriteBlock(nodeid_t node, nodeaddr_t addr, const quadlet_t *wdata, unsigned int nbytes)
+{
+    if (nbytes%4 != 0)
+        return false;
+    unsigned int numQuads = nbytes/4;
+    if (node == FW_NODE_BROADCAST) {
+        if (addr == 0)
+            WriteBroadcast(wdata, numQuads);
+        else {
+            for (unsigned int i = 0; i < NumBoards; i++)
+                WriteBlock(i, addr, wdata, nbytes);
+        }
+        return true;
+    }
+
+    EmulatedBoard *board = GetBoardByNode(node);
+    if (!board)
+        return false;
+    if (addr == 0) {
+        WriteRealtime(*board, wdata, numQuads);
+    }
+    else {
+        for (unsigned int i = 0; i < numQuads; i++)
+            board->regs[addr+i] = bswap_32(wdata[i]);
+    }
+    return true;
+}
+
+size_t FpgaEmulator::ProcessPacket(const unsigned char *request, size_t reqLen,
+                                   unsigned char *response, size_t maxLen)
+{
+    NumPackets++;
+    if (reqLen < FW_CTRL_SIZE+FW_QREAD_SIZE) {
+        outStr << "FpgaEmulator::ProcessPacket: packet too short (" << reqLen << " bytes)" << std::endl;
+        NumPacketErrors++;
+        return 0;
+    }
+
+    // Control word (FW_CTRL_NOFORWARD and bus generation) is not checked
+    const unsigned char *packet = request+FW_CTRL_SIZE;
+    size_t packetLen = reqLen-FW_CTRL_SIZE;
+    quadlet_t q0 = GetPacketQuadlet(packet);
+    quadlet_t q1 = GetPacketQuadlet(packet+4);
+    quadlet_t q2 = GetPacketQuadlet(packet+8);
+    nodeid_t node = (q0 >> 16) & FW_NODE_MASK;
+    unsigned int tl = (q0 >> 10) & FW_TL_MASK;
+    unsigned int tcode = (q0 >> 4) & 0x0f;
+    nodeaddr_t addr = (static_cast<nodeaddr_t>(q1&0x0000ffff) << 32) | q2;
+    // Responses from broadcast reads come from the hub (node 0)
+    nodeid_t srcNode = (node == FW_NODE_BROADCAST) ? 0 : node;
+
+    quadlet_t data[MAX_POSSIBLE_DATA_SIZE/sizeof(quadlet_t)];
+    unsigned int nbytes = 0;
+    bool ok = true;
+
+    switch (tcode) {
+        case EthBasePort::QREAD:
+            ok = ReadQuadlet(node, addr, data[0]);
+            data[0] = bswap_32(data[0]);
+            if (ok)
+                nbytes = 4;
+            break;
+
+        case EthBasePort::QWRITE:
+            if (packetLen < FW_QWRITE_SIZE) {
+                NumPacketErrors++;
+                return 0;
+            }
+            WriteQuadlet(node, addr, GetPacketQuadlet(packet+12));
+            return 0;
+
+        case EthBasePort::BREAD:
+            if (packetLen < FW_BREAD_SIZE) {
+                NumPacketErrors++;
+                return 0;
+            }
+            nbytes = GetPacketQuadlet(packet+12) >> 16;
+            if ((nbytes == 0) || (nbytes > MAX_POSSIBLE_DATA_SIZE)) {
+                outStr << "FpgaEmulator::ProcessPacket: invalid block read size " << nbytes << std::endl;
+                NumPacketErrors++;
+                return 0;
+            }
+            ok = ReadBlock(node, addr, data, nbytes);
+            break;
+
+        case EthBasePort::BWRITE:
+            if (packetLen < FW_BWRITE_HEADER_SIZE) {
+                NumPacketErrors++;
+                return 0;
+            }
+            nbytes = GetPacketQuadlet(packet+12) >> 16;
+            if ((nbytes > MAX_POSSIBLE_DATA_SIZE) || (packetLen < FW_BWRITE_HEADER_SIZE+nbytes+FW_CRC_SIZE)) {
+                outStr << "FpgaEmulator::ProcessPacket: invalid block write size " << nbytes << std::endl;
+                NumPacketErrors++;
+                return 0;
+            }
+            // Copy data, since it is not quadlet-aligned in the request
+            memcpy(data, packet+FW_BWRITE_HEADER_SIZE, nbytes);
+            WriteBlock(node, addr, data, nbytes);
+            return 0;
+
+        default:
+            outStr << "FpgaEmulator::ProcessPacket: unsupported tcode " << tcode << std::endl;
+            NumPacketErrors++;
+            return 0;
+    }
+
+    // For a read from a node that does not exist, the firmware only returns the extra data
+    size_t respLen = 0;
+    if (ok) {
+        unsigned int respTcode = (tcode == EthBasePort::QREAD) ? EthBasePort::QRESPONSE : EthBasePort::BRESPONSE;
+        respLen = MakeResponse(response, maxLen, srcNode, tl, respTcode, data, nbytes);
+        if (respLen == 0) {
+            outStr << "FpgaEmulator::ProcessPacket: response buffer too small" << std::endl;
+            return 0;
+        }
+    }
+    if (respLen+FW_EXTRA_SIZE > maxLen)
+        return 0;
+    return respLen + MakeExtraData(response+respLen, reqLen);
+}
+
+size_t FpgaEmulator::MakeResponse(unsigned char *response, size_t maxLen, nodeid_t srcNode, unsigned int tl,
+                                  unsigned int tcode, const quadlet_t *data, unsigned int nbytes) const
+{
+    size_t packetSize = (tcode == EthBasePort::QRESPONSE) ? FW_QRESPONSE_SIZE
+                                                          : FW_BRESPONSE_HEADER_SIZE+nbytes+FW_CRC_SIZE;
+    if (packetSize+FW_EXTRA_SIZE > maxLen)
+        return 0;
+
+    // Quadlet 0:  | Destination ID (16) | TL (6) | RT (2) | TCODE (4) | PRI (4) |
+    // Quadlet 1:  | Source ID (16)      | RCODE (4) | Reserved (12)             |
+    // Quadlet 2:  | Reserved (32)                                               |
+    quadlet_t header[5];
+    header[0] = bswap_32((0xFFD0 << 16) | ((tl & 0x003F) << 10) | ((tcode & 0x000F) << 4));
+    header[1] = bswap_32((0xFFC0 | (srcNode&FW_NODE_MASK)) << 16);
+    header[2] = 0;
+    if (tcode == EthBasePort::QRESPONSE) {
+        header[3] = data[0];
+        header[4] = bswap_32(BitReverse32(crc32(0U, header, FW_QRESPONSE_SIZE-FW_CRC_SIZE)));
+        memcpy(response, header, FW_QRESPONSE_SIZE);
+    }
+    else {
+        header[3] = bswap_32((nbytes & 0x0000ffff) << 16);
+        header[4] = bswap_32(BitReverse32(crc32(0U, header, FW_BRESPONSE_HEADER_SIZE-FW_CRC_SIZE)));
+        memcpy(response, header, FW_BRESPONSE_HEADER_SIZE);
+        memcpy(response+FW_BRESPONSE_HEADER_SIZE, data, nbytes);
+        quadlet_t dataCRC = bswap_32(BitReverse32(crc32(0U, data, nbytes)));
+        memcpy(response+FW_BRESPONSE_HEADER_SIZE+nbytes, &dataCRC, FW_CRC_SIZE);
+    }
+    return packetSize;
+}
+
+size_t FpgaEmulator::MakeExtraData(unsigned char *extra, size_t reqLen) const
+{
+    // Byte 0: FPGA flags, Byte 1: FireWire bus generation, Byte 2: numStateInvalid, Byte 3: numPacketError,
+    // Bytes 4-5: time to receive packet, Bytes 6-7: total time (both in FPGA clock ticks, big-endian)
+    uint16_t recvTicks = static_cast<uint16_t>(TimeToTicks(reqLen*8.0/ETH_BITS_PER_SEC, 0xffff));
+    uint16_t totalTicks = static_cast<uint16_t>(TimeToTicks(reqLen*8.0/ETH_BITS_PER_SEC + 2.0e-6, 0xffff));
+    extra[0] = 0;
+    extra[1] = static_cast<unsigned char>(BusGeneration);
+    extra[2] = 0;
+    extra[3] = static_cast<unsigned char>(NumPacketErrors);
+    extra[4] = static_cast<unsigned char>(recvTicks >> 8);
+    extra[5] = static_cast<unsigned char>(recvTicks);
+    extra[6] = static_cast<unsigned char>(totalTicks >> 8);
+    extra[7] = static_cast<unsigned char>(totalTicks);
+    return FW_EXTRA_SIZE;
+}
@@ -0,0 +1,110 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include <string.h>
+#include <iomanip>
+#include <algorithm>
+#include "LatencyHistogram.h"
+
+void LatencyHistogram::Reset(void)
+{
+    memset(counts, 0, sizeof(counts));
+    totalCount = 0;
+    sum = 0;
+    minValue = ~static_cast<uint64_t>(0);
+    maxValue = 0;
+}
+
+void LatencyHistogram::Add(const LatencyHistogram &other)
+{
+    for (unsigned int i = 0; i < NUM_BUCKETS; i++)
+        counts[i] += other.counts[i];
+    totalCount += other.totalCount;
+    sum += other.sum;
+    if (other.minValue < minValue) minValue = other.minValue;
+    if (other.maxValue > maxValue) maxValue = other.maxValue;
+}
+
+void LatencyHistogram::CopyFrom(const LatencyHistogram &other)
+{
+    unsigned int first = NUM_BUCKETS;
+    unsigned int last = 0;
+    if (totalCount > 0) {
+        first = GetBucketIndex(minValue);
+        last = GetBucketIndex(maxValue);
+    }
+    if (other.totalCount > 0) {
+        first = std::min(first, GetBucketIndex(other.minValue));
+        last = std::max(last, GetBucketIndex(other.maxValue));
+    }
+    if (first <= last)
+        memcpy(counts+first, other.counts+first, (last-first+1)*sizeof(uint32_t));
+    totalCount = other.totalCount;
+    sum = other.sum;
+    minValue = other.minValue;
+    maxValue = other.maxValue;
+}
+
+uint64_t LatencyHistogram::GetBucketLowerBound(unsigned int index)
+{
+    if (index < 2*SUB_BUCKETS)
+        return index;
+    unsigned int shift = index/SUB_BUCKETS - 1;
+    return static_cast<uint64_t>(index - shift*SUB_BUCKETS) << shift;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(unsigned int index)
+{
+    if (index < 2*SUB_BUCKETS)
+        return index;
+    unsigned int shift = index/SUB_BUCKETS - 1;
+    return GetBucketLowerBound(index) + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double pct) const
+{
+    if (totalCount == 0)
+        return 0;
+    if (pct >= 100.0)
+        return maxValue;
+    // Number of values that must be at or below the returned value
+    uint64_t target = static_cast<uint64_t>(pct*0.01*totalCount + 0.5);
+    if (target < 1) target = 1;
+    uint64_t cumulative = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; i++) {
+        cumulative += counts[i];
+        if (cumulative >= target) {
+            uint64_t value = GetBucketUpperBound(i);
+            return (value < maxValue) ? value : maxValue;
+        }
+    }
+    return maxValue;
+}
+
+void LatencyHistogram::PrintSummary(std::ostream &outStr) const
+{
+    std::ios_base::fmtflags saveFlags = outStr.flags();
+    std::streamsize savePrecision = outStr.precision();
+    outStr << std::fixed << std::setprecision(2)
+           << "count " << totalCount
+           << ", min " << GetMin()*1.0e-3
+           << ", mean " << GetMean()*1.0e-3
+           << ", p50 " << GetPercentile(50.0)*1.0e-3
+           << ", p99 " << GetPercentile(99.0)*1.0e-3
+           << ", p99.9 " << GetPercentile(99.9)*1.0e-3
+           << ", max " << GetMax()*1.0e-3 << " (us)";
+    outStr.flags(saveFlags);
+    outStr.precision(savePrecision);
+}
@@ -21,13 +21,17 @@ http://www.cisst.org/cisst/license.txt.
 #if Amp1394_HAS_RAW1394
 #include "FirewirePort.h"
 #endif
-#if Amp1394_HAS_PCAP
+#if Amp1394_HAS_ETH_RAW
 #include "EthRawPort.h"
 #endif
+#if Amp1394_HAS_XDP
+#include "EthXdpPort.h"
+#endif
 #if Amp1394_HAS_EMIO
 #include "ZynqEmioPort.h"
 #endif
 #include "EthUdpPort.h"
+#include "SimPort.h"
 
 BasePort * PortFactory(const char * args, std::ostream & debugStream)
 {
@@ -57,10 +61,18 @@ BasePort * PortFactory(const char * args, std::ostream & debugStream)
         break;
     
     case BasePort::PORT_ETH_RAW:
-#if Amp1394_HAS_PCAP
+#if Amp1394_HAS_ETH_RAW
         port = new EthRawPort(portNumber, debugStream);
 #else
-        debugStream << "PortFactory: Raw Ethernet not available (set Amp1394_HAS_PCAP in CMake)" << std::endl;
+        debugStream << "PortFactory: Raw Ethernet not available (set Amp1394_HAS_PCAP or Amp1394_HAS_PACKET_MMAP in CMake)" << std::endl;
+#endif
+        break;
+
+    case BasePort::PORT_ETH_XDP:
+#if Amp1394_HAS_XDP
+        port = new EthXdpPort(IPaddr, portNumber, debugStream);
+#else
+        debugStream << "PortFactory: AF_XDP Ethernet not available (set Amp1394_HAS_XDP in CMake)" << std::endl;
 #endif
         break;
 
@@ -72,6 +84,10 @@ BasePort * PortFactory(const char * args, std::ostream & debugStream)
 #endif
         break;
 
+    case BasePort::PORT_SIM:
+        port = new SimPort(portNumber, debugStream);
+        break;
+
     default:
         debugStream << "PortFactory: Unsupported port type" << std::endl;
         break;
@@ -0,0 +1,283 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include "PortGroup.h"
+#include "BasePort.h"
+#include "CycleExecutor.h"
+#include "Amp1394Time.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <string.h>
+
+// Spin-wait hint for the CPU (reduces power and the penalty when leaving the loop)
+static inline void CpuRelax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+struct WorkerInfo {
+    PortGroup *group;
+    PortGroupInternals *internals;
+    unsigned int index;
+};
+
+// Worker threads and the barrier. The calling thread sets op and startTime, then increments
+// generation to release the workers; each worker increments numDone when finished.
+struct PortGroupInternals {
+    pthread_t thread[PortGroup::MAX_PORTS];
+    WorkerInfo info[PortGroup::MAX_PORTS];
+    unsigned int numThreads;
+    pthread_mutex_t mutex;
+    pthread_cond_t startCond;       // signaled when generation is incremented
+    pthread_cond_t doneCond;        // signaled when numReady or numDone is complete
+    uint32_t generation;
+    int op;
+    double startTime;
+    uint32_t numDone;
+    uint32_t numReady;              // number of threads started (used by Start)
+    bool threadError;               // true if a thread could not set its priority or affinity
+
+    PortGroupInternals() : numThreads(0), generation(0), op(0), startTime(0.0), numDone(0),
+                           numReady(0), threadError(false)
+    {
+        pthread_mutex_init(&mutex, 0);
+        pthread_cond_init(&startCond, 0);
+        pthread_cond_init(&doneCond, 0);
+    }
+    ~PortGroupInternals()
+    {
+        pthread_cond_destroy(&doneCond);
+        pthread_cond_destroy(&startCond);
+        pthread_mutex_destroy(&mutex);
+    }
+};
+#else
+struct PortGroupInternals {
+};
+#endif
+
+PortGroup::PortGroup(std::ostream &debugStream) : outStr(debugStream), numPorts(0), rtPriority(0),
+                                                  spinWait(false), internals(0)
+{
+    for (unsigned int i = 0; i < MAX_PORTS; i++) {
+        ports[i] = 0;
+        cpuNum[i] = -1;
+    }
+}
+
+PortGroup::~PortGroup()
+{
+    Stop();
+}
+
+bool PortGroup::AddPort(BasePort *port, int cpu)
+{
+    if (!port)
+        return false;
+    if (internals) {
+        outStr << "PortGroup::AddPort: cannot add port while running" << std::endl;
+        return false;
+    }
+    if (numPorts >= MAX_PORTS) {
+        outStr << "PortGroup::AddPort: too many ports (maximum " << MAX_PORTS << ")" << std::endl;
+        return false;
+    }
+    ports[numPorts] = port;
+    cpuNum[numPorts] = cpu;
+    numPorts++;
+    return true;
+}
+
+bool PortGroup::Start(void)
+{
+    if (internals)
+        return true;
+#ifdef __linux__
+    PortGroupInternals *in = new PortGroupInternals;
+    internals = in;
+    for (unsigned int i = 0; i < numPorts; i++) {
+        in->info[i].group = this;
+        in->info[i].internals = in;
+        in->info[i].index = i;
+        if (pthread_create(&in->thread[i], 0, WorkerThread, &in->info[i]) != 0) {
+            outStr << "PortGroup::Start: failed to create thread for port " << i << std::endl;
+            in->threadError = true;
+            break;
+        }
+        in->numThreads++;
+    }
+    // Wait for the threads to set their priority and affinity
+    pthread_mutex_lock(&in->mutex);
+    while (in->numReady < in->numThreads)
+        pthread_cond_wait(&in->doneCond, &in->mutex);
+    bool ok = !in->threadError;
+    pthread_mutex_unlock(&in->mutex);
+    if (!ok)
+        Stop();
+    return ok;
+#else
+    outStr << "PortGroup::Start: worker threads only supported on Linux, ports will be used sequentially"
+           << std::endl;
+    return false;
+#endif
+}
+
+void PortGroup::Stop(void)
+{
+#ifdef __linux__
+    PortGroupInternals *in = internals;
+    if (!in)
+        return;
+    pthread_mutex_lock(&in->mutex);
+    in->op = OP_EXIT;
+    __atomic_store_n(&in->generation, in->generation+1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&in->startCond);
+    pthread_mutex_unlock(&in->mutex);
+    for (unsigned int i = 0; i < in->numThreads; i++)
+        pthread_join(in->thread[i], 0);
+    internals = 0;
+    delete in;
+#endif
+}
+
+void *PortGroup::WorkerThread(void *arg)
+{
+#ifdef __linux__
+    WorkerInfo *info = static_cast<WorkerInfo *>(arg);
+    PortGroup *group = info->group;
+    PortGroupInternals *in = info->internals;
+
+    bool ok = CycleExecutor::SetCurrentThreadParameters(group->rtPriority, group->cpuNum[info->index],
+                                                        group->outStr);
+    pthread_mutex_lock(&in->mutex);
+    if (!ok)
+        in->threadError = true;
+    in->numReady++;
+    uint32_t lastGen = in->generation;
+    pthread_cond_signal(&in->doneCond);
+    pthread_mutex_unlock(&in->mutex);
+
+    for (;;) {
+        // Wait for the next operation
+        if (group->spinWait) {
+            while (__atomic_load_n(&in->generation, __ATOMIC_ACQUIRE) == lastGen)
+                CpuRelax();
+        }
+        else {
+            pthread_mutex_lock(&in->mutex);
+            while (in->generation == lastGen)
+                pthread_cond_wait(&in->startCond, &in->mutex);
+            pthread_mutex_unlock(&in->mutex);
+        }
+        lastGen = __atomic_load_n(&in->generation, __ATOMIC_ACQUIRE);
+        int op = in->op;
+        if (op == OP_EXIT)
+            break;
+        group->DoOperation(info->index, op, in->startTime);
+        // The last worker to finish wakes up the calling thread
+        if ((__atomic_add_fetch(&in->numDone, 1, __ATOMIC_ACQ_REL) == in->numThreads) && !group->spinWait) {
+            pthread_mutex_lock(&in->mutex);
+            pthread_cond_signal(&in->doneCond);
+            pthread_mutex_unlock(&in->mutex);
+        }
+    }
+#else
+    (void)arg;
+#endif
+    return 0;
+}
+
+void PortGroup::DoOperation(unsigned int index, int op, double startTime)
+{
+    PortTiming &pt = timing.port[index];
+    double t0 = Amp1394_GetTime();
+    BasePort *port = ports[index];
+    switch (op) {
+        case OP_READ:        pt.ok = port->ReadAllBoards(); break;
+        case OP_WRITE:       pt.ok = port->WriteAllBoards(); break;
+        case OP_WRITE_READ:  pt.ok = port->WriteReadAllBoards(); break;
+        default:             pt.ok = false; break;
+    }
+    double t1 = Amp1394_GetTime();
+    pt.start = t0 - startTime;
+    pt.duration = t1 - t0;
+}
+
+bool PortGroup::RunOperation(int op)
+{
+    unsigned int i;
+    double startTime = Amp1394_GetTime();
+    timing.timestamp = startTime;
+    timing.numPorts = numPorts;
+    for (i = 0; i < numPorts; i++)
+        ports[i]->SetCycleTimestamp(startTime);
+
+#ifdef __linux__
+    PortGroupInternals *in = internals;
+    if (in) {
+        // Release the workers
+        pthread_mutex_lock(&in->mutex);
+        in->op = op;
+        in->startTime = startTime;
+        __atomic_store_n(&in->numDone, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&in->generation, in->generation+1, __ATOMIC_RELEASE);
+        pthread_cond_broadcast(&in->startCond);
+        pthread_mutex_unlock(&in->mutex);
+        // Barrier: wait for all workers to finish
+        if (spinWait) {
+            while (__atomic_load_n(&in->numDone, __ATOMIC_ACQUIRE) < in->numThreads)
+                CpuRelax();
+        }
+        else {
+            pthread_mutex_lock(&in->mutex);
+            while (__atomic_load_n(&in->numDone, __ATOMIC_ACQUIRE) < in->numThreads)
+                pthread_cond_wait(&in->doneCond, &in->mutex);
+            pthread_mutex_unlock(&in->mutex);
+        }
+    }
+    else
+#endif
+    {
+        for (i = 0; i < numPorts; i++)
+            DoOperation(i, op, startTime);
+    }
+
+    timing.total = Amp1394_GetTime() - startTime;
+    bool allOK = true;
+    for (i = 0; i < numPorts; i++) {
+        ports[i]->SetCycleTimestamp(0.0);
+        if (!timing.port[i].ok)
+            allOK = false;
+    }
+    return allOK;
+}
+
+bool PortGroup::ReadAllBoards(void)
+{
+    return RunOperation(OP_READ);
+}
+
+bool PortGroup::WriteAllBoards(void)
+{
+    return RunOperation(OP_WRITE);
+}
+
+bool PortGroup::WriteReadAllBoards(void)
+{
+    return RunOperation(OP_WRITE_READ);
+}
@@ -0,0 +1,158 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include "PortRequest.h"
+#include "Amp1394Time.h"
+
+// Atomic operations (see also FeedbackSnapshot.cpp). With MSVC (x86/x64 only), volatile accesses
+// have acquire/release semantics and the Interlocked functions are full barriers.
+#ifdef _MSC_VER
+#include <intrin.h>
+static inline int LoadAcquire(const volatile int *p) { return *p; }
+static inline void StoreRelease(volatile int *p, int v) { *p = v; }
+static inline bool CompareExchangeInt(volatile int *p, int expected, int desired)
+{ return (_InterlockedCompareExchange(reinterpret_cast<volatile long *>(p), desired, expected) == expected); }
+static inline PortRequest *LoadPtr(PortRequest * volatile *p) { return *p; }
+static inline bool CompareExchangePtr(PortRequest * volatile *p, PortRequest *expected, PortRequest *desired)
+{ return (_InterlockedCompareExchangePointer(reinterpret_cast<void * volatile *>(p), desired, expected) == expected); }
+static inline PortRequest *ExchangePtr(PortRequest * volatile *p, PortRequest *v)
+{ return static_cast<PortRequest *>(_InterlockedExchangePointer(reinterpret_cast<void * volatile *>(p), v)); }
+#else
+static inline int LoadAcquire(const volatile int *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void StoreRelease(volatile int *p, int v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline bool CompareExchangeInt(volatile int *p, int expected, int desired)
+{ return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); }
+static inline PortRequest *LoadPtr(PortRequest * volatile *p) { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+static inline bool CompareExchangePtr(PortRequest * volatile *p, PortRequest *expected, PortRequest *desired)
+{ return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED); }
+static inline PortRequest *ExchangePtr(PortRequest * volatile *p, PortRequest *v)
+{ return __atomic_exchange_n(p, v, __ATOMIC_ACQUIRE); }
+#endif
+
+PortRequest::PortRequest() : type(READ_QUADLET), boardId(0), addr(0), data(0), buffer(0), nbytes(0),
+                             status(REQ_IDLE), cancel(0), next(0)
+{
+}
+
+void PortRequest::SetReadQuadlet(unsigned char board, nodeaddr_t address)
+{
+    type = READ_QUADLET;
+    boardId = board;
+    addr = address;
+    data = 0;
+    buffer = 0;
+    nbytes = 0;
+}
+
+void PortRequest::SetWriteQuadlet(unsigned char board, nodeaddr_t address, quadlet_t wdata)
+{
+    type = WRITE_QUADLET;
+    boardId = board;
+    addr = address;
+    data = wdata;
+    buffer = 0;
+    nbytes = 0;
+}
+
+void PortRequest::SetReadBlock(unsigned char board, nodeaddr_t address, quadlet_t *rdata, unsigned int numBytes)
+{
+    type = READ_BLOCK;
+    boardId = board;
+    addr = address;
+    data = 0;
+    buffer = rdata;
+    nbytes = numBytes;
+}
+
+void PortRequest::SetWriteBlock(unsigned char board, nodeaddr_t address, quadlet_t *wdata, unsigned int numBytes)
+{
+    type = WRITE_BLOCK;
+    boardId = board;
+    addr = address;
+    data = 0;
+    buffer = wdata;
+    nbytes = numBytes;
+}
+
+void PortRequest::SetStatus(RequestStatus newStatus)
+{
+    StoreRelease(&status, newStatus);
+}
+
+PortRequest::RequestStatus PortRequest::GetStatus(void) const
+{
+    return static_cast<RequestStatus>(LoadAcquire(&status));
+}
+
+bool PortRequest::Wait(double timeoutSec, double pollSec) const
+{
+    double deadline = Amp1394_GetTime() + timeoutSec;
+    RequestStatus curStatus;
+    while ((curStatus = GetStatus()) == REQ_QUEUED) {
+        if ((timeoutSec >= 0.0) && (Amp1394_GetTime() > deadline))
+            break;
+        Amp1394_Sleep(pollSec);
+    }
+    return (curStatus == REQ_DONE);
+}
+
+void PortRequest::Cancel(void)
+{
+    StoreRelease(&cancel, 1);
+}
+
+bool PortRequest::IsCancelRequested(void) const
+{
+    return (LoadAcquire(&cancel) != 0);
+}
+
+bool PortRequestQueue::Push(PortRequest *req)
+{
+    // Only one thread can queue a given request
+    int curStatus = LoadAcquire(&req->status);
+    if ((curStatus == PortRequest::REQ_QUEUED) ||
+        !CompareExchangeInt(&req->status, curStatus, PortRequest::REQ_QUEUED))
+        return false;
+    StoreRelease(&req->cancel, 0);
+    PortRequest *oldHead;
+    do {
+        oldHead = LoadPtr(&head);
+        req->next = oldHead;
+    } while (!CompareExchangePtr(&head, oldHead, req));
+    return true;
+}
+
+PortRequest *PortRequestQueue::Pop(void)
+{
+    if (!pendingHead) {
+        // Take all requests pushed since last time; these are in reverse order, so they are
+        // reversed before being added to the pending list
+        PortRequest *list = (LoadPtr(&head) != 0) ? ExchangePtr(&head, 0) : 0;
+        PortRequest *reversed = 0;
+        while (list) {
+            PortRequest *nextReq = list->next;
+            list->next = reversed;
+            reversed = list;
+            list = nextReq;
+        }
+        pendingHead = reversed;
+    }
+    PortRequest *req = pendingHead;
+    if (req) {
+        pendingHead = req->next;
+        req->next = 0;
+    }
+    return req;
+}
@@ -0,0 +1,130 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+#include "SimPort.h"
+#include "FpgaEmulator.h"
+
+SimPort::SimPort(int numBoards, std::ostream &debugStream, unsigned long fwVersion, unsigned long hwVersion):
+    BasePort(0, debugStream), emulator(0), NumSimBoards(numBoards),
+    SimFirmwareVersion(fwVersion), SimHardwareVersion(hwVersion)
+{
+    Init();
+}
+
+bool SimPort::Init(void)
+{
+    memset(Node2Board, BoardIO::MAX_BOARDS, sizeof(Node2Board));
+
+    if ((NumSimBoards == 0) || (NumSimBoards > BoardIO::MAX_BOARDS)) {
+        outStr << "SimPort::Init: invalid number of boards: " << NumSimBoards << std::endl;
+        return false;
+    }
+
+    emulator = new FpgaEmulator(outStr);
+    for (unsigned int bd = 0; bd < NumSimBoards; bd++) {
+        if (!emulator->AddBoard(bd, SimHardwareVersion, SimFirmwareVersion)) {
+            Cleanup();
+            return false;
+        }
+    }
+
+    bool ret = ScanNodes();
+    if (ret)
+        SetDefaultProtocol();
+    return ret;
+}
+
+SimPort::~SimPort()
+{
+    Cleanup();
+}
+
+void SimPort::Cleanup(void)
+{
+    delete emulator;
+    emulator = 0;
+}
+
+unsigned int SimPort::GetBusGeneration(void) const
+{
+    return FwBusGeneration;
+}
+
+void SimPort::UpdateBusGeneration(unsigned int gen)
+{
+    FwBusGeneration = gen;
+}
+
+void SimPort::CheckEmulatorGeneration(void)
+{
+    unsigned int gen = emulator->GetBusGeneration();
+    if (gen != newFwBusGeneration) {
+        outStr << "Firewire bus reset, emulator = " << gen << ", PC = " << FwBusGeneration << std::endl;
+        newFwBusGeneration = gen;
+    }
+}
+
+nodeid_t SimPort::InitNodes(void)
+{
+    FwBusGeneration = emulator->GetBusGeneration();
+    newFwBusGeneration = FwBusGeneration;
+    HubBoard = emulator->GetHubBoard();
+    return static_cast<nodeid_t>(emulator->GetNumBoards());
+}
+
+bool SimPort::WriteBroadcastOutput(quadlet_t *buffer, unsigned int size)
+{
+    return WriteBlockNode(FW_NODE_BROADCAST, 0, buffer, size);
+}
+
+bool SimPort::WriteBroadcastReadRequest(unsigned int seq)
+{
+    quadlet_t bcReqData = (seq << 16) | BoardInUseMask_;
+    return WriteQuadlet(FW_NODE_BROADCAST, 0x1800, bcReqData);
+}
+
+bool SimPort::ReadQuadletNode(nodeid_t node, nodeaddr_t addr, quadlet_t &data, unsigned char)
+{
+    if (!emulator)
+        return false;
+    CheckEmulatorGeneration();
+    return emulator->ReadQuadlet(node, addr, data);
+}
+
+bool SimPort::WriteQuadletNode(nodeid_t node, nodeaddr_t addr, quadlet_t data, unsigned char)
+{
+    if (!emulator)
+        return false;
+    return emulator->WriteQuadlet(node, addr, data);
+}
+
+bool SimPort::ReadBlockNode(nodeid_t node, nodeaddr_t addr, quadlet_t *rdata,
+                            unsigned int nbytes, unsigned char)
+{
+    if (!emulator)
+        return false;
+    CheckEmulatorGeneration();
+    rtRead = true;   // for debugging
+    return emulator->ReadBlock(node, addr, rdata, nbytes);
+}
+
+bool SimPort::WriteBlockNode(nodeid_t node, nodeaddr_t addr, quadlet_t *wdata,
+                             unsigned int nbytes, unsigned char)
+{
+    if (!emulator)
+        return false;
+    rtWrite = true;   // for debugging
+    return emulator->WriteBlock(node, addr, wdata, nbytes);
+}
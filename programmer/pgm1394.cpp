@@ -18,7 +18,7 @@
 #if Amp1394_HAS_RAW1394
 #include "FirewirePort.h"
 #endif
-#if Amp1394_HAS_PCAP
+#if Amp1394_HAS_ETH_RAW
 #include "EthRawPort.h"
 #endif
 #include "EthUdpPort.h"
@@ -541,11 +541,11 @@ int main(int argc, char** argv)
         Port->SetProtocol(BasePort::PROTOCOL_SEQ_RW);  // PK TEMP
     }
     else if (desiredPort == BasePort::PORT_ETH_RAW) {
-#if Amp1394_HAS_PCAP
+#if Amp1394_HAS_ETH_RAW
         Port = new EthRawPort(port, std::cerr);
         Port->SetProtocol(BasePort::PROTOCOL_SEQ_RW);  // PK TEMP
 #else
-        std::cerr << "Raw Ethernet not available (set Amp1394_HAS_PCAP in CMake)" << std::endl;
+        std::cerr << "Raw Ethernet not available (set Amp1394_HAS_PCAP or Amp1394_HAS_PACKET_MMAP in CMake)" << std::endl;
         return -1;
 #endif
     }
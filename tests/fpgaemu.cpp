@@ -0,0 +1,215 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+/****************************************************************************************
+ *
+ * This program emulates a set of FPGA boards connected to the PC via the Ethernet/FireWire
+ * bridge (UDP), so that the library and test programs can be used without hardware, e.g.:
+ *
+ *     fpgaemu -n4 -f8 &
+ *     qladisp -pudp:127.0.0.1 0 1
+ *
+ * Usage: fpgaemu [-nN] [-fF] [-hHW] [-bB] [-aIP] [-uPORT] [-tUSEC] [-s]
+ *        where N is the number of boards (default 4)
+ *              F is the firmware version, 6-8 (default 8)
+ *              HW is the hardware type: QLA1, DQLA or dRA1 (default QLA1)
+ *              B is the board id of the first (hub) board (default 0); other boards follow
+ *              IP is the server IP address (default 127.0.0.1)
+ *              PORT is the UDP port (default 1394)
+ *              USEC is the simulated time (us) for each board to send data to the hub (default 5)
+ *              -s causes the hub to return stale data if read before USEC has elapsed for each board
+ *
+ *****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "FpgaEmulator.h"
+#include "EthUdpPort.h"
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void SignalHandler(int)
+{
+    stopRequested = 1;
+}
+
+// Open UDP socket bound to the specified address and port; returns -1 on error
+static int OpenSocket(uint32_t addr, unsigned short port)
+{
+    int fd = socket(PF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to open UDP socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    serverAddr.sin_addr.s_addr = addr;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&serverAddr), sizeof(serverAddr)) != 0) {
+        std::cerr << "Failed to bind to " << EthUdpPort::IP_String(addr) << ":" << port
+                  << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+    unsigned int numBoards = 4;
+    unsigned long fwVersion = 8;
+    std::string hwString("QLA1");
+    unsigned int firstBoard = 0;
+    std::string serverIP("127.0.0.1");
+    unsigned int udpPort = 1394;
+    double updateTime_us = 5.0;
+    bool strictTiming = false;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            if (argv[i][1] == 'n')
+                numBoards = atoi(argv[i]+2);
+            else if (argv[i][1] == 'f')
+                fwVersion = atoi(argv[i]+2);
+            else if (argv[i][1] == 'h')
+                hwString = argv[i]+2;
+            else if (argv[i][1] == 'b')
+                firstBoard = atoi(argv[i]+2);
+            else if (argv[i][1] == 'a')
+                serverIP = argv[i]+2;
+            else if (argv[i][1] == 'u')
+                udpPort = atoi(argv[i]+2);
+            else if (argv[i][1] == 't')
+                updateTime_us = atof(argv[i]+2);
+            else if (argv[i][1] == 's')
+                strictTiming = true;
+            else {
+                std::cerr << "Usage: fpgaemu [-nN] [-fF] [-hHW] [-bB] [-aIP] [-uPORT] [-tUSEC] [-s]" << std::endl
+                          << "       where N is the number of boards (default 4)" << std::endl
+                          << "             F is the firmware version, 6-8 (default 8)" << std::endl
+                          << "             HW is the hardware type: QLA1, DQLA or dRA1 (default QLA1)" << std::endl
+                          << "             B is the board id of the first (hub) board (default 0)" << std::endl
+                          << "             IP is the server IP address (default 127.0.0.1)" << std::endl
+                          << "             PORT is the UDP port (default 1394)" << std::endl
+                          << "             USEC is the simulated board-to-hub transfer time in us (default 5)" << std::endl
+                          << "             -s returns stale hub data if read before transfer time elapsed" << std::endl;
+                return 0;
+            }
+        }
+    }
+
+    unsigned long hwVersion = FpgaEmulator::ParseHardwareVersion(hwString);
+    if (hwVersion == 0) {
+        std::cerr << "Invalid hardware type: " << hwString << std::endl;
+        return -1;
+    }
+    if ((numBoards == 0) || (firstBoard+numBoards > BoardIO::MAX_BOARDS)) {
+        std::cerr << "Invalid number of boards: " << numBoards << " (starting at board "
+                  << firstBoard << ")" << std::endl;
+        return -1;
+    }
+
+    FpgaEmulator emulator(std::cerr);
+    for (unsigned int bd = firstBoard; bd < firstBoard+numBoards; bd++) {
+        if (!emulator.AddBoard(bd, hwVersion, fwVersion))
+            return -1;
+    }
+    emulator.SetBoardUpdateTime(updateTime_us*1.0e-6, strictTiming);
+
+    // Socket for requests sent to the server address, and another for requests sent to the
+    // broadcast address (computed as in EthUdpPort).
+    uint32_t addr = EthUdpPort::IP_ULong(serverIP);
+    unsigned char firstByte = static_cast<unsigned char>(addr&0x000000ff);
+    uint32_t addrBroadcast;
+    if (firstByte < 128)
+        addrBroadcast = addr|0xffffff00;
+    else if (firstByte < 192)
+        addrBroadcast = addr|0xffff0000;
+    else if (firstByte < 224)
+        addrBroadcast = addr|0xff000000;
+    else
+        addrBroadcast = 0xffffffff;
+
+    int sockFD = OpenSocket(addr, static_cast<unsigned short>(udpPort));
+    if (sockFD < 0)
+        return -1;
+    int bcastFD = OpenSocket(addrBroadcast, static_cast<unsigned short>(udpPort));
+    if (bcastFD < 0)
+        std::cerr << "Warning: Ethernet broadcast requests will not be received" << std::endl;
+
+    signal(SIGINT, SignalHandler);
+    signal(SIGTERM, SignalHandler);
+
+    std::cout << "Emulating " << numBoards << " " << hwString << " board(s), firmware Rev "
+              << fwVersion << ", at " << serverIP << ":" << udpPort << " (Ctrl-C to exit)" << std::endl;
+
+    unsigned char request[FW_CTRL_SIZE+FW_BWRITE_HEADER_SIZE+MAX_POSSIBLE_DATA_SIZE+FW_CRC_SIZE];
+    unsigned char response[FW_BRESPONSE_HEADER_SIZE+MAX_POSSIBLE_DATA_SIZE+FW_CRC_SIZE+FW_EXTRA_SIZE];
+    while (!stopRequested) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(sockFD, &readfds);
+        int maxFD = sockFD;
+        if (bcastFD >= 0) {
+            FD_SET(bcastFD, &readfds);
+            if (bcastFD > maxFD) maxFD = bcastFD;
+        }
+        timeval timeout = { 0, 100000 };   // to check stopRequested
+        int retval = select(maxFD+1, &readfds, 0, 0, &timeout);
+        if (retval < 0) {
+            if (errno != EINTR)
+                std::cerr << "select failed: " << strerror(errno) << std::endl;
+            continue;
+        }
+        int fds[2] = { sockFD, bcastFD };
+        for (unsigned int k = 0; k < 2; k++) {
+            if ((fds[k] < 0) || !FD_ISSET(fds[k], &readfds))
+                continue;
+            sockaddr_in fromAddr;
+            socklen_t fromLen = sizeof(fromAddr);
+            ssize_t nRecv = recvfrom(fds[k], request, sizeof(request), 0,
+                                     reinterpret_cast<sockaddr *>(&fromAddr), &fromLen);
+            if (nRecv <= 0)
+                continue;
+            size_t nResp = emulator.ProcessPacket(request, nRecv, response, sizeof(response));
+            // Always respond from the server address (i.e., the one to which the PC is connected)
+            if (nResp > 0)
+                sendto(sockFD, response, nResp, 0, reinterpret_cast<sockaddr *>(&fromAddr), fromLen);
+        }
+    }
+
+    std::cout << std::endl << "Processed " << emulator.GetNumPackets() << " packets ("
+              << emulator.GetNumPacketErrors() << " errors)" << std::endl;
+    if (bcastFD >= 0)
+        close(bcastFD);
+    close(sockFD);
+    return 0;
+}
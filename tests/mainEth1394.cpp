@@ -16,7 +16,7 @@
 #elif Amp1394_HAS_EMIO
 #include "ZynqEmioPort.h"
 #endif
-#if Amp1394_HAS_PCAP
+#if Amp1394_HAS_ETH_RAW
 #include "EthRawPort.h"
 #endif
 #include "EthUdpPort.h"
@@ -1147,9 +1147,9 @@ int main(int argc, char **argv)
         std::cout << "Creating Ethernet UDP port, IP address = " << IPaddr << std::endl;
         EthPort = new EthUdpPort(port, IPaddr, std::cout);
     }
-#if Amp1394_HAS_PCAP
+#if Amp1394_HAS_ETH_RAW
     else if (desiredPort == BasePort::PORT_ETH_RAW) {
-        std::cout << "Creating Ethernet raw (PCAP) port" << std::endl;
+        std::cout << "Creating Ethernet raw port" << std::endl;
         EthPort = new EthRawPort(port, std::cout);
     }
 #endif
@@ -0,0 +1,409 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-    */
+/* ex: set filetype=cpp softtabstop=4 shiftwidth=4 tabstop=4 cindent expandtab: */
+
+/*
+  (C) Copyright 2024 Johns Hopkins University (JHU), All Rights Reserved.
+
+--- begin cisst license - do not edit ---
+
+This software is provided "as is" under an open source license, with
+no warranty.  The complete license can be found in license.txt and
+http://www.cisst.org/cisst/license.txt.
+
+--- end cisst license ---
+*/
+
+/****************************************************************************************
+ *
+ * This program benchmarks the real-time I/O methods used by a control loop (ReadAllBoards,
+ * ReadAllBoardsBroadcast, WriteAllBoards and WriteAllBoardsBroadcast, as well as a complete
+ * read/write cycle) for each protocol and for 1 to N boards. It can be run on any port,
+ * including the emulated boards, for example:
+ *
+ *     qlabench -psim:16 -fcsv > results.csv
+ *     qlabench -pudp:127.0.0.1 -fjson      (with fpgaemu running)
+ *
+ * Usage: qlabench [-pP] [-nN] [-bB] [-s] [-a] [-l] [-fFMT] [-hH] [<board-num> ...]
+ *        where P is the port (default is BasePort::DefaultPort, also fw:P, eth:P, udp:IP, sim:N)
+ *              N is the number of measured iterations per test (default 1000)
+ *              B is the maximum number of boards (default is all boards on the bus)
+ *              -s only measures with all (or B) boards, rather than 1 to B boards
+ *              -a uses the adaptive wait for broadcast reads (BasePort::BC_WAIT_ADAPTIVE)
+ *              -l prints the latency of each stage (BasePort::GetLatencySnapshot) to stderr
+ *              FMT is the output format: text (default), csv or json
+ *              H is a list of additional supported hardware versions
+ *        If board numbers are specified, only those boards are used (in the specified order).
+ *
+ * Results are written to stdout; messages from the port are written to stderr. Latencies are
+ * in microseconds and cycles/sec is the number of iterations divided by the total elapsed time.
+ *
+ *****************************************************************************************/
+
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <Amp1394/AmpIORevision.h>
+#include "PortFactory.h"
+#include "AmpIO.h"
+#include "Amp1394Time.h"
+
+enum OutputFormat { FORMAT_TEXT, FORMAT_CSV, FORMAT_JSON };
+
+enum BenchOp { OP_READ, OP_READ_BC, OP_WRITE, OP_WRITE_BC, OP_CYCLE, OP_NUM };
+
+const char *OpName[OP_NUM] = { "ReadAllBoards", "ReadAllBoardsBroadcast",
+                               "WriteAllBoards", "WriteAllBoardsBroadcast",
+                               "ReadWriteCycle" };
+
+struct BenchResult {
+    unsigned int numBoards;
+    BasePort::ProtocolType protocol;
+    BenchOp op;
+    unsigned long iterations;
+    unsigned long errors;
+    double mean;          // all times in seconds (successful iterations only)
+    double p50;
+    double p99;
+    double p999;
+    double max;
+    double cyclesPerSec;
+};
+
+// Returns the value at the specified fraction (0-1) of the sorted data (nearest-rank method)
+static double Percentile(const std::vector<double> &sorted, double frac)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t idx = static_cast<size_t>(ceil(frac*sorted.size()));
+    if (idx > 0) idx--;
+    if (idx >= sorted.size()) idx = sorted.size()-1;
+    return sorted[idx];
+}
+
+static bool RunOp(BasePort *port, BenchOp op)
+{
+    bool ret = false;
+    switch (op) {
+        case OP_READ:     ret = port->ReadAllBoards(); break;
+        case OP_READ_BC:  ret = port->ReadAllBoardsBroadcast(); break;
+        case OP_WRITE:    ret = port->WriteAllBoards(); break;
+        case OP_WRITE_BC: ret = port->WriteAllBoardsBroadcast(); break;
+        case OP_CYCLE:    ret = port->ReadAllBoards();
+                          ret &= port->WriteAllBoards();
+                          break;
+        default:          break;
+    }
+    return ret;
+}
+
+static BenchResult RunTest(BasePort *port, unsigned int numBoards, BenchOp op, unsigned long numIter,
+                           bool showStages)
+{
+    BenchResult result;
+    result.numBoards = numBoards;
+    result.protocol = port->GetProtocol();
+    result.op = op;
+    result.iterations = numIter;
+    result.errors = 0;
+
+    // Warm up (e.g., caches, ARP, adaptive wait estimate)
+    unsigned long numWarmup = std::max(numIter/10, 10UL);
+    for (unsigned long i = 0; i < numWarmup; i++)
+        RunOp(port, op);
+
+    port->ResetLatencyStats();
+    std::vector<double> times;
+    times.reserve(numIter);
+    double sum = 0.0;
+    double errorTime = 0.0;
+    double startAll = Amp1394_GetTime();
+    for (unsigned long i = 0; i < numIter; i++) {
+        double startTime = Amp1394_GetTime();
+        bool ok = RunOp(port, op);
+        double deltaTime = Amp1394_GetTime()-startTime;
+        // Failed iterations are only counted as errors (they do not contribute to the timing)
+        if (!ok) {
+            result.errors++;
+            errorTime += deltaTime;
+            continue;
+        }
+        times.push_back(deltaTime);
+        sum += deltaTime;
+    }
+    double totalTime = Amp1394_GetTime()-startAll-errorTime;
+
+    if (showStages) {
+        BasePort::LatencySnapshot snap;
+        port->GetLatencySnapshot(snap);
+        std::cerr << OpName[op] << " (" << numBoards << " boards, " << port->GetProtocolString() << "): ";
+        snap.Print(std::cerr);
+    }
+
+    std::sort(times.begin(), times.end());
+    result.mean = times.empty() ? 0.0 : sum/times.size();
+    result.p50 = Percentile(times, 0.50);
+    result.p99 = Percentile(times, 0.99);
+    result.p999 = Percentile(times, 0.999);
+    result.max = times.empty() ? 0.0 : times.back();
+    result.cyclesPerSec = (!times.empty() && (totalTime > 0.0)) ? times.size()/totalTime : 0.0;
+    return result;
+}
+
+// Short protocol name (as accepted by BasePort::ParseProtocol), used for text output
+static const char *ProtocolAbbrev(BasePort::ProtocolType protocol)
+{
+    if (protocol == BasePort::PROTOCOL_SEQ_RW)
+        return "srw";
+    else if (protocol == BasePort::PROTOCOL_SEQ_R_BC_W)
+        return "srbw";
+    return "bqrw";
+}
+
+static void PrintHeader(OutputFormat format, const BasePort *port, unsigned long numIter)
+{
+    if (format == FORMAT_CSV) {
+        std::cout << "version,port,boards,protocol,operation,iterations,errors,"
+                  << "mean_us,p50_us,p99_us,p99.9_us,max_us,cycles_per_sec" << std::endl;
+    }
+    else if (format == FORMAT_JSON) {
+        std::cout << "{" << std::endl
+                  << "  \"version\": \"" << Amp1394_VERSION << "\"," << std::endl
+                  << "  \"port\": \"" << port->GetPortTypeString() << "\"," << std::endl
+                  << "  \"iterations\": " << numIter << "," << std::endl
+                  << "  \"results\": [" << std::endl;
+    }
+    else {
+        std::cout << "Amp1394 " << Amp1394_VERSION << ", " << port->GetPortTypeString()
+                  << " port, " << numIter << " iterations per test (times in us)" << std::endl
+                  << "boards protocol operation                 errors      mean       p50"
+                  << "       p99     p99.9       max  cycles/sec" << std::endl;
+    }
+}
+
+static void PrintResult(OutputFormat format, const BasePort *port, const BenchResult &res, bool first)
+{
+    std::string protStr = BasePort::ProtocolString(res.protocol);
+    std::ostringstream line;
+    line.setf(std::ios::fixed);
+    line.precision(3);
+    // If every iteration failed, there is no timing data (empty, null or n/a)
+    bool noData = (res.errors >= res.iterations);
+    if (format == FORMAT_CSV) {
+        line << Amp1394_VERSION << "," << port->GetPortTypeString() << "," << res.numBoards << ","
+             << protStr << "," << OpName[res.op] << "," << res.iterations << "," << res.errors << ",";
+        if (noData)
+            line << ",,,,,";
+        else
+            line << res.mean*1.0e6 << "," << res.p50*1.0e6 << "," << res.p99*1.0e6 << ","
+                 << res.p999*1.0e6 << "," << res.max*1.0e6 << "," << res.cyclesPerSec;
+    }
+    else if (format == FORMAT_JSON) {
+        if (!first)
+            std::cout << "," << std::endl;
+        line << "    { \"boards\": " << res.numBoards << ", \"protocol\": \"" << protStr
+             << "\", \"operation\": \"" << OpName[res.op] << "\", \"iterations\": " << res.iterations
+             << ", \"errors\": " << res.errors;
+        if (noData)
+            line << ", \"mean_us\": null, \"p50_us\": null, \"p99_us\": null, \"p99.9_us\": null"
+                 << ", \"max_us\": null, \"cycles_per_sec\": null }";
+        else
+            line << ", \"mean_us\": " << res.mean*1.0e6
+                 << ", \"p50_us\": " << res.p50*1.0e6 << ", \"p99_us\": " << res.p99*1.0e6
+                 << ", \"p99.9_us\": " << res.p999*1.0e6 << ", \"max_us\": " << res.max*1.0e6
+                 << ", \"cycles_per_sec\": " << res.cyclesPerSec << " }";
+        std::cout << line.str();
+        return;
+    }
+    else {
+        line.width(6);  line << res.numBoards << " ";
+        line.width(8);  line << std::left << ProtocolAbbrev(res.protocol) << " ";
+        line.width(25); line << OpName[res.op] << std::right;
+        line.width(7);  line << res.errors;
+        if (noData) {
+            for (unsigned int j = 0; j < 5; j++) {
+                line.width(10); line << "n/a";
+            }
+            line.width(12); line << "n/a";
+            std::cout << line.str() << std::endl;
+            return;
+        }
+        line.width(10); line << res.mean*1.0e6;
+        line.width(10); line << res.p50*1.0e6;
+        line.width(10); line << res.p99*1.0e6;
+        line.width(10); line << res.p999*1.0e6;
+        line.width(10); line << res.max*1.0e6;
+        line.precision(1);
+        line.width(12); line << res.cyclesPerSec;
+    }
+    std::cout << line.str() << std::endl;
+}
+
+static void PrintFooter(OutputFormat format)
+{
+    if (format == FORMAT_JSON)
+        std::cout << std::endl << "  ]" << std::endl << "}" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+    std::string portDescription = BasePort::DefaultPort();
+    std::string hardwareList;
+    unsigned long numIter = 1000;
+    unsigned int maxBoards = BoardIO::MAX_BOARDS;
+    bool sweep = true;
+    bool adaptiveWait = false;
+    bool showStages = false;
+    OutputFormat format = FORMAT_TEXT;
+    std::vector<unsigned char> boardNums;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] == '-') {
+            if (argv[i][1] == 'p')
+                portDescription = argv[i]+2;
+            else if (argv[i][1] == 'n')
+                numIter = strtoul(argv[i]+2, 0, 10);
+            else if (argv[i][1] == 'b')
+                maxBoards = atoi(argv[i]+2);
+            else if (argv[i][1] == 's')
+                sweep = false;
+            else if (argv[i][1] == 'a')
+                adaptiveWait = true;
+            else if (argv[i][1] == 'l')
+                showStages = true;
+            else if (argv[i][1] == 'h')
+                hardwareList = argv[i]+2;
+            else if (argv[i][1] == 'f') {
+                std::string fmt(argv[i]+2);
+                if (fmt == "csv")
+                    format = FORMAT_CSV;
+                else if (fmt == "json")
+                    format = FORMAT_JSON;
+                else if (fmt == "text")
+                    format = FORMAT_TEXT;
+                else {
+                    std::cerr << "Invalid output format: " << fmt << std::endl;
+                    return -1;
+                }
+            }
+            else {
+                std::cerr << "Usage: qlabench [-pP] [-nN] [-bB] [-s] [-a] [-l] [-fFMT] [-hH] [<board-num> ...]" << std::endl
+                          << "       where P = port (default " << BasePort::DefaultPort() << ")" << std::endl
+                          << "                 can also specify -pfw[:P], -peth:P, -pudp[:xx.xx.xx.xx] or -psim[:N]" << std::endl
+                          << "             N = number of iterations per test (default 1000)" << std::endl
+                          << "             B = maximum number of boards (default all)" << std::endl
+                          << "            -s only measures with all boards (no sweep from 1 board)" << std::endl
+                          << "            -a uses adaptive wait for broadcast read" << std::endl
+                          << "            -l prints latency of each stage (send, wait, receive, process)" << std::endl
+                          << "             FMT = output format: text, csv or json (default text)" << std::endl
+                          << "             H = additional supported hardware versions" << std::endl;
+                return 0;
+            }
+        }
+        else {
+            int bnum = atoi(argv[i]);
+            if ((bnum >= 0) && (bnum < BoardIO::MAX_BOARDS))
+                boardNums.push_back(static_cast<unsigned char>(bnum));
+            else
+                std::cerr << "Invalid board number: " << argv[i] << std::endl;
+        }
+    }
+    if (numIter == 0) {
+        std::cerr << "Invalid number of iterations" << std::endl;
+        return -1;
+    }
+
+    BasePort::AddHardwareVersionStringList(hardwareList);
+
+    // Messages from the port (e.g., SetProtocol) are collected and printed to stderr,
+    // so that stdout only contains the results
+    std::stringstream debugStream(std::stringstream::out|std::stringstream::in);
+    BasePort *port = PortFactory(portDescription.c_str(), debugStream);
+    std::cerr << debugStream.str();
+    debugStream.str("");
+    if (!port) {
+        std::cerr << "Failed to create port using: " << portDescription << std::endl;
+        return -1;
+    }
+    if (!port->IsOK()) {
+        std::cerr << "Failed to initialize " << port->GetPortTypeString() << std::endl;
+        delete port;
+        return -1;
+    }
+
+    // If no boards specified, use all boards on the bus
+    if (boardNums.empty()) {
+        for (unsigned int bd = 0; bd < BoardIO::MAX_BOARDS; bd++) {
+            if (port->GetNodeId(bd) < BasePort::MAX_NODES)
+                boardNums.push_back(static_cast<unsigned char>(bd));
+        }
+    }
+    if (boardNums.size() > maxBoards)
+        boardNums.resize(maxBoards);
+    if (boardNums.empty()) {
+        std::cerr << "No boards found" << std::endl;
+        delete port;
+        return -1;
+    }
+
+    if (adaptiveWait)
+        port->SetBroadcastWaitMode(BasePort::BC_WAIT_ADAPTIVE);
+
+    std::vector<AmpIO *> boardList;
+    for (size_t k = 0; k < boardNums.size(); k++)
+        boardList.push_back(new AmpIO(boardNums[k]));
+
+    const BasePort::ProtocolType protocols[3] = { BasePort::PROTOCOL_SEQ_RW,
+                                                  BasePort::PROTOCOL_SEQ_R_BC_W,
+                                                  BasePort::PROTOCOL_BC_QRW };
+
+    PrintHeader(format, port, numIter);
+    bool first = true;
+    unsigned int numBoards = sweep ? 1 : static_cast<unsigned int>(boardList.size());
+    for (; numBoards <= boardList.size(); numBoards++) {
+        for (unsigned int bd = 0; bd < numBoards; bd++) {
+            if (!port->GetBoard(boardList[bd]->GetBoardId()))
+                port->AddBoard(boardList[bd]);
+        }
+        // Broadcast methods require broadcast-capable firmware, which is indicated by
+        // support for the broadcast protocols
+        bool bcCapable = port->SetProtocol(BasePort::PROTOCOL_BC_QRW);
+        for (unsigned int p = 0; p < 3; p++) {
+            if (!port->SetProtocol(protocols[p])) {
+                std::cerr << "Skipping protocol " << BasePort::ProtocolString(protocols[p])
+                          << " (not supported)" << std::endl;
+                debugStream.str("");
+                continue;
+            }
+            for (unsigned int op = 0; op < OP_NUM; op++) {
+                if (((op == OP_READ_BC) || (op == OP_WRITE_BC)) && !bcCapable)
+                    continue;
+                debugStream.clear();
+                debugStream.str("");
+                BenchResult res = RunTest(port, numBoards, static_cast<BenchOp>(op), numIter, showStages);
+                if (res.errors > 0) {
+                    // Print first message from port
+                    std::string msg;
+                    std::getline(debugStream, msg);
+                    std::cerr << "Errors for " << OpName[op] << " (" << numBoards << " boards, "
+                              << BasePort::ProtocolString(protocols[p]) << "): " << msg << std::endl;
+                }
+                PrintResult(format, port, res, first);
+                first = false;
+            }
+        }
+    }
+    PrintFooter(format);
+
+    for (size_t k = 0; k < boardList.size(); k++) {
+        port->RemoveBoard(boardList[k]->GetBoardId());
+        delete boardList[k];
+    }
+    delete port;
+    return 0;
+}